@@ -10,6 +10,12 @@ Window {
     visible: true
     title: "ResearchManager"
 
+    // debug: dump per-statement SQL timings next to research.db
+    Shortcut {
+        sequence: "Ctrl+Shift+D"
+        onActivated: appManager.dumpSqlStats()
+    }
+
     Workspace {
         id: mainScreen
         property string projectName: ""
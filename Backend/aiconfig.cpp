@@ -1,30 +1,36 @@
 #include "aiconfig.h"
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
 #include <QDebug>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QFile>
 #include <QFileInfo>
 #include <QDir>
-#include <QRegularExpression>
+#include "pdfrenamejob.h"
+#include "airesponsecache.h"
 
-#ifdef HAS_QT_PDF
-#include <QPdfDocument>
-#include <QPdfSelection>
-#endif
-
-AiConfig::AiConfig(DbmPtr configDb, QObject *parent)
+AiConfig::AiConfig(DbmPtr configDb, QNetworkAccessManager *network, QObject *parent)
     : QObject(parent)
     , m_configDb(configDb)
-    , m_networkManager(new QNetworkAccessManager(this))
+    , m_networkManager(network ? network : new QNetworkAccessManager(this))
+    , m_responseCache(std::make_unique<project::AiResponseCache>(configDb))
+    , m_scheduler(new project::AiRequestScheduler(m_networkManager, this))
+    , m_renameJob(new project::PdfRenameJob(m_scheduler, this))
+    , m_endpoint(gemini::defaultEndpoint())
     , m_isLoading(false)
-    , m_currentRenameReply(nullptr)
+    , m_streaming(true)
+    , m_streamRequest(0)
 {
-    connect(m_networkManager, &QNetworkAccessManager::finished, 
-            this, &AiConfig::onNetworkReply);
-    
+    m_renameJob->setCache(m_responseCache.get());
+
+    // a batch keeps the rename buttons busy until its last file is done
+    connect(m_renameJob, &project::PdfRenameJob::runningChanged, this, &AiConfig::isLoadingChanged);
+    connect(m_renameJob, &project::PdfRenameJob::fileRenamed, this, [this](const QString &oldPath, const QString &newPath) {
+        emit pdfRenameCompleted(true, oldPath, newPath);
+    });
+    connect(m_renameJob, &project::PdfRenameJob::fileFailed, this, [this](const QString &path, const QString &error) {
+        emit pdfRenameError(QFileInfo(path).fileName() + ": " + error);
+    });
+
     // Ensure table exists
     createTableIfNotExists();
     
@@ -36,6 +42,21 @@ AiConfig::~AiConfig()
 {
 }
 
+bool AiConfig::isLoading() const
+{
+    return m_isLoading || m_renameJob->isRunning();
+}
+
+QObject *AiConfig::renameJob() const
+{
+    return m_renameJob;
+}
+
+void AiConfig::setEndpoint(const QUrl &endpoint)
+{
+    m_endpoint = endpoint;
+}
+
 void AiConfig::createTableIfNotExists()
 {
     if (!m_configDb) {
@@ -67,11 +88,17 @@ void AiConfig::loadConfig()
         "Parse the following text and extract calendar events with dates, times, and descriptions.");
     m_taskPrompt = getConfigValue("task_prompt", 
         "Parse the following text and extract task items with priorities and deadlines.");
+    m_streaming = getConfigValue("gemini_streaming", "true") == "true";
+    // the free tier allows 15 requests per minute for flash models
+    const int perMinute = getConfigValue("gemini_requests_per_minute", "15").toInt();
+    m_scheduler->setRateLimit(perMinute, qMax(1, perMinute / 3));
     
     emit geminiApiKeyChanged();
     emit pdfRenamePromptChanged();
     emit calendarPromptChanged();
     emit taskPromptChanged();
+    emit streamingChanged();
+    emit requestsPerMinuteChanged();
     
     qInfo() << "[AiConfig] Configuration loaded";
 }
@@ -84,6 +111,8 @@ bool AiConfig::saveConfig()
     success &= updateConfigValue("pdf_rename_prompt", m_pdfRenamePrompt);
     success &= updateConfigValue("calendar_prompt", m_calendarPrompt);
     success &= updateConfigValue("task_prompt", m_taskPrompt);
+    success &= updateConfigValue("gemini_streaming", m_streaming ? "true" : "false");
+    success &= updateConfigValue("gemini_requests_per_minute", QString::number(requestsPerMinute()));
     
     if (success) {
         emit configSaved();
@@ -102,16 +131,21 @@ QString AiConfig::getConfigValue(const QString &key, const QString &defaultValue
         return defaultValue;
     }
 
-    QString sql = QString("SELECT value FROM AiConfig WHERE key = '%1'").arg(key);
-    QStringList result = m_configDb->queryRow(sql);
-    
-    if (result.isEmpty()) {
+    bool found = false;
+    QString value;
+    m_configDb->forEachRow<QString>("SELECT value FROM AiConfig WHERE key = ?", {key},
+                                    [&](const QString& stored) {
+        value = stored;
+        found = true;
+    });
+
+    if (!found) {
         // Insert default value
         updateConfigValue(key, defaultValue);
         return defaultValue;
     }
     
-    return result.first();
+    return value;
 }
 
 bool AiConfig::updateConfigValue(const QString &key, const QString &value)
@@ -127,14 +161,14 @@ bool AiConfig::updateConfigValue(const QString &key, const QString &value)
     
     // return m_configDb->updateDB(sql);
 
-    auto query = m_configDb->getBinder(
+    const auto query = m_configDb->statement(
         "INSERT OR REPLACE INTO AiConfig (key, value) "
         "VALUES (:key, :value)"
         );
 
-    query.bindValue(":key", key);
-    query.bindValue(":value", value.toHtmlEscaped().replace("'", "''"));
-    return query.exec();
+    query->bindValue(":key", key);
+    query->bindValue(":value", value.toHtmlEscaped().replace("'", "''"));
+    return query->exec();
 }
 
 void AiConfig::setGeminiApiKey(const QString &key)
@@ -173,6 +207,29 @@ void AiConfig::setTaskPrompt(const QString &prompt)
     }
 }
 
+void AiConfig::setStreaming(bool streaming)
+{
+    if (m_streaming != streaming) {
+        m_streaming = streaming;
+        updateConfigValue("gemini_streaming", streaming ? "true" : "false");
+        emit streamingChanged();
+    }
+}
+
+int AiConfig::requestsPerMinute() const
+{
+    return m_scheduler->requestsPerMinute();
+}
+
+void AiConfig::setRequestsPerMinute(int count)
+{
+    if (count > 0 && requestsPerMinute() != count) {
+        m_scheduler->setRateLimit(count, qMax(1, count / 3));
+        updateConfigValue("gemini_requests_per_minute", QString::number(count));
+        emit requestsPerMinuteChanged();
+    }
+}
+
 void AiConfig::testGemini(const QString &prompt)
 {
     if (m_geminiApiKey.isEmpty()) {
@@ -189,109 +246,143 @@ void AiConfig::testGemini(const QString &prompt)
         return;
     }
 
+    const QString cacheKey = project::AiResponseCache::key(gemini::defaultModel(), QString(), prompt);
+    const QString cached = m_responseCache->lookup(cacheKey);
+    if (!cached.isEmpty()) {
+        qInfo() << "[AiConfig] Answering test prompt from the response cache";
+        m_testResponse = cached;
+        emit testResponseChanged();
+        emit testCompleted(true, m_testResponse);
+        return;
+    }
+
     m_isLoading = true;
     emit isLoadingChanged();
 
-    // Construct Gemini API URL (using gemini-2.5-flash model)
-    QUrl url("https://generativelanguage.googleapis.com/v1beta/models/gemini-2.5-flash:generateContent");
-
-    // Create network request with API key in header
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    request.setRawHeader("x-goog-api-key", m_geminiApiKey.toUtf8());
-
-    // Build JSON request body
-    QJsonObject textPart;
-    textPart["text"] = prompt;
-
-    QJsonArray parts;
-    parts.append(textPart);
-
-    QJsonObject content;
-    content["parts"] = parts;
-
-    QJsonArray contents;
-    contents.append(content);
-
-    QJsonObject body;
-    body["contents"] = contents;
+    if (m_streaming) {
+        // a new test replaces one that is still streaming
+        if (m_streamRequest)
+            m_scheduler->cancel(m_streamRequest);
+        m_sseParser = gemini::SseParser();
+        m_streamError.clear();
+        m_testResponse.clear();
+
+        QNetworkRequest request = gemini::streamGenerateContentRequest(m_endpoint, gemini::defaultModel(), m_geminiApiKey);
+
+        qInfo() << "[AiConfig] Streaming test request from Gemini API";
+        m_streamRequest = m_scheduler->submit(request, gemini::generateContentBody(prompt),
+                                              project::AiRequestScheduler::Interactive,
+                                              [this, cacheKey](const project::AiRequestScheduler::Response &response) {
+                                                  onStreamFinished(response, cacheKey);
+                                              },
+                                              [this](QByteArrayView chunk) { onStreamData(chunk); });
+        return;
+    }
 
-    QJsonDocument doc(body);
-    QByteArray data = doc.toJson();
+    QNetworkRequest request = gemini::generateContentRequest(m_endpoint, gemini::defaultModel(), m_geminiApiKey);
 
     qInfo() << "[AiConfig] Sending test request to Gemini API";
-    m_networkManager->post(request, data);
+    m_scheduler->submit(request, gemini::generateContentBody(prompt), project::AiRequestScheduler::Interactive,
+                        [this, cacheKey](const project::AiRequestScheduler::Response &response) {
+                            onNetworkReply(response, cacheKey);
+                        });
 }
 
-void AiConfig::onNetworkReply(QNetworkReply *reply)
+void AiConfig::clearResponseCache()
+{
+    m_responseCache->clear();
+    qInfo() << "[AiConfig] Response cache cleared";
+}
+
+void AiConfig::onNetworkReply(const project::AiRequestScheduler::Response &response, const QString &cacheKey)
 {
-    // Check if this is a rename reply
-    if (reply == m_currentRenameReply) {
-        onRenameReply(reply);
-        return;
-    }
-    
     m_isLoading = false;
     emit isLoadingChanged();
 
-    if (reply->error() != QNetworkReply::NoError) {
-        m_testResponse = QString("Network Error: %1").arg(reply->errorString());
-        qWarning() << "[AiConfig] Network error:" << reply->errorString();
+    if (!response.ok()) {
+        m_testResponse = QString("Network Error: %1").arg(response.errorString);
+        qWarning() << "[AiConfig] Network error:" << response.errorString;
         emit testResponseChanged();
         emit testCompleted(false, m_testResponse);
-        reply->deleteLater();
         return;
     }
 
-    QByteArray responseData = reply->readAll();
-    QJsonDocument responseDoc = QJsonDocument::fromJson(responseData);
-
-    if (responseDoc.isNull()) {
-        m_testResponse = "Error: Failed to parse response";
-        qWarning() << "[AiConfig] Failed to parse JSON response";
+    QString error;
+    const QString text = gemini::responseText(response.body, &error);
+    if (!error.isEmpty()) {
+        m_testResponse = error;
+        qWarning() << "[AiConfig]" << error;
         emit testResponseChanged();
         emit testCompleted(false, m_testResponse);
-        reply->deleteLater();
-        return;
+    } else {
+        m_testResponse = text;
+        m_responseCache->store(cacheKey, gemini::defaultModel(), text);
+        qInfo() << "[AiConfig] Received response from Gemini";
+        emit testResponseChanged();
+        emit testCompleted(true, m_testResponse);
     }
+}
 
-    QJsonObject responseObj = responseDoc.object();
-
-    // Check for API error
-    if (responseObj.contains("error")) {
-        QJsonObject errorObj = responseObj["error"].toObject();
-        m_testResponse = QString("API Error: %1").arg(errorObj["message"].toString());
-        qWarning() << "[AiConfig] API error:" << m_testResponse;
+void AiConfig::onStreamData(QByteArrayView chunk)
+{
+    bool grown = false;
+    for (const QByteArray &event : m_sseParser.feed(chunk)) {
+        QString error;
+        const QString text = gemini::chunkText(event, &error);
+        if (!error.isEmpty())
+            m_streamError = error;
+        if (!text.isEmpty()) {
+            m_testResponse += text;
+            grown = true;
+        }
+    }
+    if (grown)
         emit testResponseChanged();
-        emit testCompleted(false, m_testResponse);
-        reply->deleteLater();
+}
+
+void AiConfig::onStreamFinished(const project::AiRequestScheduler::Response &response, const QString &cacheKey)
+{
+    m_streamRequest = 0;
+    m_isLoading = false;
+    emit isLoadingChanged();
+
+    if (!response.ok()) {
+        // the scheduler hands error bodies over whole
+        QString error;
+        gemini::responseText(response.body, &error);
+        if (!error.startsWith("API Error"))
+            error = QString("Network Error: %1").arg(response.errorString);
+        qWarning() << "[AiConfig] Streaming failed:" << error;
+        // keep whatever arrived before the stream broke off
+        setTestResponse(m_testResponse.isEmpty() ? error : m_testResponse + "\n\n" + error, false);
         return;
     }
 
-    // Extract response text from Gemini response
-    QJsonArray candidates = responseObj["candidates"].toArray();
-    if (!candidates.isEmpty()) {
-        QJsonObject firstCandidate = candidates[0].toObject();
-        QJsonObject content = firstCandidate["content"].toObject();
-        QJsonArray parts = content["parts"].toArray();
-        
-        if (!parts.isEmpty()) {
-            m_testResponse = parts[0].toObject()["text"].toString();
-            qInfo() << "[AiConfig] Received response from Gemini";
-            emit testResponseChanged();
-            emit testCompleted(true, m_testResponse);
-        } else {
-            m_testResponse = "Error: Empty response from API";
-            emit testResponseChanged();
-            emit testCompleted(false, m_testResponse);
-        }
+    onStreamData(response.body);
+    for (const QByteArray &event : m_sseParser.finish()) {
+        QString error;
+        m_testResponse += gemini::chunkText(event, &error);
+        if (!error.isEmpty())
+            m_streamError = error;
+    }
+
+    if (!m_streamError.isEmpty()) {
+        qWarning() << "[AiConfig]" << m_streamError;
+        setTestResponse(m_testResponse.isEmpty() ? m_streamError : m_testResponse + "\n\n" + m_streamError, false);
+    } else if (m_testResponse.isEmpty()) {
+        setTestResponse("Error: Empty response from API", false);
     } else {
-        m_testResponse = "Error: No candidates in response";
-        emit testResponseChanged();
-        emit testCompleted(false, m_testResponse);
+        m_responseCache->store(cacheKey, gemini::defaultModel(), m_testResponse);
+        qInfo() << "[AiConfig] Received streamed response from Gemini";
+        setTestResponse(m_testResponse, true);
     }
+}
 
-    reply->deleteLater();
+void AiConfig::setTestResponse(const QString &response, bool success)
+{
+    m_testResponse = response;
+    emit testResponseChanged();
+    emit testCompleted(success, m_testResponse);
 }
 
 void AiConfig::renamePdfWithAi(const QString &filePath)
@@ -309,185 +400,40 @@ void AiConfig::renamePdfWithAi(const QString &filePath)
         emit pdfRenameError("File is not a PDF: " + filePath);
         return;
     }
-    
-    if (m_geminiApiKey.isEmpty()) {
-        emit pdfRenameError("API key is not set. Please configure your Gemini API key.");
-        return;
-    }
-    
-    if (m_pdfRenamePrompt.isEmpty()) {
-        emit pdfRenameError("PDF rename prompt is not set. Please configure the prompt in AI Config.");
-        return;
-    }
-    
-    m_isLoading = true;
-    emit isLoadingChanged();
-    
-    // Store the file path for later use
-    m_pendingRenamePath = filePath;
-    
-    // Extract text from the first page of the PDF using Qt PDF
-    QString firstPageText;
-#ifdef HAS_QT_PDF
-    QPdfDocument pdfDoc;
-    QPdfDocument::Error loadError = pdfDoc.load(filePath);
-    
-    if (loadError == QPdfDocument::Error::None && pdfDoc.pageCount() > 0) {
-        // Get selection for the entire first page
-        QSizeF pageSize = pdfDoc.pagePointSize(0);
-        QPdfSelection selection = pdfDoc.getAllText(0);
-        firstPageText = selection.text();
-        
-        qInfo() << "[AiConfig] Extracted" << firstPageText.length() << "characters from first page";
-        
-        // Truncate if too long (to avoid API limits)
-        if (firstPageText.length() > 4000) {
-            firstPageText = firstPageText.left(4000) + "...";
-        }
-    } else {
-        qWarning() << "[AiConfig] Failed to load PDF or no pages found. Error:" << static_cast<int>(loadError);
-        firstPageText = "(Could not extract text from PDF)";
-    }
-#else
-    qWarning() << "[AiConfig] Qt PDF module not available - using filename only";
-    firstPageText = "(PDF text extraction not available - Qt6::Pdf module not installed)";
-#endif
-    
-    // Build the prompt with the extracted text
-    QString currentFileName = fileInfo.fileName();
-    QString fullPrompt = m_pdfRenamePrompt + 
-                         "\n\n--- PDF FIRST PAGE CONTENT ---\n" + 
-                         firstPageText +
-                         "\n--- END OF CONTENT ---\n\n"
-                         "Current filename: " + currentFileName + 
-                         "\n\nBased on the content above, please respond with ONLY the new filename "
-                         "(without path, with .pdf extension). "
-                         "Do not include any explanation or additional text.";
-    
-    // Construct Gemini API URL
-    QUrl url("https://generativelanguage.googleapis.com/v1beta/models/gemini-2.5-flash:generateContent");
-
-    // Create network request with API key in header
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    request.setRawHeader("x-goog-api-key", m_geminiApiKey.toUtf8());
-
-    // Build JSON request body
-    QJsonObject textPart;
-    textPart["text"] = fullPrompt;
-
-    QJsonArray parts;
-    parts.append(textPart);
 
-    QJsonObject content;
-    content["parts"] = parts;
-
-    QJsonArray contents;
-    contents.append(content);
-
-    QJsonObject body;
-    body["contents"] = contents;
-
-    QJsonDocument doc(body);
-    QByteArray data = doc.toJson();
-
-    qInfo() << "[AiConfig] Sending PDF rename request to Gemini API with first page content";
-    m_currentRenameReply = m_networkManager->post(request, data);
+    renamePdfsWithAi({filePath});
 }
 
-void AiConfig::onRenameReply(QNetworkReply *reply)
+void AiConfig::renamePdfsWithAi(const QStringList &filePaths)
 {
-    m_currentRenameReply = nullptr;
-    m_isLoading = false;
-    emit isLoadingChanged();
-    
-    QString oldPath = m_pendingRenamePath;
-    m_pendingRenamePath.clear();
-    
-    if (reply->error() != QNetworkReply::NoError) {
-        qWarning() << "[AiConfig] Network error during rename:" << reply->errorString();
-        emit pdfRenameError("Network Error: " + reply->errorString());
-        reply->deleteLater();
+    if (!canRename())
         return;
-    }
-
-    QByteArray responseData = reply->readAll();
-    QJsonDocument responseDoc = QJsonDocument::fromJson(responseData);
-
-    if (responseDoc.isNull()) {
-        qWarning() << "[AiConfig] Failed to parse rename response";
-        emit pdfRenameError("Failed to parse AI response");
-        reply->deleteLater();
-        return;
-    }
-
-    QJsonObject responseObj = responseDoc.object();
+    if (m_renameJob->addFiles(filePaths) == 0)
+        emit pdfRenameError("No PDF files to rename");
+}
 
-    // Check for API error
-    if (responseObj.contains("error")) {
-        QJsonObject errorObj = responseObj["error"].toObject();
-        QString errorMsg = errorObj["message"].toString();
-        qWarning() << "[AiConfig] API error during rename:" << errorMsg;
-        emit pdfRenameError("API Error: " + errorMsg);
-        reply->deleteLater();
+void AiConfig::renameFolderWithAi(const QString &folderPath)
+{
+    if (!canRename())
         return;
-    }
+    if (m_renameJob->addFolder(folderPath) == 0)
+        emit pdfRenameError("No PDF files found in " + folderPath);
+}
 
-    // Extract response text
-    QString suggestedName;
-    QJsonArray candidates = responseObj["candidates"].toArray();
-    if (!candidates.isEmpty()) {
-        QJsonObject firstCandidate = candidates[0].toObject();
-        QJsonObject content = firstCandidate["content"].toObject();
-        QJsonArray parts = content["parts"].toArray();
-        
-        if (!parts.isEmpty()) {
-            suggestedName = parts[0].toObject()["text"].toString().trimmed();
-        }
-    }
-    
-    if (suggestedName.isEmpty()) {
-        emit pdfRenameError("AI returned empty filename suggestion");
-        reply->deleteLater();
-        return;
-    }
-    
-    // Clean up the suggested name - remove any quotes, newlines, extra text
-    suggestedName = suggestedName.split('\n').first().trimmed();
-    suggestedName.remove(QRegularExpression("^[\"']|[\"']$"));
-    
-    // Ensure it ends with .pdf
-    if (!suggestedName.toLower().endsWith(".pdf")) {
-        suggestedName += ".pdf";
-    }
-    
-    // Sanitize filename - remove invalid characters
-    suggestedName.remove(QRegularExpression("[<>:\"/\\\\|?*]"));
-    
-    // Construct new path
-    QFileInfo oldFileInfo(oldPath);
-    QString newPath = oldFileInfo.absolutePath() + "/" + suggestedName;
-    
-    // Check if new file already exists
-    if (QFile::exists(newPath) && newPath != oldPath) {
-        // Add a number suffix to make it unique
-        QString baseName = suggestedName.left(suggestedName.length() - 4); // Remove .pdf
-        int counter = 1;
-        while (QFile::exists(newPath)) {
-            newPath = oldFileInfo.absolutePath() + "/" + baseName + "_" + QString::number(counter) + ".pdf";
-            counter++;
-        }
+bool AiConfig::canRename()
+{
+    if (m_geminiApiKey.isEmpty()) {
+        emit pdfRenameError("API key is not set. Please configure your Gemini API key.");
+        return false;
     }
     
-    // Perform the rename
-    QFile file(oldPath);
-    if (file.rename(newPath)) {
-        qInfo() << "[AiConfig] Successfully renamed PDF:" << oldPath << "to" << newPath;
-        emit pdfRenameCompleted(true, oldPath, newPath);
-    } else {
-        qWarning() << "[AiConfig] Failed to rename file:" << file.errorString();
-        emit pdfRenameError("Failed to rename file: " + file.errorString());
+    if (m_pdfRenamePrompt.isEmpty()) {
+        emit pdfRenameError("PDF rename prompt is not set. Please configure the prompt in AI Config.");
+        return false;
     }
-    
-    reply->deleteLater();
+
+    m_renameJob->setApiKey(m_geminiApiKey);
+    m_renameJob->setPrompt(m_pdfRenamePrompt);
+    m_renameJob->setEndpoint(m_endpoint);
+    return true;
 }
@@ -5,12 +5,23 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include "database.h"
+#include "geminiapi.h"
+#include "airequestscheduler.h"
+
+#include <memory>
+
+namespace project { class PdfRenameJob; class AiResponseCache; }
 
 /**
  * @brief Backend class for managing AI configuration settings
  * 
  * Handles storing/retrieving AI prompts and API keys from the config database,
- * and provides functionality to test the Gemini API connection.
+ * and provides functionality to test the Gemini API connection. PDF renames go
+ * through a project::PdfRenameJob, exposed to QML as renameJob, so several
+ * files can be renamed at once. Answers are kept in a project::AiResponseCache,
+ * repeated prompts are answered from it without a request. Every call goes
+ * through one project::AiRequestScheduler, limited to requestsPerMinute(),
+ * where test prompts take the Interactive lane ahead of batch renames.
  */
 class AiConfig : public QObject
 {
@@ -22,9 +33,12 @@ class AiConfig : public QObject
     Q_PROPERTY(QString taskPrompt READ taskPrompt WRITE setTaskPrompt NOTIFY taskPromptChanged)
     Q_PROPERTY(QString testResponse READ testResponse NOTIFY testResponseChanged)
     Q_PROPERTY(bool isLoading READ isLoading NOTIFY isLoadingChanged)
+    Q_PROPERTY(bool streaming READ streaming WRITE setStreaming NOTIFY streamingChanged)
+    Q_PROPERTY(int requestsPerMinute READ requestsPerMinute WRITE setRequestsPerMinute NOTIFY requestsPerMinuteChanged)
+    Q_PROPERTY(QObject* renameJob READ renameJob CONSTANT)
 
 public:
-    explicit AiConfig(DbmPtr configDb, QObject *parent = nullptr);
+    explicit AiConfig(DbmPtr configDb, QNetworkAccessManager *network = nullptr, QObject *parent = nullptr);
     ~AiConfig();
 
     // Property getters
@@ -33,13 +47,23 @@ public:
     QString calendarPrompt() const { return m_calendarPrompt; }
     QString taskPrompt() const { return m_taskPrompt; }
     QString testResponse() const { return m_testResponse; }
-    bool isLoading() const { return m_isLoading; }
+    bool isLoading() const;
+    bool streaming() const { return m_streaming; }
+    int requestsPerMinute() const;
+    QObject* renameJob() const;
+
+    /**
+     * @brief Point the Gemini calls at another API root, e.g. a local stand-in
+     */
+    void setEndpoint(const QUrl &endpoint);
 
     // Property setters
     void setGeminiApiKey(const QString &key);
     void setPdfRenamePrompt(const QString &prompt);
     void setCalendarPrompt(const QString &prompt);
     void setTaskPrompt(const QString &prompt);
+    void setStreaming(bool streaming);
+    void setRequestsPerMinute(int count);
 
 public slots:
     /**
@@ -55,9 +79,17 @@ public slots:
     
     /**
      * @brief Test the Gemini API with a custom prompt
+     *
+     * With streaming() the answer is requested from streamGenerateContent and
+     * testResponse grows as tokens arrive instead of appearing at the end.
      * @param prompt The prompt to send to Gemini
      */
     void testGemini(const QString &prompt);
+
+    /**
+     * @brief Forget every cached Gemini answer
+     */
+    void clearResponseCache();
     
     /**
      * @brief Rename a PDF file using AI based on its content
@@ -65,6 +97,16 @@ public slots:
      */
     Q_INVOKABLE void renamePdfWithAi(const QString &filePath);
 
+    /**
+     * @brief Rename several PDF files in one batch
+     */
+    Q_INVOKABLE void renamePdfsWithAi(const QStringList &filePaths);
+
+    /**
+     * @brief Rename every PDF directly inside folderPath
+     */
+    Q_INVOKABLE void renameFolderWithAi(const QString &folderPath);
+
 signals:
     void geminiApiKeyChanged();
     void pdfRenamePromptChanged();
@@ -72,24 +114,30 @@ signals:
     void taskPromptChanged();
     void testResponseChanged();
     void isLoadingChanged();
+    void streamingChanged();
+    void requestsPerMinuteChanged();
     void configSaved();
     void configLoadError(const QString &error);
     void testCompleted(bool success, const QString &response);
     void pdfRenameCompleted(bool success, const QString &oldPath, const QString &newPath);
     void pdfRenameError(const QString &error);
 
-private slots:
-    void onNetworkReply(QNetworkReply *reply);
-    void onRenameReply(QNetworkReply *reply);
-
 private:
+    void onNetworkReply(const project::AiRequestScheduler::Response &response, const QString &cacheKey);
+    void onStreamData(QByteArrayView chunk);
+    void onStreamFinished(const project::AiRequestScheduler::Response &response, const QString &cacheKey);
+    void setTestResponse(const QString &response, bool success);
     void createTableIfNotExists();
     bool updateConfigValue(const QString &key, const QString &value);
     QString getConfigValue(const QString &key, const QString &defaultValue = QString());
-    void sendGeminiRequest(const QString &prompt, std::function<void(QNetworkReply*)> callback);
+    bool canRename();
 
     DbmPtr m_configDb;
     QNetworkAccessManager *m_networkManager;
+    std::unique_ptr<project::AiResponseCache> m_responseCache;
+    project::AiRequestScheduler *m_scheduler;
+    project::PdfRenameJob *m_renameJob;
+    QUrl m_endpoint;
     
     QString m_geminiApiKey;
     QString m_pdfRenamePrompt;
@@ -97,10 +145,12 @@ private:
     QString m_taskPrompt;
     QString m_testResponse;
     bool m_isLoading;
-    
-    // PDF rename tracking
-    QString m_pendingRenamePath;
-    QNetworkReply *m_currentRenameReply;
+    bool m_streaming;
+
+    // streamed test request in flight, 0 for none
+    int m_streamRequest;
+    gemini::SseParser m_sseParser;
+    QString m_streamError;
 };
 
 #endif // AICONFIG_H
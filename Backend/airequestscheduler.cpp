@@ -0,0 +1,307 @@
+#include "airequestscheduler.h"
+#include "geminiapi.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+using namespace project;
+
+AiRequestScheduler::AiRequestScheduler(QNetworkAccessManager *network, QObject *parent)
+    : QObject{parent}, m_network(network), m_tokens(m_burst), m_wakeTimer(new QTimer(this))
+{
+    if (!m_network)
+        m_network = new QNetworkAccessManager(this);
+    m_clock.start();
+    m_wakeTimer->setSingleShot(true);
+    connect(m_wakeTimer, &QTimer::timeout, this, &AiRequestScheduler::dispatch);
+}
+
+AiRequestScheduler::~AiRequestScheduler()
+{
+    // replies belong to the shared manager, make sure none calls back into a deleted scheduler
+    for (const auto& request : m_active) {
+        disconnect(request->reply, nullptr, this, nullptr);
+        request->reply->abort();
+        request->reply->deleteLater();
+    }
+}
+
+int AiRequestScheduler::submit(const QNetworkRequest &request, const QByteArray &body, Priority priority,
+                               DoneHandler done, DataHandler data)
+{
+    const int id = m_nextId++;
+    const Subscriber subscriber{id, std::move(done), std::move(data)};
+
+    QByteArray key;
+    if (!subscriber.data) {
+        QCryptographicHash hash(QCryptographicHash::Sha256);
+        hash.addData(request.url().toEncoded() + '\n');
+        hash.addData(request.rawHeader("x-goog-api-key") + '\n');
+        hash.addData(body);
+        key = hash.result();
+
+        // the same question is already on its way, wait for its answer
+        if (RequestPtr pending = m_byKey.value(key)) {
+            pending->subscribers.append(subscriber);
+            m_bySubscriber.insert(id, pending);
+            if (priority < pending->priority && m_lanes[pending->priority].removeOne(pending)) {
+                pending->priority = priority;
+                m_lanes[priority].append(pending);
+            }
+            qInfo() << "[AiRequestScheduler] merged request" << id << "with one in flight";
+            return id;
+        }
+    }
+
+    auto pending = std::make_shared<Request>();
+    pending->request = request;
+    pending->body = body;
+    pending->priority = priority;
+    pending->key = key;
+    pending->subscribers.append(subscriber);
+    if (!key.isEmpty())
+        m_byKey.insert(key, pending);
+    m_bySubscriber.insert(id, pending);
+    m_lanes[priority].append(pending);
+    dispatch();
+    return id;
+}
+
+void AiRequestScheduler::cancel(int id)
+{
+    RequestPtr request = m_bySubscriber.take(id);
+    if (!request)
+        return;
+    request->subscribers.removeIf([id](const Subscriber& subscriber) { return subscriber.id == id; });
+    if (!request->subscribers.isEmpty())
+        return;
+
+    // nobody waits for it anymore
+    forget(request);
+    m_lanes[request->priority].removeOne(request);
+    if (request->reply) {
+        disconnect(request->reply, nullptr, this, nullptr);
+        request->reply->abort();
+        request->reply->deleteLater();
+        request->reply = nullptr;
+        m_active.removeOne(request);
+    }
+    dispatch();
+}
+
+int AiRequestScheduler::requestsPerMinute() const
+{
+    return m_requestsPerMinute;
+}
+
+int AiRequestScheduler::burst() const
+{
+    return m_burst;
+}
+
+void AiRequestScheduler::setRateLimit(int requestsPerMinute, int burst)
+{
+    refill();
+    m_requestsPerMinute = qMax(1, requestsPerMinute);
+    m_burst = qMax(1, burst);
+    m_tokens = qMin<double>(m_tokens, m_burst);
+    dispatch();
+}
+
+int AiRequestScheduler::maxConcurrent() const
+{
+    return m_maxConcurrent;
+}
+
+void AiRequestScheduler::setMaxConcurrent(int count)
+{
+    m_maxConcurrent = qMax(1, count);
+    dispatch();
+}
+
+int AiRequestScheduler::maxRetries() const
+{
+    return m_maxRetries;
+}
+
+void AiRequestScheduler::setMaxRetries(int count)
+{
+    m_maxRetries = qMax(0, count);
+}
+
+int AiRequestScheduler::retryDelay() const
+{
+    return m_retryDelay;
+}
+
+void AiRequestScheduler::setRetryDelay(int ms)
+{
+    m_retryDelay = qMax(0, ms);
+}
+
+int AiRequestScheduler::timeoutMs() const
+{
+    return m_timeoutMs;
+}
+
+void AiRequestScheduler::setTimeoutMs(int ms)
+{
+    m_timeoutMs = ms;
+}
+
+int AiRequestScheduler::queuedCount() const
+{
+    return int(m_lanes[Interactive].size() + m_lanes[Batch].size());
+}
+
+int AiRequestScheduler::activeCount() const
+{
+    return int(m_active.size());
+}
+
+void AiRequestScheduler::refill()
+{
+    const qint64 now = m_clock.elapsed();
+    m_tokens = qMin<double>(m_burst, m_tokens + (now - m_refilledAt) * m_requestsPerMinute / 60000.0);
+    m_refilledAt = now;
+}
+
+void AiRequestScheduler::dispatch()
+{
+    refill();
+    while (m_active.size() < m_maxConcurrent) {
+        QList<RequestPtr>& lane = m_lanes[Interactive].isEmpty() ? m_lanes[Batch] : m_lanes[Interactive];
+        if (lane.isEmpty())
+            return;
+
+        // wait for the provider's cool-down or the next token, whichever is later
+        const qint64 now = m_clock.elapsed();
+        qint64 wait = m_pausedUntil - now;
+        if (m_tokens < 1.0)
+            wait = qMax(wait, qint64(std::ceil((1.0 - m_tokens) * 60000.0 / m_requestsPerMinute)));
+        if (wait > 0) {
+            if (!m_wakeTimer->isActive() || m_wakeTimer->remainingTime() > wait)
+                m_wakeTimer->start(int(wait));
+            return;
+        }
+
+        m_tokens -= 1.0;
+        start(lane.takeFirst());
+    }
+}
+
+void AiRequestScheduler::start(const RequestPtr &request)
+{
+    ++request->attempts;
+    QNetworkRequest networkRequest = request->request;
+    networkRequest.setTransferTimeout(m_timeoutMs);
+    QNetworkReply* reply = m_network->post(networkRequest, request->body);
+    request->reply = reply;
+    m_active.append(request);
+
+    connect(reply, &QNetworkReply::readyRead, this, [this, request]() { onReadyRead(request); });
+    connect(reply, &QNetworkReply::finished, this, [this, request]() { onFinished(request); });
+}
+
+void AiRequestScheduler::onReadyRead(const RequestPtr &request)
+{
+    QNetworkReply* reply = request->reply;
+    const bool streamed = std::any_of(request->subscribers.begin(), request->subscribers.end(),
+                                      [](const Subscriber& subscriber) { return bool(subscriber.data); });
+    // error bodies stay in the reply and come with the response
+    if (!streamed || reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() >= 400)
+        return;
+
+    const QByteArray chunk = reply->readAll();
+    request->delivered = true;
+    // a handler may cancel, keep our own copy of the list
+    const QList<Subscriber> subscribers = request->subscribers;
+    for (const auto& subscriber : subscribers) {
+        if (subscriber.data)
+            subscriber.data(chunk);
+    }
+}
+
+void AiRequestScheduler::onFinished(const RequestPtr &request)
+{
+    QNetworkReply* reply = request->reply;
+    reply->deleteLater();
+    request->reply = nullptr;
+    m_active.removeOne(request);
+
+    Response response;
+    response.status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    response.error = reply->error();
+    response.errorString = reply->errorString();
+    response.attempts = request->attempts;
+
+    if (!response.ok() && gemini::isTransient(response.status) && !request->delivered
+        && request->attempts <= m_maxRetries) {
+        qint64 delay = qint64(m_retryDelay) << qMin(request->attempts - 1, 16);
+        const qint64 asked = retryAfter(reply);
+        if (asked >= 0) {
+            delay = qMax(delay, asked);
+            if (response.status == 429) {
+                // the quota is shared, everyone waits
+                m_pausedUntil = qMax(m_pausedUntil, m_clock.elapsed() + asked);
+                emit rateLimited(int(asked));
+            }
+        }
+        qInfo() << "[AiRequestScheduler] status" << response.status << "- retrying in" << delay << "ms";
+        retryLater(request, delay);
+    } else {
+        response.body = reply->readAll();
+        complete(request, response);
+    }
+    dispatch();
+}
+
+void AiRequestScheduler::retryLater(const RequestPtr &request, qint64 delay)
+{
+    QTimer::singleShot(delay, this, [this, request]() {
+        // cancelled while waiting
+        if (request->subscribers.isEmpty())
+            return;
+        m_lanes[request->priority].prepend(request);
+        dispatch();
+    });
+}
+
+void AiRequestScheduler::complete(const RequestPtr &request, const Response &response)
+{
+    forget(request);
+    const QList<Subscriber> subscribers = request->subscribers;
+    request->subscribers.clear();
+    for (const auto& subscriber : subscribers) {
+        m_bySubscriber.remove(subscriber.id);
+        if (subscriber.done)
+            subscriber.done(response);
+    }
+}
+
+void AiRequestScheduler::forget(const RequestPtr &request)
+{
+    // later identical requests are sent again
+    if (!request->key.isEmpty() && m_byKey.value(request->key) == request)
+        m_byKey.remove(request->key);
+}
+
+qint64 AiRequestScheduler::retryAfter(const QNetworkReply *reply)
+{
+    const QByteArray value = reply->rawHeader("Retry-After").trimmed();
+    if (value.isEmpty())
+        return -1;
+
+    bool ok = false;
+    const qint64 seconds = value.toLongLong(&ok);
+    if (ok)
+        return qMax<qint64>(0, seconds) * 1000;
+
+    // the other form is an HTTP date
+    const QDateTime at = QDateTime::fromString(QString::fromLatin1(value), Qt::RFC2822Date);
+    if (!at.isValid())
+        return -1;
+    return qMax<qint64>(0, QDateTime::currentDateTimeUtc().msecsTo(at));
+}
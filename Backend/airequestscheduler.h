@@ -0,0 +1,153 @@
+#ifndef AIREQUESTSCHEDULER_H
+#define AIREQUESTSCHEDULER_H
+
+#include <QObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QHash>
+#include <QList>
+#include <functional>
+#include <memory>
+
+namespace project {
+/**
+ * @class AiRequestScheduler
+ * @brief The single way out for requests to the AI provider.
+ *
+ * Requests wait in two lanes and Interactive ones (the test prompt) always
+ * start before Batch ones (bulk renames). Starts are limited by a token
+ * bucket of burst() tokens refilled at requestsPerMinute(), and by
+ * maxConcurrent() requests in flight. Timeouts, 429 and 5xx answers are
+ * retried up to maxRetries() times with exponential backoff from
+ * retryDelay() ms, or after the Retry-After the provider asks for; a 429
+ * with Retry-After holds back every request until then, since the quota is
+ * shared.
+ *
+ * Identical requests (same URL, API key and body) submitted while one is
+ * queued or in flight are merged: it is sent once and every caller gets the
+ * response. Streamed requests, which hand their body over in pieces, are
+ * never merged.
+ */
+class AiRequestScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum Priority {
+        Interactive,
+        Batch
+    };
+    Q_ENUM(Priority)
+
+    struct Response {
+        // HTTP status, 0 when none arrived
+        int status = 0;
+        QNetworkReply::NetworkError error = QNetworkReply::NoError;
+        QString errorString;
+        // body, for streamed requests the part not handed to the data handler
+        QByteArray body;
+        int attempts = 0;
+
+        bool ok() const { return error == QNetworkReply::NoError; }
+    };
+
+    using DoneHandler = std::function<void(const Response&)>;
+    using DataHandler = std::function<void(QByteArrayView)>;
+
+    explicit AiRequestScheduler(QNetworkAccessManager *network = nullptr, QObject *parent = nullptr);
+    ~AiRequestScheduler();
+
+    /**
+     * @brief Queue a POST; done is called once with the final response
+     * @param data if set, body bytes of a successful response are passed on as they arrive
+     * @return id for cancel()
+     */
+    int submit(const QNetworkRequest& request, const QByteArray& body, Priority priority,
+               DoneHandler done, DataHandler data = nullptr);
+
+    /**
+     * @brief Drop a submitted request, its handlers are not called anymore
+     */
+    void cancel(int id);
+
+    int requestsPerMinute() const;
+    int burst() const;
+    void setRateLimit(int requestsPerMinute, int burst);
+
+    int maxConcurrent() const;
+    void setMaxConcurrent(int count);
+
+    int maxRetries() const;
+    void setMaxRetries(int count);
+
+    int retryDelay() const;
+    void setRetryDelay(int ms);
+
+    int timeoutMs() const;
+    void setTimeoutMs(int ms);
+
+    int queuedCount() const;
+    int activeCount() const;
+
+signals:
+    // a 429 made every request wait for ms
+    void rateLimited(int ms);
+
+private:
+    struct Subscriber {
+        int id;
+        DoneHandler done;
+        DataHandler data;
+    };
+
+    struct Request {
+        QNetworkRequest request;
+        QByteArray body;
+        Priority priority;
+        // empty for requests that are never merged
+        QByteArray key;
+        QList<Subscriber> subscribers;
+        QNetworkReply* reply = nullptr;
+        int attempts = 0;
+        // body bytes already handed to data handlers, a retry would repeat them
+        bool delivered = false;
+    };
+    using RequestPtr = std::shared_ptr<Request>;
+
+    QNetworkAccessManager* m_network;
+    QList<RequestPtr> m_lanes[2];
+    QHash<QByteArray, RequestPtr> m_byKey;
+    QHash<int, RequestPtr> m_bySubscriber;
+    QList<RequestPtr> m_active;
+    int m_nextId = 1;
+
+    int m_requestsPerMinute = 15;
+    int m_burst = 5;
+    int m_maxConcurrent = 4;
+    int m_maxRetries = 3;
+    int m_retryDelay = 1000;
+    int m_timeoutMs = 60000;
+
+    // token bucket, refilled lazily from m_clock
+    double m_tokens;
+    qint64 m_refilledAt = 0;
+    qint64 m_pausedUntil = 0;
+    QElapsedTimer m_clock;
+    QTimer* m_wakeTimer;
+
+    void dispatch();
+    void refill();
+    void start(const RequestPtr& request);
+    void onReadyRead(const RequestPtr& request);
+    void onFinished(const RequestPtr& request);
+    void retryLater(const RequestPtr& request, qint64 delay);
+    void complete(const RequestPtr& request, const Response& response);
+    void forget(const RequestPtr& request);
+    static qint64 retryAfter(const QNetworkReply* reply);
+};
+
+} // namespace project
+
+#endif // AIREQUESTSCHEDULER_H
@@ -0,0 +1,107 @@
+#include "airesponsecache.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+
+using namespace project;
+
+// every use takes the next value, a plain counter keeps the LRU order exact
+static const char* kNextUse = "(SELECT COALESCE(MAX(last_used), 0) + 1 FROM AiResponses)";
+
+AiResponseCache::AiResponseCache(DbmPtr db)
+    : db_(db)
+{
+}
+
+QString AiResponseCache::key(const QString &model, const QString &promptTemplate, const QString &input)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    // length prefixes keep ("ab", "c") and ("a", "bc") apart
+    for (const QString& part : {model, promptTemplate, input}) {
+        const QByteArray utf8 = part.toUtf8();
+        hash.addData(QByteArray::number(utf8.size()) + ':');
+        hash.addData(utf8);
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString AiResponseCache::lookup(const QString &key)
+{
+    if (!db_)
+        return QString();
+
+    bool found = false;
+    QString response;
+    db_->forEachRow<QString>("SELECT response FROM AiResponses WHERE key = ?", {key},
+                             [&](const QString& stored) {
+        response = stored;
+        found = true;
+    });
+
+    if (!found) {
+        ++m_misses;
+        return QString();
+    }
+    ++m_hits;
+    db_->exec(QString("UPDATE AiResponses SET last_used = %1 WHERE key = ?").arg(kNextUse), {key});
+    return response;
+}
+
+void AiResponseCache::store(const QString &key, const QString &model, const QString &response)
+{
+    const qint64 bytes = response.toUtf8().size();
+    // an answer over the byte bound would only push every other answer out
+    if (!db_ || response.isEmpty() || bytes > m_maxBytes)
+        return;
+
+    if (!db_->exec(QString("INSERT OR REPLACE INTO AiResponses (key, model, response, bytes, created_at, last_used) "
+                           "VALUES (?, ?, ?, ?, ?, %1)").arg(kNextUse),
+                   {key, model, response, bytes, QDateTime::currentSecsSinceEpoch()})) {
+        qWarning() << "[AiResponseCache] failed to store response" << key;
+        return;
+    }
+    evict();
+}
+
+void AiResponseCache::clear()
+{
+    if (db_)
+        db_->exec("DELETE FROM AiResponses");
+}
+
+int AiResponseCache::count() const
+{
+    return db_ ? db_->selectValue<int>("SELECT COUNT(*) FROM AiResponses") : 0;
+}
+
+qint64 AiResponseCache::totalBytes() const
+{
+    return db_ ? db_->selectValue<qint64>("SELECT COALESCE(SUM(bytes), 0) FROM AiResponses") : 0;
+}
+
+void AiResponseCache::setMaxEntries(int count)
+{
+    m_maxEntries = qMax(1, count);
+    evict();
+}
+
+void AiResponseCache::setMaxBytes(qint64 bytes)
+{
+    m_maxBytes = qMax<qint64>(1, bytes);
+    evict();
+}
+
+void AiResponseCache::evict()
+{
+    if (!db_)
+        return;
+
+    // oldest rows past the entry bound, then those that push the total over the byte bound
+    db_->exec("DELETE FROM AiResponses WHERE key IN "
+              "(SELECT key FROM AiResponses ORDER BY last_used DESC LIMIT -1 OFFSET ?)",
+              {m_maxEntries});
+    db_->exec("DELETE FROM AiResponses WHERE key IN "
+              "(SELECT key FROM (SELECT key, SUM(bytes) OVER (ORDER BY last_used DESC) AS kept "
+              "FROM AiResponses) WHERE kept > ?)",
+              {m_maxBytes});
+}
@@ -0,0 +1,63 @@
+#ifndef AIRESPONSECACHE_H
+#define AIRESPONSECACHE_H
+
+#include <QString>
+#include "database.h"
+
+namespace project {
+/**
+ * @class AiResponseCache
+ * @brief Persistent cache of Gemini answers in the AiResponses table of the config database.
+ *
+ * Answers are keyed by the SHA-256 of model, prompt template and input text,
+ * so renaming the same paper again, or an identical preprint in another
+ * project, costs no request. The table is bounded by maxEntries() rows and
+ * maxBytes() of answer text; store() evicts the least recently used answers
+ * beyond either bound.
+ */
+class AiResponseCache
+{
+public:
+    explicit AiResponseCache(DbmPtr db);
+
+    /**
+     * @brief Cache key (hex SHA-256) of a request
+     */
+    static QString key(const QString& model, const QString& promptTemplate, const QString& input);
+
+    /**
+     * @brief Cached answer for key, a null string on a miss
+     *
+     * A hit marks the answer as most recently used.
+     */
+    QString lookup(const QString& key);
+
+    void store(const QString& key, const QString& model, const QString& response);
+
+    void clear();
+
+    int count() const;
+    qint64 totalBytes() const;
+
+    int hits() const { return m_hits; }
+    int misses() const { return m_misses; }
+
+    int maxEntries() const { return m_maxEntries; }
+    void setMaxEntries(int count);
+
+    qint64 maxBytes() const { return m_maxBytes; }
+    void setMaxBytes(qint64 bytes);
+
+private:
+    DbmPtr db_;
+    int m_maxEntries = 2000;
+    qint64 m_maxBytes = 4 * 1024 * 1024;
+    int m_hits = 0;
+    int m_misses = 0;
+
+    void evict();
+};
+
+} // namespace project
+
+#endif // AIRESPONSECACHE_H
@@ -1,6 +1,7 @@
 #include "applicationmanager.h"
 #include "backend.h"
 #include "templatemanager.h"
+#include "migrations.h"
 #include <QFile>
 #include <QDir>
 #include <QSqlQuery>
@@ -13,6 +14,9 @@
 #include <QTimer>
 #include <QFileInfo>
 #include <QIcon>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
 
 using namespace project;
 
@@ -70,11 +74,15 @@ ApplicationManager::ApplicationManager(QGuiApplication *app, QObject *parent)
     , m_engine(nullptr)
     , m_homepage(nullptr)
     , m_templateProject(nullptr)
+    , m_searchModel(nullptr)
     , m_project(nullptr)
     , m_wsModel(nullptr)
     , m_templateModel(nullptr)
     , m_task(nullptr)
     , m_lnModel(nullptr)
+    , m_linkResolver(nullptr)
+    , m_linkChecker(nullptr)
+    , m_network(nullptr)
     , m_fsModel(nullptr)
     , m_fsWrapper(nullptr)
     , m_flModel(nullptr)
@@ -108,6 +116,7 @@ ApplicationManager::~ApplicationManager()
     delete m_wsModel;
     delete m_project;
     delete m_templateProject;
+    delete m_searchModel;
     delete m_homepage;
     delete m_colModel;
     delete m_msgModel;
@@ -176,12 +185,24 @@ void ApplicationManager::setupDatabases()
 {
     // Setup research database
     QString dbPath = m_appDir + "/research.db";
-    if (!QFile::exists(dbPath)) {
-        createResearchDatabase(dbPath);
-    }
     
+    // WAL lets the worker thread and background readers run alongside UI edits;
+    // it can be turned off for databases on file systems without shared memory
+    QSettings settings("ResearchManager", "ResearchManager");
+    const StorageProfile profile = settings.value("storage/concurrent", true).toBool()
+                                       ? StorageProfile::Concurrent
+                                       : StorageProfile::Default;
+
     m_researchDb = std::make_shared<DatabaseManager>("research");
+    m_researchDb->setStorageProfile(profile);
+    m_researchDb->stats().setSlowThresholdMs(settings.value("debug/slowQueryMs", 100).toInt());
     m_researchDb->connect(dbPath);
+    // creates a fresh database and upgrades older ones in place
+    if (!m_researchDb->migrate(migrations::research())) {
+        qWarning() << "[ApplicationManager] Failed to migrate research database";
+    }
+    // model reloads run on a worker thread instead of the GUI thread
+    m_researchDb->enableAsync();
     
     // Setup config database - get path from settings
     QString configPath = getConfigDatabasePath();
@@ -193,107 +214,45 @@ void ApplicationManager::setupDatabases()
         dir.mkpath(".");
     }
     
-    if (!QFile::exists(configPath)) {
-        createConfigDatabase(configPath, dbPath);
-    } else {
-        // Ensure existing database has all required tables
-        ensureConfigDatabaseTables(configPath);
-    }
+    const bool newConfig = !QFile::exists(configPath);
     
-    m_configDb = std::make_shared<DatabaseManager>("config", configPath);
-}
-
-bool ApplicationManager::createResearchDatabase(const QString &dbPath)
-{
-    if (!initializeDatabase(dbPath)) {
-        qWarning() << "Failed to initialize research database";
-        return false;
+    m_configDb = std::make_shared<DatabaseManager>("config");
+    m_configDb->setStorageProfile(profile);
+    m_configDb->stats().setSlowThresholdMs(settings.value("debug/slowQueryMs", 100).toInt());
+    m_configDb->connect(configPath);
+    if (!m_configDb->migrate(migrations::config())) {
+        qWarning() << "[ApplicationManager] Failed to migrate config database";
+    }
+    if (newConfig) {
+        createDefaultWorkspace(dbPath);
     }
-    return true;
 }
 
-bool ApplicationManager::createConfigDatabase(const QString &configPath, const QString &researchDbPath)
+QString ApplicationManager::dumpSqlStats()
 {
-    QSqlDatabase configDb = QSqlDatabase::addDatabase("QSQLITE", "tempConfig");
-    configDb.setDatabaseName(configPath);
-    
-    if (!configDb.open()) {
-        qWarning() << "Failed to create config database";
-        return false;
+    QJsonObject root;
+    root["generated"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    if (m_researchDb)
+        root["research"] = m_researchDb->stats().toJson();
+    if (m_configDb)
+        root["config"] = m_configDb->stats().toJson();
+
+    const QString path = m_appDir + "/sql_stats.json";
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "[ApplicationManager] Failed to write" << path;
+        return QString();
     }
-    
-    QSqlQuery query(configDb);
-    query.exec("CREATE TABLE IF NOT EXISTS Workspace (name TEXT, database TEXT, year INTEGER, workspace TEXT, icon TEXT)");
-    query.exec("INSERT INTO Workspace VALUES ('Default', '" 
-               + researchDbPath + "', 2026, '" 
-               + QDir::homePath() + "/ResearchWorkspace', 'local-folder.svg')");
-    
-    // Create Contacts table
-    query.exec("CREATE TABLE IF NOT EXISTS Contacts ("
-               "name TEXT NOT NULL,"
-               "affiliation TEXT,"
-               "website TEXT,"
-               "phone TEXT,"
-               "email TEXT NOT NULL,"
-               "zoom TEXT,"
-               "photo TEXT,"
-               "UNIQUE(name),"
-               "PRIMARY KEY(name)"
-               ")");
-    
-    // Create Template table
-    query.exec("CREATE TABLE IF NOT EXISTS Template ("
-               "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-               "items TEXT NOT NULL,"
-               "category_id INTEGER"
-               ")");
-    
-    configDb.close();
-    QSqlDatabase::removeDatabase("tempConfig");
-    
-    return true;
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    qInfo() << "[ApplicationManager] SQL stats written to" << path;
+    return path;
 }
 
-bool ApplicationManager::ensureConfigDatabaseTables(const QString &configPath)
+bool ApplicationManager::createDefaultWorkspace(const QString &researchDbPath)
 {
-    QSqlDatabase configDb = QSqlDatabase::addDatabase("QSQLITE", "tempMigration");
-    configDb.setDatabaseName(configPath);
-    
-    if (!configDb.open()) {
-        qWarning() << "Failed to open config database for migration";
-        return false;
-    }
-    
-    QSqlQuery query(configDb);
-    
-    // Create Template table if it doesn't exist
-    if (!query.exec("CREATE TABLE IF NOT EXISTS Template ("
-                   "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-                   "items TEXT NOT NULL,"
-                   "category_id INTEGER"
-                   ")")) {
-        qWarning() << "Failed to ensure Template table exists:" << query.lastError().text();
-    }
-    
-    // Ensure other tables exist
-    query.exec("CREATE TABLE IF NOT EXISTS Workspace (name TEXT, database TEXT, workspace TEXT, icon TEXT)");
-    query.exec("CREATE TABLE IF NOT EXISTS Contacts ("
-               "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-               "name TEXT NOT NULL,"
-               "affiliation TEXT,"
-               "website TEXT,"
-               "phone TEXT,"
-               "email TEXT NOT NULL,"
-               "zoom TEXT,"
-               "photo TEXT,"
-               "UNIQUE(name),"
-               ")");
-    
-    configDb.close();
-    QSqlDatabase::removeDatabase("tempMigration");
-    
-    qDebug() << "Config database migration completed";
-    return true;
+    return m_configDb->exec("INSERT INTO Workspace (name, database, year, workspace, icon) VALUES (?, ?, ?, ?, ?)",
+                            {"Default", researchDbPath, 2026,
+                             QDir::homePath() + "/ResearchWorkspace", "local-folder.svg"});
 }
 
 void ApplicationManager::initializeModels()
@@ -301,6 +260,7 @@ void ApplicationManager::initializeModels()
     // Homepage models
     m_homepage = new homepage::ProjectView(m_researchDb->getSharedPtr(), this);
     m_templateProject = new homepage::CreateProject(m_configDb->getSharedPtr(), this);
+    m_searchModel = new homepage::SearchModel(m_researchDb->getSharedPtr(), this);
     
     // Project and workspace models
     m_project = new project::ProjectPage(m_researchDb->getSharedPtr(), this);
@@ -312,6 +272,12 @@ void ApplicationManager::initializeModels()
     // Task and link models
     m_task = new project::TaskManger(m_researchDb->getSharedPtr(), this);
     m_lnModel = new project::LinkViewer(m_researchDb->getSharedPtr(), this);
+    m_network = new QNetworkAccessManager(m_engine);
+    // link titles are fetched in the background and cached in the config database
+    m_linkResolver = new project::LinkMetadataResolver(m_configDb->getSharedPtr(), m_network, m_engine);
+    m_lnModel->setMetadataResolver(m_linkResolver);
+    m_linkChecker = new project::LinkHealthChecker(m_researchDb->getSharedPtr(), m_network, m_engine);
+    m_lnModel->setHealthChecker(m_linkChecker);
     
     // File system models
     m_fsModel = new QFileSystemModel(m_engine);
@@ -331,10 +297,11 @@ void ApplicationManager::initializeModels()
     m_colModel = new collab::CollaboratorModel(m_researchDb->getSharedPtr(), m_engine);
     m_msgModel = new collab::MessageViewer(m_researchDb->getSharedPtr(), m_engine);
     // AI Config model uses config database
-    m_aiConfig = new AiConfig(m_configDb->getSharedPtr(), m_engine);
+    m_aiConfig = new AiConfig(m_configDb->getSharedPtr(), m_network, m_engine);
 
     // File downloader
-    m_fileDownloader = new project::FileDownloader(m_engine);
+    // completed downloads are recorded with their checksum in the config database
+    m_fileDownloader = new project::FileDownloader(m_configDb->getSharedPtr(), m_network, m_engine);
 }
 
 void ApplicationManager::setupSignalConnections()
@@ -348,6 +315,8 @@ void ApplicationManager::setupSignalConnections()
                      m_homepage, SLOT(setReserachDB(QString)));
     QObject::connect(m_templateProject, SIGNAL(setReserachDB(QString)),
                      m_calModel, SLOT(updateCalendarDB(QString)));
+    QObject::connect(m_templateProject, SIGNAL(setReserachDB(QString)),
+                     m_searchModel, SLOT(clear()));
     
     // Project connections
     QObject::connect(m_project, SIGNAL(projectIdChanged(int)),
@@ -394,12 +363,14 @@ void ApplicationManager::registerContextProperties()
     // Register all models as context properties
     // Note: reinterpret_cast is safe here since all models inherit from QObject
     context->setContextProperty("homepageModel", reinterpret_cast<QObject*>(m_homepage));
+    context->setContextProperty("searchModel", reinterpret_cast<QObject*>(m_searchModel));
     context->setContextProperty("templateModel", reinterpret_cast<QObject*>(m_templateModel));
     context->setContextProperty("tpModel", reinterpret_cast<QObject*>(m_templateProject));
     context->setContextProperty("project", reinterpret_cast<QObject*>(m_project));
     context->setContextProperty("wsModel", reinterpret_cast<QObject*>(m_wsModel));
     context->setContextProperty("task", reinterpret_cast<QObject*>(m_task));
     context->setContextProperty("lnModel", reinterpret_cast<QObject*>(m_lnModel));
+    context->setContextProperty("linkChecker", reinterpret_cast<QObject*>(m_linkChecker));
     context->setContextProperty("fsModel", reinterpret_cast<QObject*>(m_fsModel));
     context->setContextProperty("fsWrapper", reinterpret_cast<QObject*>(m_fsWrapper));
     context->setContextProperty("flModel", reinterpret_cast<QObject*>(m_flModel));
@@ -472,7 +443,9 @@ void ApplicationManager::setupCleanupHandlers()
             delete obj;
         }
         
-        // Now safely close database connections
+        // Finalize cached statements, then safely close database connections
+        m_researchDb->clearStatementCache();
+        m_configDb->clearStatementCache();
         if (QSqlDatabase::contains("research")) {
             QSqlDatabase::database("research").close();
             QSqlDatabase::removeDatabase("research");
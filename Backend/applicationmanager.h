@@ -6,6 +6,7 @@
 #include <QQmlContext>
 #include <QFileSystemModel>
 #include <QSettings>
+#include <QNetworkAccessManager>
 #include <memory>
 
 // Forward declarations
@@ -18,6 +19,8 @@ namespace project {
     class ProjectPage;
     class TaskManger;
     class LinkViewer;
+    class LinkMetadataResolver;
+    class LinkHealthChecker;
     class ContactsModel;
     class FileSystemModelWrapper;
     class FileListViewer;
@@ -36,6 +39,7 @@ namespace collab {
 namespace homepage {
     class ProjectView;
     class CreateProject;
+    class SearchModel;
 }
 
 /**
@@ -88,6 +92,12 @@ public:
 public slots:
     QString browseForConfigDatabase();
 
+    /**
+     * @brief Write SQL statement statistics of both databases as JSON
+     * @return path of the written file, empty on failure
+     */
+    QString dumpSqlStats();
+
 private:
     // Initialization methods
     void setupEngine();
@@ -99,9 +109,7 @@ private:
     void setupCleanupHandlers();
 
     // Helper methods
-    bool createResearchDatabase(const QString &dbPath);
-    bool createConfigDatabase(const QString &configPath, const QString &researchDbPath);
-    bool ensureConfigDatabaseTables(const QString &configPath);
+    bool createDefaultWorkspace(const QString &researchDbPath);
     QString getConfigDatabasePath();
     void showStartupConfigDialog();
     
@@ -118,11 +126,16 @@ private:
     // Models (stack allocated)
     homepage::ProjectView *m_homepage;
     homepage::CreateProject *m_templateProject;
+    homepage::SearchModel *m_searchModel;
     project::ProjectPage *m_project;
     WorkspaceModel *m_wsModel;
     TemplateModel *m_templateModel;
     project::TaskManger *m_task;
     project::LinkViewer *m_lnModel;
+    project::LinkMetadataResolver *m_linkResolver;
+    project::LinkHealthChecker *m_linkChecker;
+    // one connection pool for every background request
+    QNetworkAccessManager *m_network;
 
     // Models (heap allocated)
     QFileSystemModel *m_fsModel;
@@ -1,12 +1,15 @@
 #ifndef BACKEND_H
 #define BACKEND_H
 #include "homepage.h"
+#include "searchmodel.h"
 #include "database.h"
 #include "projectpage.h"
 #include "taskmanger.h"
 #include "fileexplorer.h"
 #include "filelistviewer.h"
 #include "linkviewer.h"
+#include "linkmetadataresolver.h"
+#include "linkhealthchecker.h"
 #include "calendarview.h"
 #include "deadlinemodel.h"
 #include "createproject.h"
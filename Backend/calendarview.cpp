@@ -45,36 +45,26 @@ void CalendarView::setMonth(int m)
     end_date.setDate(m_date.year(), m, daysInMonth());
 
     qInfo() << m_date.toString(Qt::ISODate) << end_date.toString(Qt::ISODate);
-    QString sqlCmd = QString("SELECT id, name FROM projects");
-    auto results = db_->queryRow(sqlCmd);
     QHash<int, QString> projectMap;
-    for(int i = 0; i < results.size(); i+=2)
-    {
-        int j = i + 1;
-        int id_ = results[i].toInt();
-        projectMap[id_] = results[j];
-    }
-
+    db_->forEachRow<int, QString>("SELECT id, name FROM projects", {},
+                                  [&](int id_, const QString& name) {
+        projectMap[id_] = name;
+    });
 
-
-    sqlCmd = QString("SELECT project_id, event, timestamp FROM calendars WHERE  timestamp BETWEEN '%1' AND '%2'").arg(m_date.toString(Qt::ISODate), end_date.toString(Qt::ISODate));
-    results = db_->queryRow(sqlCmd);
     deadline_dates_.clear();
-    for(int i = 0; i < results.size(); i+=3)
-    {
-        int j = i + 1;
-        int k = i + 2;
-        int id_ = results[i].toInt();
-
-        if(!projectMap.contains(id_))
-            continue;
-
-        auto timestamp = results[k].split(" ").front();
-        auto event = QString("[%1]: %3 - %2").arg(projectMap[id_], results[j], timestamp);
-
-        qInfo() << timestamp << event;
-        deadline_dates_[timestamp].append(event);
-    }
+    db_->forEachRow<int, QString, QString>(
+        "SELECT project_id, event, timestamp FROM calendars WHERE timestamp BETWEEN ? AND ?",
+        {m_date.toString(Qt::ISODate), end_date.toString(Qt::ISODate)},
+        [&](int id_, const QString& eventName, const QString& time) {
+            if(!projectMap.contains(id_))
+                return;
+
+            auto timestamp = time.split(" ").front();
+            auto event = QString("[%1]: %3 - %2").arg(projectMap[id_], eventName, timestamp);
+
+            qInfo() << timestamp << event;
+            deadline_dates_[timestamp].append(event);
+        });
 
     emit dateChanged();
 }
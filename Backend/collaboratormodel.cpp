@@ -2,7 +2,11 @@
 using namespace collab;
 
 CollaboratorModel::CollaboratorModel(DbmPtr db,QObject *parent)
-    : QAbstractListModel{parent}, db_(db)
+    : SqlListModel(db, "collaborators", {
+          bindRole<&ColData::name>(Name, "name"),
+          bindRole<&ColData::tag_name>(Tag, "tag"),
+          bindRole<&ColData::photo>(Photo, "photo")
+      }, parent)
 {
     m_projectID = -1;
 }
@@ -11,74 +15,28 @@ void CollaboratorModel::projectIdChanged(int newId)
 {
     m_projectID = newId;
     qInfo() << "[CollaboratorModel] m_projectID = " << m_projectID;
-    
-    // Clear the old data when switching projects
-    beginResetModel();
-    col_map_.clear();
-    endResetModel();
+    refresh();
 }
 
-int CollaboratorModel::rowCount(const QModelIndex &parent) const
+void CollaboratorModel::refresh()
 {
+    // the collaborators table is created by migrations::research()
     if(m_projectID < 0)
-        return 0;
-    // create a table if it does not exist with following columns
-    // id, name, tag_name, project_id
-
-    auto tableStr = QString(R"(
-        CREATE TABLE IF NOT EXISTS "collaborators" (
-            "id" INTEGER PRIMARY KEY AUTOINCREMENT,
-            "name" TEXT NOT NULL,
-            "tag_name" TEXT,
-            "photo" TEXT,
-            "project_id" INTEGER NOT NULL,
-            UNIQUE("name", "project_id"),
-            FOREIGN KEY("project_id") REFERENCES "projects"("id") ON DELETE CASCADE
-        )
-    )");
-    db_->createTable(tableStr);
-
-    // Clear existing data before repopulating
-    col_map_.clear();
-
-    
-    auto query = QString("SELECT id, name, tag_name, photo FROM collaborators WHERE project_id = %1").arg(m_projectID);
-    auto results = db_->queryRow(query);
-
-    int index = 0;
-    for(int i = 0; i < results.size(); i += 4)
     {
-        int j = i + 1;
-        int k = i + 2;
-        int l = i + 3;
-        ColData col;
-        col.id = results[i].toInt();
-        col.name = results[j];
-        col.tag_name = results[k];
-        col.photo = results[l];
-        col_map_[index] = col;
-        ++index;
+        setRows({});
+        return;
     }
-
-    return col_map_.size();
+    setRows(db_->selectRows<ColData, int, QString, QString, QString>(
+        "SELECT id, name, tag_name, photo FROM collaborators WHERE project_id = ? ORDER BY id", {m_projectID}));
 }
 
-QVariant CollaboratorModel::data(const QModelIndex &index, int role) const
+std::optional<ColData> CollaboratorModel::fetchRow(int id)
 {
-
-    int row = index.row();
-    if(m_projectID < 0 || !index.isValid() || !col_map_.contains(row))
-        return QVariant();
-
-    auto col = col_map_[row];
-    switch(role)
-    {
-        case Name: return col.name;
-        case Tag: return col.tag_name;
-        case Photo: return col.photo;
-    }
-
-    return QVariant();
+    const auto found = db_->selectRows<ColData, int, QString, QString, QString>(
+        "SELECT id, name, tag_name, photo FROM collaborators WHERE id = ? AND project_id = ?", {id, m_projectID});
+    if(found.isEmpty())
+        return std::nullopt;
+    return found.first();
 }
 
 void CollaboratorModel::addCollaborator(const QString &name, const QString& photo)
@@ -89,12 +47,13 @@ void CollaboratorModel::addCollaborator(const QString &name, const QString& phot
 
 
     // Check if collaborator already exists in this project (database check)
-    auto checkQuery = db_->getBinder("SELECT COUNT(*) FROM collaborators WHERE name = :name AND project_id = :id");
-    checkQuery.bindValue(":name", name);
-    checkQuery.bindValue(":id", m_projectID);
-    if(checkQuery.exec() && checkQuery.next())
+    const auto checkQuery = db_->statement("SELECT COUNT(*) FROM collaborators WHERE name = :name AND project_id = :id");
+    checkQuery->bindValue(":name", name);
+    checkQuery->bindValue(":id", m_projectID);
+    if(checkQuery->exec() && checkQuery->next())
     {
-        int count = checkQuery.value(0).toInt();
+        int count = checkQuery->value(0).toInt();
+        checkQuery->finish();
         if(count > 0)
         {
             qWarning() << "[CollaboratorModel] collaborator already exists in this project:" << name;
@@ -112,62 +71,19 @@ void CollaboratorModel::addCollaborator(const QString &name, const QString& phot
     }
     tagName = tagName.arg(initials);
 
-    auto query = db_->getBinder("INSERT OR IGNORE INTO collaborators (name, tag_name, photo, project_id)"
-                                "VALUES (:name, :tag, :photo, :id)"
-                                );
-    query.bindValue(":name", name);
-    query.bindValue(":tag", tagName);
-    query.bindValue(":photo", photo);
-    query.bindValue(":id", m_projectID);
-    if(!query.exec())
-    {
-        qWarning() << "[CollaboratorModel] " << query.lastError();
-        return;
-    }
-
-    // Check if the insert actually added a row
-    if(query.numRowsAffected() == 0)
+    // the new row reaches the model through the change feed
+    if(db_->insertRow("collaborators", {"name", "tag_name", "photo", "project_id"},
+                      {name, tagName, photo, m_projectID}) < 0)
     {
-        qWarning() << "[CollaboratorModel] collaborator already exists (ignored):" << name;
-        return;
+        qWarning() << "[CollaboratorModel] failed to add collaborator:" << name;
     }
-
-    emit layoutChanged();
-
 }
 
 void CollaboratorModel::deleteCollaborator(int index)
 {
-    if(!col_map_.contains(index))
+    if(index < 0 || index >= rows().size())
         return;
-    
-    beginRemoveRows(QModelIndex(), index, index);
-    auto collaboratorId = col_map_[index].id;
-    auto query = QString("DELETE FROM collaborators WHERE id = %1").arg(collaboratorId);
-    db_->deleteItem(query);
-    
-    // Remove from map and reindex remaining items
-    col_map_.remove(index);
-    QMap<int, ColData> newMap;
-    int newIndex = 0;
-    for (auto it = col_map_.begin(); it != col_map_.end(); ++it) {
-        newMap[newIndex++] = it.value();
-    }
-    col_map_ = newMap;
-    
-    endRemoveRows();
-}
 
-
-
-
-
-QHash<int, QByteArray> CollaboratorModel::roleNames() const
-{
-    return {
-        {Name, "name"},
-        {Tag, "tag"},
-        {Photo, "photo"}
-    };
+    // the row is taken out by the change feed
+    db_->deleteByIds("collaborators", {rows().at(index).id});
 }
-
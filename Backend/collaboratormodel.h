@@ -5,9 +5,17 @@
 #include <QDebug>
 #include <QAbstractListModel>
 #include "database.h"
+#include "sqllistmodel.h"
 #include <QMap>
 namespace collab{
-class CollaboratorModel : public QAbstractListModel
+struct ColData{
+    int id;
+    QString name;
+    QString tag_name;
+    QString photo;
+};
+
+class CollaboratorModel : public SqlListModel<ColData>
 {
     Q_OBJECT
 public:
@@ -19,37 +27,21 @@ signals:
 
 
 public:
-    int rowCount(const QModelIndex &parent) const override;
-    QVariant data(const QModelIndex &index, int role) const override;
-
     Q_INVOKABLE void addCollaborator(const QString& name, const QString& photo="");
     Q_INVOKABLE void deleteCollaborator(int index);
 
+protected:
+    void refresh() override;
+    std::optional<ColData> fetchRow(int id) override;
 
 private:
-    DbmPtr db_;
     int m_projectID;
 
-    struct ColData{
-        int id;
-        QString name;
-        QString tag_name;
-        QString photo;
-    };
-
-
-
-    mutable QMap<int, ColData> col_map_;
-
     enum CollabRoles {
         Name = Qt::UserRole + 1,
         Tag,
         Photo,
     };
-
-
-public:
-    QHash<int, QByteArray> roleNames() const override;
 };
 
 }
@@ -8,10 +8,122 @@
 #include <QSharedDataPointer>
 #include <QFileInfo>
 #include <QDir>
+#include <QDebug>
+#include <QHash>
+#include <QVariantList>
+#include <QDate>
+#include <QDateTime>
+#include <QFuture>
+#include <QPromise>
+#include <QThread>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <list>
+#include <utility>
+#include <functional>
+#include "sqlworker.h"
+#include "sqlstats.h"
 
 class DatabaseManager;
 
+/**
+ * @brief Decodes a single result column into T.
+ *
+ * Dates are stored as ISO text, so QDate/QDateTime are parsed directly from the
+ * column instead of going through a generic QVariant conversion.
+ */
+template<typename T>
+struct SqlColumn {
+    static T decode(const QSqlQuery& query, int column) { return query.value(column).value<T>(); }
+};
+
+template<>
+struct SqlColumn<int> {
+    static int decode(const QSqlQuery& query, int column) { return query.value(column).toInt(); }
+};
+
+template<>
+struct SqlColumn<bool> {
+    static bool decode(const QSqlQuery& query, int column) { return query.value(column).toBool(); }
+};
+
+template<>
+struct SqlColumn<qint64> {
+    static qint64 decode(const QSqlQuery& query, int column) { return query.value(column).toLongLong(); }
+};
+
+template<>
+struct SqlColumn<double> {
+    static double decode(const QSqlQuery& query, int column) { return query.value(column).toDouble(); }
+};
+
+template<>
+struct SqlColumn<QString> {
+    static QString decode(const QSqlQuery& query, int column) { return query.value(column).toString(); }
+};
+
+template<>
+struct SqlColumn<QDate> {
+    static QDate decode(const QSqlQuery& query, int column)
+    {
+        // timestamps may carry a time part ("yyyy-MM-dd hh:mm"), only the date is needed
+        return QDate::fromString(query.value(column).toString().left(10), Qt::ISODate);
+    }
+};
+
+template<>
+struct SqlColumn<QDateTime> {
+    static QDateTime decode(const QSqlQuery& query, int column)
+    {
+        return QDateTime::fromString(query.value(column).toString(), Qt::ISODateWithMs);
+    }
+};
+
 typedef std::shared_ptr<DatabaseManager> DbmPtr;
+typedef QList<QVariantList> SqlRows;
+
+/**
+ * @brief One step of a schema upgrade, identified by its PRAGMA user_version.
+ */
+struct Migration {
+    int version;
+    QString description;
+    std::function<bool(DatabaseManager&)> apply;
+};
+
+/**
+ * @brief Journaling setup applied to a connection.
+ *
+ * Default keeps SQLite's rollback journal. Concurrent switches the file to WAL
+ * with a busy timeout, so readers on other connections (see readerForCurrentThread())
+ * do not block, and are not blocked by, the single writer.
+ */
+enum class StorageProfile {
+    Default,
+    Concurrent
+};
+
+enum class ChangeOp {
+    Insert,
+    Update,
+    Delete
+};
+
+/**
+ * @brief A row written through DatabaseManager's row API.
+ *
+ * rowid is the primary key of the row, or -1 when a statement touched rows
+ * whose keys are not known (e.g. insertBatch()); listeners reload the table then.
+ */
+struct ChangeEvent {
+    QString table;
+    qint64 rowid;
+    ChangeOp op;
+};
+
+typedef std::function<void(const ChangeEvent&)> ChangeListener;
+
 class DatabaseManager: public std::enable_shared_from_this<DatabaseManager>{
 public:
     DatabaseManager(const QString& connection_name)
@@ -26,6 +138,13 @@ public:
         connect(db_path);
     }
 
+    ~DatabaseManager()
+    {
+        QMutexLocker locker(&readersMutex_);
+        for (auto it = readers_.begin(); it != readers_.end(); ++it)
+            QObject::disconnect(it->cleanup);
+    }
+
     DbmPtr getSharedPtr()
     {
         return shared_from_this();
@@ -60,6 +179,79 @@ public:
         return query;
     }
 
+    /**
+     * @brief Returns a prepared statement from the per-connection cache.
+     *
+     * The statement is compiled by SQLite the first time it is seen and reused
+     * on later calls; the least recently used entry is evicted once the cache
+     * holds more than statementCacheCapacity() statements. Use positional
+     * (?) or named placeholders and rebind every value before exec().
+     *
+     * Hold the returned pointer for as long as the query runs: eviction only
+     * drops the cache's reference. While a caller holds an entry it is in use,
+     * and a re-entrant call for the same SQL (e.g. from a forEachRow() callback)
+     * gets a fresh uncached query instead of resetting the running cursor.
+     */
+    std::shared_ptr<QSqlQuery> statement(const QString& sql)
+    {
+        auto it = statements_.find(sql);
+        if (it != statements_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->position);
+            if (!it->inUse())
+                return it->query;
+            return prepareStatement(sql);
+        }
+
+        CachedStatement entry;
+        entry.query = prepareStatement(sql);
+        lru_.push_front(sql);
+        entry.position = lru_.begin();
+        auto query = entry.query;
+        statements_.insert(sql, entry);
+
+        while (statements_.size() > statementCapacity_) {
+            statements_.remove(lru_.back());
+            lru_.pop_back();
+        }
+        return query;
+    }
+
+    void setStatementCacheCapacity(int capacity)
+    {
+        statementCapacity_ = qMax(1, capacity);
+        while (statements_.size() > statementCapacity_) {
+            statements_.remove(lru_.back());
+            lru_.pop_back();
+        }
+    }
+
+    int statementCacheCapacity() const { return statementCapacity_; }
+    int statementCacheSize() const { return statements_.size(); }
+
+    void clearStatementCache()
+    {
+        statements_.clear();
+        lru_.clear();
+    }
+
+    bool exec(const QString& sql, const QVariantList& params = {})
+    {
+        const auto query = statement(sql);
+        for (int i = 0; i < params.size(); ++i)
+            query->bindValue(i, params.at(i));
+
+        QElapsedTimer timer;
+        timer.start();
+        if (!query->exec()) {
+            qWarning() << "Error: Failed to execute statement:" << query->lastError().text();
+            return false;
+        }
+        const int affected = query->numRowsAffected();
+        query->finish();
+        recordStatement(sql, params, timer.nsecsElapsed() / 1000, qMax(0, affected));
+        return true;
+    }
+
 
 
     bool connect(const QString& db_path)
@@ -75,24 +267,166 @@ public:
             qDebug() << "Created directory for database:" << dir.path();
         }
 
+        // Cached statements belong to the previous database file
+        clearStatementCache();
         db_.setDatabaseName(db_path);
 
+        if (readOnly_)
+            db_.setConnectOptions(QString("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=%1").arg(busyTimeout_));
+
         if (!db_.open()) {
             qWarning() << "Error: Failed to connect to database:" << db_.lastError().text();
             return false;
         }
+        if (!readOnly_)
+            applyStorageProfile();
+        if (worker_) {
+            worker_->open(db_path);
+            syncWorkerProfile();
+        }
         return true;
     }
 
+    /**
+     * @brief Select the journaling profile; re-applied on every connect().
+     * @param busyTimeoutMs how long a statement waits on a locked database
+     */
+    bool setStorageProfile(StorageProfile profile, int busyTimeoutMs = 5000)
+    {
+        profile_ = profile;
+        busyTimeout_ = busyTimeoutMs;
+        syncWorkerProfile();
+        return !db_.isOpen() || applyStorageProfile();
+    }
+
+    StorageProfile storageProfile() const { return profile_; }
+
+    /**
+     * @brief Open the connection read-only on the next connect()
+     */
+    void setReadOnly(bool readOnly) { readOnly_ = readOnly; }
+    bool isReadOnly() const { return readOnly_; }
+
+    /**
+     * @brief Upper bound of pooled read-only connections (one per thread)
+     */
+    void setReaderPoolLimit(int limit) { readerLimit_ = qMax(1, limit); }
+    int readerCount() const
+    {
+        QMutexLocker locker(&readersMutex_);
+        return readers_.size();
+    }
+
+    /**
+     * @brief Read-only connection owned by the calling thread.
+     *
+     * Background jobs use this to read through their own connection while the
+     * UI keeps writing through this one. The connection is created on first use,
+     * reopened when the database file changes and removed when the thread
+     * finishes. Returns nullptr once the pool limit is reached.
+     */
+    DbmPtr readerForCurrentThread()
+    {
+        QThread* thread = QThread::currentThread();
+        QMutexLocker locker(&readersMutex_);
+
+        auto it = readers_.find(thread);
+        if (it != readers_.end()) {
+            if (it->db->database().databaseName() != db_.databaseName())
+                it->db->connect(db_.databaseName());
+            return it->db;
+        }
+
+        if (readers_.size() >= readerLimit_) {
+            qWarning() << "[DatabaseManager] read pool exhausted for" << connectionName();
+            return nullptr;
+        }
+
+        const QString name = QString("%1_reader_%2").arg(connectionName())
+                                 .arg(quintptr(thread), 0, 16);
+        Reader reader;
+        reader.db = std::make_shared<DatabaseManager>(name);
+        reader.db->busyTimeout_ = busyTimeout_;
+        reader.db->stats_ = stats_;
+        reader.db->setReadOnly(true);
+        reader.db->connect(db_.databaseName());
+
+        // finished is emitted on the thread itself, so the connection is removed where it lives
+        reader.cleanup = QObject::connect(thread, &QThread::finished, thread, [this, thread, name]() {
+            {
+                QMutexLocker locker(&readersMutex_);
+                readers_.remove(thread);
+            }
+            QSqlDatabase::removeDatabase(name);
+        }, Qt::DirectConnection);
+
+        readers_.insert(thread, reader);
+        return reader.db;
+    }
+
+    /**
+     * @brief Start a worker thread with its own connection to the same file.
+     *
+     * Afterwards the *Async() calls run on that thread instead of blocking the
+     * caller; without it they execute synchronously and return a finished future.
+     */
+    void enableAsync()
+    {
+        if (worker_)
+            return;
+        worker_ = std::make_unique<SqlWorker>(connectionName() + "_worker");
+        auto stats = stats_;
+        worker_->post([stats](DatabaseManager& db) { db.setStats(stats); });
+        if (db_.isOpen())
+            worker_->open(db_.databaseName());
+        syncWorkerProfile();
+    }
+
+    bool isAsync() const { return worker_ != nullptr; }
+
+    QFuture<SqlRows> queryAsync(const QString& selectSql, const QVariantList& params = {})
+    {
+        if (!worker_)
+            return readyFuture(queryRows(selectSql, params));
+        return worker_->run<SqlRows>([selectSql, params](DatabaseManager& db) {
+            return db.queryRows(selectSql, params);
+        });
+    }
+
+    QFuture<bool> execAsync(const QString& sql, const QVariantList& params = {})
+    {
+        if (!worker_)
+            return readyFuture(exec(sql, params));
+        return worker_->run<bool>([sql, params](DatabaseManager& db) {
+            return db.exec(sql, params);
+        });
+    }
+
+    /**
+     * @brief Asynchronous selectRows(); decoding happens on the worker thread.
+     */
+    template<typename Row, typename... Ts>
+    QFuture<QList<Row>> selectRowsAsync(const QString& selectSql, const QVariantList& params = {})
+    {
+        if (!worker_)
+            return readyFuture(selectRows<Row, Ts...>(selectSql, params));
+        return worker_->run<QList<Row>>([selectSql, params](DatabaseManager& db) {
+            return db.selectRows<Row, Ts...>(selectSql, params);
+        });
+    }
+
     QStringList queryRow(const QString& selectSql)
     {
         QStringList result;
         QSqlQuery query(db_);
 
+        QElapsedTimer timer;
+        timer.start();
         if (!query.exec(selectSql)) {
             qWarning() << "Error: Failed to execute query:" << query.lastError().text();
             return result;
         }
+        int rowCount = 0;
 
 
         // --- Fix applied here ---
@@ -108,14 +442,148 @@ public:
             for(int i = 0; i < columnCount; ++i) { // Use the correct column count
                 result << query.value(i).toString();
             }
+            ++rowCount;
             // If you only intend to read the first row, uncomment the line below:
             // break;
         }
+        query.finish();
+        recordStatement(selectSql, {}, timer.nsecsElapsed() / 1000, rowCount);
+
+        return result;
+    }
+
+    QStringList queryRow(const QString& selectSql, const QVariantList& params)
+    {
+        QStringList result;
+        const auto query = statement(selectSql);
+        for (int i = 0; i < params.size(); ++i)
+            query->bindValue(i, params.at(i));
+
+        QElapsedTimer timer;
+        timer.start();
+        if (!query->exec()) {
+            qWarning() << "Error: Failed to execute query:" << query->lastError().text();
+            return result;
+        }
+
+        int columnCount = query->record().count();
+        int rowCount = 0;
+        while (query->next()) {
+            for(int i = 0; i < columnCount; ++i)
+                result << query->value(i).toString();
+            ++rowCount;
+        }
+        // release the read cursor so the cached statement can be reused
+        query->finish();
+        recordStatement(selectSql, params, timer.nsecsElapsed() / 1000, rowCount);
+
+        return result;
+    }
+
+
+    /**
+     * @brief Streams the rows of a SELECT into a callback with typed columns.
+     *
+     * Column i is decoded as the i-th type of Ts, e.g.
+     * forEachRow<int, QString>(sql, {pid}, [](int id, const QString& title) {...});
+     * @return false if the statement failed
+     */
+    template<typename... Ts, typename Fn>
+    bool forEachRow(const QString& selectSql, const QVariantList& params, Fn&& fn)
+    {
+        const auto query = statement(selectSql);
+        for (int i = 0; i < params.size(); ++i)
+            query->bindValue(i, params.at(i));
+
+        QElapsedTimer timer;
+        timer.start();
+        if (!query->exec()) {
+            qWarning() << "Error: Failed to execute query:" << query->lastError().text();
+            return false;
+        }
+
+        int rowCount = 0;
+        while (query->next()) {
+            invokeRow<Ts...>(*query, fn, std::index_sequence_for<Ts...>{});
+            ++rowCount;
+        }
+        query->finish();
+        recordStatement(selectSql, params, timer.nsecsElapsed() / 1000, rowCount);
+        return true;
+    }
+
+    /**
+     * @brief Collects every row of a SELECT into aggregate Row{Ts...} values.
+     */
+    template<typename Row, typename... Ts>
+    QList<Row> selectRows(const QString& selectSql, const QVariantList& params = {})
+    {
+        QList<Row> rows;
+        forEachRow<Ts...>(selectSql, params, [&rows](Ts... values) {
+            rows.append(Row{std::move(values)...});
+        });
+        return rows;
+    }
+
+    /**
+     * @brief Returns every row of a SELECT as a list of column values.
+     */
+    SqlRows queryRows(const QString& selectSql, const QVariantList& params = {})
+    {
+        SqlRows rows;
+        const auto query = statement(selectSql);
+        for (int i = 0; i < params.size(); ++i)
+            query->bindValue(i, params.at(i));
+
+        QElapsedTimer timer;
+        timer.start();
+        if (!query->exec()) {
+            qWarning() << "Error: Failed to execute query:" << query->lastError().text();
+            return rows;
+        }
 
+        int columnCount = query->record().count();
+        while (query->next()) {
+            QVariantList row;
+            row.reserve(columnCount);
+            for (int i = 0; i < columnCount; ++i)
+                row << query->value(i);
+            rows << row;
+        }
+        query->finish();
+        recordStatement(selectSql, params, timer.nsecsElapsed() / 1000, rows.size());
+        return rows;
+    }
 
+    /**
+     * @brief Returns the first column of the first row, or fallback when empty.
+     */
+    template<typename T>
+    T selectValue(const QString& selectSql, const QVariantList& params = {}, const T& fallback = T())
+    {
+        T result = fallback;
+        bool found = false;
+        forEachRow<T>(selectSql, params, [&](T value) {
+            if (!found)
+                result = std::move(value);
+            found = true;
+        });
         return result;
     }
 
+    /**
+     * @brief Per-statement latency counters and the slow-query log.
+     *
+     * Shared with the worker and reader connections of this manager.
+     */
+    SqlStats& stats() { return *stats_; }
+    std::shared_ptr<SqlStats> sharedStats() const { return stats_; }
+
+    void setStats(std::shared_ptr<SqlStats> stats)
+    {
+        if (stats)
+            stats_ = std::move(stats);
+    }
 
     const QSqlDatabase& database() const { return db_; }
     QSqlDatabase& database() { return db_; }
@@ -147,7 +615,290 @@ public:
         return true;
     }
 
+    /**
+     * @brief RAII transaction scope.
+     *
+     * The transaction begins on construction and is rolled back on destruction
+     * unless commit() was called. Scopes nest: inner scopes map to SAVEPOINTs, so
+     * a helper that opens its own Transaction can run inside a caller's.
+     */
+    class Transaction
+    {
+    public:
+        explicit Transaction(DatabaseManager& dbm)
+            : dbm_(dbm), depth_(dbm.transactionDepth_), changeMark_(dbm.pendingChanges_.size())
+        {
+            QSqlQuery query(dbm_.db_);
+            active_ = depth_ == 0 ? dbm_.db_.transaction()
+                                  : query.exec(QString("SAVEPOINT sp_%1").arg(depth_));
+            if (!active_) {
+                qWarning() << "Error: Failed to begin transaction:" << dbm_.db_.lastError().text();
+                return;
+            }
+            ++dbm_.transactionDepth_;
+        }
+
+        ~Transaction()
+        {
+            if (active_)
+                rollback();
+        }
+
+        Transaction(const Transaction&) = delete;
+        Transaction& operator=(const Transaction&) = delete;
+
+        bool commit()
+        {
+            if (!active_)
+                return false;
+            active_ = false;
+            --dbm_.transactionDepth_;
+
+            QSqlQuery query(dbm_.db_);
+            bool ok = depth_ == 0 ? dbm_.db_.commit()
+                                  : query.exec(QString("RELEASE sp_%1").arg(depth_));
+            if (!ok) {
+                qWarning() << "Error: Failed to commit transaction:" << dbm_.db_.lastError().text();
+                // e.g. SQLITE_BUSY: the SQL transaction is still open, close it so the
+                // connection can begin the next one
+                if (depth_ == 0) {
+                    dbm_.db_.rollback();
+                } else {
+                    query.exec(QString("ROLLBACK TO sp_%1").arg(depth_));
+                    query.exec(QString("RELEASE sp_%1").arg(depth_));
+                    while (dbm_.pendingChanges_.size() > changeMark_)
+                        dbm_.pendingChanges_.removeLast();
+                }
+            }
+            // changes are published once the outermost scope is durable
+            if (depth_ == 0) {
+                if (ok)
+                    dbm_.flushChanges();
+                else
+                    dbm_.pendingChanges_.clear();
+            }
+            return ok;
+        }
+
+        void rollback()
+        {
+            if (!active_)
+                return;
+            active_ = false;
+            --dbm_.transactionDepth_;
 
+            // forget the changes made inside this scope
+            while (dbm_.pendingChanges_.size() > changeMark_)
+                dbm_.pendingChanges_.removeLast();
+
+            QSqlQuery query(dbm_.db_);
+            if (depth_ == 0) {
+                dbm_.db_.rollback();
+            } else {
+                query.exec(QString("ROLLBACK TO sp_%1").arg(depth_));
+                query.exec(QString("RELEASE sp_%1").arg(depth_));
+            }
+        }
+
+        bool isActive() const { return active_; }
+
+    private:
+        DatabaseManager& dbm_;
+        int depth_;
+        qsizetype changeMark_;
+        bool active_ = false;
+    };
+
+    /**
+     * @brief Insert one row and publish a ChangeOp::Insert event for it.
+     * @return the rowid of the new row, or -1 on failure
+     */
+    qint64 insertRow(const QString& table, const QStringList& columns, const QVariantList& values)
+    {
+        QStringList placeholders;
+        for (int i = 0; i < columns.size(); ++i)
+            placeholders << "?";
+        const QString sql = QString("INSERT INTO \"%1\" (%2) VALUES (%3)")
+                                .arg(table, columns.join(", "), placeholders.join(", "));
+        const auto query = statement(sql);
+        for (int i = 0; i < values.size(); ++i)
+            query->bindValue(i, values.at(i));
+
+        QElapsedTimer timer;
+        timer.start();
+        if (!query->exec()) {
+            qWarning() << "Error: Failed to insert into" << table << ":" << query->lastError().text();
+            return -1;
+        }
+        // lastInsertId() is only available while the query is active
+        const qint64 rowid = query->lastInsertId().toLongLong();
+        query->finish();
+        recordStatement(sql, values, timer.nsecsElapsed() / 1000, 1);
+
+        notifyChange(table, rowid, ChangeOp::Insert);
+        return rowid;
+    }
+
+    /**
+     * @brief Update columns of the row with the given id and publish ChangeOp::Update.
+     */
+    bool updateRow(const QString& table, qint64 id, const QStringList& columns, const QVariantList& values)
+    {
+        QStringList assignments;
+        for (const auto& column : columns)
+            assignments << column + " = ?";
+        const QString sql = QString("UPDATE \"%1\" SET %2 WHERE id = ?")
+                                .arg(table, assignments.join(", "));
+        QVariantList params = values;
+        params << id;
+        if (!exec(sql, params))
+            return false;
+
+        notifyChange(table, id, ChangeOp::Update);
+        return true;
+    }
+
+    /**
+     * @brief Receive a ChangeEvent for every row written through this connection.
+     *
+     * Events are raised by insertRow(), updateRow(), deleteByIds() and
+     * insertBatch(), or by notifyChange() for hand written statements. Inside a
+     * Transaction they are held back until the outermost scope commits and are
+     * dropped on rollback. Listeners run on the thread that made the change.
+     * @param table table to watch, empty for every table
+     * @return handle for unsubscribe()
+     */
+    int subscribe(const QString& table, ChangeListener listener)
+    {
+        const int id = ++lastSubscription_;
+        subscriptions_.append({id, table, std::move(listener)});
+        return id;
+    }
+
+    void unsubscribe(int id)
+    {
+        subscriptions_.removeIf([id](const Subscription& s) { return s.id == id; });
+    }
+
+    void notifyChange(const QString& table, qint64 rowid, ChangeOp op)
+    {
+        pendingChanges_.append({table, rowid, op});
+        if (transactionDepth_ == 0)
+            flushChanges();
+    }
+
+    /**
+     * @brief Insert many rows with one prepared statement inside one transaction.
+     * @param rows one QVariantList per row, in the order of columns
+     */
+    bool insertBatch(const QString& table, const QStringList& columns, const QList<QVariantList>& rows)
+    {
+        if (rows.isEmpty())
+            return true;
+
+        QStringList placeholders;
+        for (int i = 0; i < columns.size(); ++i)
+            placeholders << "?";
+        const QString sql = QString("INSERT INTO \"%1\" (%2) VALUES (%3)")
+                                .arg(table, columns.join(", "), placeholders.join(", "));
+
+        // execBatch() takes the values column by column
+        QList<QVariantList> columnValues(columns.size());
+        for (const auto& row : rows) {
+            for (int c = 0; c < columns.size(); ++c)
+                columnValues[c] << row.value(c);
+        }
+
+        Transaction transaction(*this);
+        const auto query = statement(sql);
+        for (int c = 0; c < columns.size(); ++c)
+            query->bindValue(c, columnValues.at(c));
+
+        QElapsedTimer timer;
+        timer.start();
+        if (!query->execBatch()) {
+            qWarning() << "Error: Failed to insert batch into" << table << ":" << query->lastError().text();
+            return false;
+        }
+        query->finish();
+        recordStatement(sql, rows.first(), timer.nsecsElapsed() / 1000, rows.size());
+        notifyChange(table, -1, ChangeOp::Insert);
+        return transaction.commit();
+    }
+
+    /**
+     * @brief Delete rows by primary key using DELETE ... WHERE id IN (...).
+     */
+    bool deleteByIds(const QString& table, const QList<int>& ids)
+    {
+        if (ids.isEmpty())
+            return true;
+
+        // stay well below SQLITE_MAX_VARIABLE_NUMBER
+        const int chunkSize = 500;
+
+        Transaction transaction(*this);
+        for (int offset = 0; offset < ids.size(); offset += chunkSize) {
+            const QList<int> chunk = ids.mid(offset, chunkSize);
+            QStringList placeholders;
+            for (int i = 0; i < chunk.size(); ++i)
+                placeholders << "?";
+
+            QSqlQuery query(db_);
+            query.prepare(QString("DELETE FROM \"%1\" WHERE id IN (%2)").arg(table, placeholders.join(", ")));
+            for (int i = 0; i < chunk.size(); ++i)
+                query.bindValue(i, chunk.at(i));
+
+            QElapsedTimer timer;
+            timer.start();
+            if (!query.exec()) {
+                qWarning() << "Error: Failed to delete from" << table << ":" << query.lastError().text();
+                return false;
+            }
+            recordStatement(query.lastQuery(), QVariantList(chunk.begin(), chunk.end()),
+                            timer.nsecsElapsed() / 1000, qMax(0, query.numRowsAffected()));
+        }
+        for (int id : ids)
+            notifyChange(table, id, ChangeOp::Delete);
+        return transaction.commit();
+    }
+
+
+
+    int schemaVersion()
+    {
+        return selectValue<int>("PRAGMA user_version");
+    }
+
+    /**
+     * @brief Bring the schema up to the newest version in migrations.
+     *
+     * Every migration with a version above PRAGMA user_version runs in its own
+     * transaction together with the version bump, so an upgrade that fails
+     * half way leaves the database at the last completed version.
+     */
+    bool migrate(const QList<Migration>& migrations)
+    {
+        int current = schemaVersion();
+        for (const auto& migration : migrations) {
+            if (migration.version <= current)
+                continue;
+
+            Transaction transaction(*this);
+            QSqlQuery query(db_);
+            if (!migration.apply(*this)
+                || !query.exec(QString("PRAGMA user_version = %1").arg(migration.version))
+                || !transaction.commit()) {
+                qWarning() << "[DatabaseManager] Migration" << migration.version
+                           << migration.description << "failed on" << connectionName();
+                return false;
+            }
+            current = migration.version;
+            qDebug() << "[DatabaseManager] Migrated" << connectionName() << "to version" << current
+                     << "-" << migration.description;
+        }
+        return true;
+    }
 
     int queryCount(const QString& topic, const QString& table, const QString& constraint)
     {
@@ -290,7 +1041,135 @@ public:
 
 
 private:
+    bool applyStorageProfile()
+    {
+        QSqlQuery query(db_);
+        bool ok = query.exec(QString("PRAGMA busy_timeout = %1").arg(busyTimeout_));
+        if (profile_ == StorageProfile::Concurrent) {
+            ok &= query.exec("PRAGMA journal_mode = WAL");
+            // WAL keeps durability at the checkpoint, NORMAL avoids an fsync per commit
+            ok &= query.exec("PRAGMA synchronous = NORMAL");
+        }
+        if (!ok)
+            qWarning() << "[DatabaseManager] Failed to apply storage profile:" << query.lastError().text();
+        return ok;
+    }
+
+    void recordStatement(const QString& sql, const QVariantList& params, qint64 elapsedUs, int rows)
+    {
+        stats_->record(sql, elapsedUs, rows);
+        if (!stats_->isSlow(elapsedUs))
+            return;
+
+        QStringList plan;
+        static const QRegularExpression explainable("^\\s*(SELECT|WITH|INSERT|REPLACE|UPDATE|DELETE)\\b",
+                                                    QRegularExpression::CaseInsensitiveOption);
+        if (explainable.match(sql).hasMatch()) {
+            QSqlQuery explain(db_);
+            explain.prepare("EXPLAIN QUERY PLAN " + sql);
+            for (int i = 0; i < params.size(); ++i)
+                explain.bindValue(i, params.at(i));
+            if (explain.exec()) {
+                // columns: id, parent, notused, detail
+                while (explain.next())
+                    plan << explain.value(3).toString();
+            } else {
+                plan << "plan unavailable: " + explain.lastError().text();
+            }
+        }
+        stats_->recordSlow(sql, elapsedUs, rows, plan);
+        qWarning() << "[DatabaseManager] Slow query on" << connectionName() << elapsedUs / 1000 << "ms:"
+                   << sql.simplified() << plan;
+    }
+
+    void flushChanges()
+    {
+        const QList<ChangeEvent> changes = std::exchange(pendingChanges_, {});
+        for (const auto& change : changes) {
+            // a listener may subscribe or unsubscribe while being notified
+            const QList<Subscription> subscriptions = subscriptions_;
+            for (const auto& s : subscriptions) {
+                if (s.table.isEmpty() || s.table == change.table)
+                    s.listener(change);
+            }
+        }
+    }
+
+    void syncWorkerProfile()
+    {
+        if (!worker_)
+            return;
+        const StorageProfile profile = profile_;
+        const int timeout = busyTimeout_;
+        worker_->post([profile, timeout](DatabaseManager& db) {
+            db.setStorageProfile(profile, timeout);
+        });
+    }
+
+    template<typename T>
+    static QFuture<T> readyFuture(T value)
+    {
+        QPromise<T> promise;
+        QFuture<T> future = promise.future();
+        promise.start();
+        promise.addResult(std::move(value));
+        promise.finish();
+        return future;
+    }
+
+    template<typename... Ts, typename Fn, std::size_t... I>
+    static void invokeRow(const QSqlQuery& query, Fn& fn, std::index_sequence<I...>)
+    {
+        fn(SqlColumn<Ts>::decode(query, int(I))...);
+    }
+
+    struct CachedStatement {
+        std::shared_ptr<QSqlQuery> query;
+        std::list<QString>::iterator position;
+
+        // a caller still holds the query besides the cache
+        bool inUse() const { return query.use_count() > 1; }
+    };
+
+    std::shared_ptr<QSqlQuery> prepareStatement(const QString& sql)
+    {
+        auto query = std::make_shared<QSqlQuery>(db_);
+        query->setForwardOnly(true);
+        if (!query->prepare(sql))
+            qWarning() << "Error: Failed to prepare statement:" << query->lastError().text();
+        return query;
+    }
+
     QSqlDatabase db_;
+    // declared after db_ so cached statements are finalized first
+    QHash<QString, CachedStatement> statements_;
+    std::list<QString> lru_;
+    int statementCapacity_ = 64;
+
+    StorageProfile profile_ = StorageProfile::Default;
+    int busyTimeout_ = 5000;
+    bool readOnly_ = false;
+    int transactionDepth_ = 0;
+
+    struct Reader {
+        DbmPtr db;
+        QMetaObject::Connection cleanup;
+    };
+    mutable QMutex readersMutex_;
+    QHash<QThread*, Reader> readers_;
+    int readerLimit_ = 4;
+    std::shared_ptr<SqlStats> stats_ = std::make_shared<SqlStats>();
+
+    struct Subscription {
+        int id;
+        QString table;
+        ChangeListener listener;
+    };
+    QList<Subscription> subscriptions_;
+    int lastSubscription_ = 0;
+    QList<ChangeEvent> pendingChanges_;
+    // declared last so the worker connection closes before anything else
+    std::unique_ptr<SqlWorker> worker_;
 };
 
 
@@ -1,11 +1,10 @@
 #include "deadlinemodel.h"
-#include <QJsonArray>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonParseError>
 using namespace project;
 DeadlineModel::DeadlineModel(DbmPtr db, QObject *parent)
-    : QAbstractTableModel{parent}, db_(db)
+    : EventTableModel(db, "calendars", {
+          bindRole<&EventRow::date>(DateRole, "date"),
+          bindRole<&EventRow::name>(NameRole, "event")
+      }, parent)
 {
     m_projectId = -1;
 }
@@ -14,31 +13,30 @@ void DeadlineModel::projectIdChanged(int id)
 {
     // qInfo() << "[DeadlineModel] projectIdChanged " << id;
     m_projectId = id;
-    emit layoutChanged();
+    refresh();
 }
 
 void DeadlineModel::deleteRow(int id)
 {
-    if(!event_map_.contains(id))
+    if(id < 0 || id >= rows().size())
         return;
 
-    int id_ = event_map_[id].id;
-    QString sqlCmd= QString("DELETE FROM calendars WHERE id = %1").arg(id_);
-    if(db_->deleteItem(sqlCmd))
+    int id_ = rows().at(id).id;
+    // the row is taken out by the change feed
+    if(db_->deleteByIds("calendars", {id_}))
     {
         qInfo() << "[DeadlineModel] success ";
     }
     else{
-        qInfo() << sqlCmd;
+        qInfo() << "[DeadlineModel] failed to delete event " << id_;
     }
-    emit layoutChanged();
 }
 
 QString DeadlineModel::getEventCountdown(int indx)
 {
-    if(!event_map_.contains(indx))
+    if(indx < 0 || indx >= rows().size())
         return "event not found";
-    auto event = event_map_[indx];
+    const auto& event = rows().at(indx);
 
     QDate currentDate = QDate::currentDate();
     auto eventDate = event.date;
@@ -55,35 +53,67 @@ QString DeadlineModel::getEventCountdown(int indx)
 
 }
 
-int DeadlineModel::rowCount(const QModelIndex &parent) const
+void DeadlineModel::refresh()
 {
-    if(m_projectId < 0) return 0;
-
-    QString sqlCmd= QString("SELECT id, timestamp, event FROM calendars WHERE project_id = %1").arg(m_projectId);
-    auto results = db_->queryRow(sqlCmd);
-    event_map_.clear();
-    int index = 0;
-    for(int i =0; i < results.size(); i+=3)
+    const int generation = ++m_generation;
+    if(m_projectId < 0)
     {
-        int j = i + 1;
-        int k = i + 2;
+        applyRows({});
+        return;
+    }
+
+    m_loading = true;
+    db_->selectRowsAsync<EventRow, int, QDate, QString>(
+           "SELECT id, timestamp, event FROM calendars WHERE project_id = ? ORDER BY id", {m_projectId})
+        .then(this, [this, generation](QList<EventRow> rows) {
+            if(generation == m_generation)
+                applyRows(rows);
+        });
+}
+
+void DeadlineModel::applyRows(const QList<EventRow> &rows)
+{
+    m_loading = false;
+    setRows(rows);
+}
 
-        EventData event;
-        event.index = index;
-        event.id = results[i].toInt();
-        event.date = QDate::fromString(results[j], Qt::ISODate);
-        event.name = results[k];
-        event_map_[index] = event;
+std::optional<EventRow> DeadlineModel::fetchRow(int id)
+{
+    const auto found = db_->selectRows<EventRow, int, QDate, QString>(
+        "SELECT id, timestamp, event FROM calendars WHERE id = ? AND project_id = ?", {id, m_projectId});
+    if(found.isEmpty())
+        return std::nullopt;
+    return found.first();
+}
 
-        index++;
+void DeadlineModel::applyChange(const ChangeEvent &change)
+{
+    if(m_projectId < 0)
+        return;
+    // a reload in flight may predate this change, so load again instead
+    if(m_loading)
+    {
+        refresh();
+        return;
     }
-    // qInfo() << "[DeadlineModel] data " << data_;
-    return event_map_.size();
+    EventTableModel::applyChange(change);
+}
+
+bool DeadlineModel::needsReset(int from, int to) const
+{
+    // columnCount() drops to 0 without rows
+    return (from == 0) != (to == 0);
+}
+
+void DeadlineModel::rowsChanged(int first, int last, const QList<int> &roles)
+{
+    Q_UNUSED(roles);
+    emit dataChanged(index(first, 0), index(last, 1), {Qt::DisplayRole});
 }
 
 int DeadlineModel::columnCount(const QModelIndex &parent) const
 {
-    return (event_map_.isEmpty()) ? 0 : 2;
+    return (rows().isEmpty()) ? 0 : 2;
 }
 
 QVariant DeadlineModel::data(const QModelIndex &index, int role) const
@@ -93,10 +123,10 @@ QVariant DeadlineModel::data(const QModelIndex &index, int role) const
 
     int row = index.row();
     int col = index.column();
-    if(role != Qt::DisplayRole || !event_map_.contains(row))
+    if(role != Qt::DisplayRole || row >= rows().size())
         return QVariant();
 
-    auto event = event_map_[row];
+    const auto& event = rows().at(row);
 
     switch (col) {
     case 1:
@@ -125,61 +155,27 @@ void DeadlineModel::setDeadlineTxt(const QString &newDeadlineTxt)
 {
     if (m_deadlineTxt == newDeadlineTxt || newDeadlineTxt.isEmpty())
         return;
-    auto result = DeadlineParser::parseDeadlines(newDeadlineTxt);
-    m_deadlineTxt = result.first;
+    bool ok = false;
+    const QList<Deadline> deadlines = DeadlineParser::parse(newDeadlineTxt, &ok);
+    if (!ok) {
+        // shown back so the user can fix the paste
+        m_deadlineTxt = "[INVALID TEXT]\n\n" + newDeadlineTxt;
+        emit deadlineTxtChanged();
+        return;
+    }
 
+    // the parser already dropped duplicates within the paste
+    QList<QVariantList> inserts;
+    inserts.reserve(deadlines.size());
+    for (const Deadline &deadline : deadlines)
+        inserts.append({deadline.date.toString(Qt::ISODate), deadline.event, m_projectId});
+    qInfo() << "[DeadlineModel] inserting" << inserts.size() << "deadlines to database";
 
-    if (result.second != ParserState::PROMPT_USER)
-    {
-        qInfo() << "[DeadlineModel] inserting to database " << result.first;
-        QJsonParseError error;
-        QJsonDocument doc =
-            QJsonDocument::fromJson(result.first.toUtf8(), &error);
-
-        if (error.error != QJsonParseError::NoError) {
-            qWarning() << "JSON parse error:" << error.errorString();
-            return;
-        }
-
-        if (!doc.isArray()) {
-            qWarning() << "Expected JSON array";
-            return;
-        }
-
-        QJsonArray array = doc.array();
-        for (const QJsonValue &val : array) {
-            QJsonObject obj = val.toObject();
-            QString dateTxt  = obj["date"].toString();
-            QString event = obj["event"].toString();
-
-            QDate date = QDate::fromString(dateTxt, Qt::ISODate);
-            if (!date.isValid()) {
-                qWarning() << "[DeadlineModel] Invalid date:" << dateTxt;
-                continue;
-            }
-            QString isoString = date.toString(Qt::ISODate);
-
-            // qDebug() << "[DeadlineModel]: Date:" << isoString << "Event:" << event;
-            // QString sqlCmd = QString("INSERT INTO calendars (timestamp, event, project_id) VALUES ('%1', '%2', %3)")
-            //                  .arg(isoString)
-            //                  .arg(event)
-            //                      .arg(m_projectId);
-
-            // db_->updateDB(sqlCmd);
-
-            auto query = db_->getBinder(
-                "INSERT INTO calendars (timestamp, event, project_id) "
-                "VALUES (:time, :event, :pid)"
-                );
-
-            query.bindValue(":time", isoString);
-            query.bindValue(":event", event);
-            query.bindValue(":pid", m_projectId);
-            query.exec();
-        }
-        m_deadlineTxt = "";
-    }
+    // one transaction for the whole paste instead of one commit per deadline;
+    // the change feed reloads the model afterwards
+    if (!inserts.isEmpty() && !db_->insertBatch("calendars", {"timestamp", "event", "project_id"}, inserts))
+        qWarning() << "[DeadlineModel] failed to insert" << inserts.size() << "deadlines";
+    m_deadlineTxt = "";
 
     emit deadlineTxtChanged();
-    emit layoutChanged();
 }
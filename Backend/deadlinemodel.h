@@ -9,9 +9,18 @@
 #include <QDateTime>
 #include "database.h"
 #include "deadlineparser.h"
+#include "sqllistmodel.h"
 
 namespace project{
-    class DeadlineModel : public QAbstractTableModel
+    struct EventRow{
+        int id;
+        QDate date;
+        QString name;
+    };
+
+    using EventTableModel = SqlListModel<EventRow, QAbstractTableModel>;
+
+    class DeadlineModel : public EventTableModel
     {
         Q_OBJECT
         Q_PROPERTY(QString deadlineTxt READ deadlineTxt WRITE setDeadlineTxt NOTIFY deadlineTxtChanged FINAL)
@@ -25,28 +34,35 @@ namespace project{
 
         void deadlineTxtChanged();
 
+    protected:
+        void refresh() override;
+        std::optional<EventRow> fetchRow(int id) override;
+        void applyChange(const ChangeEvent& change) override;
+        bool needsReset(int from, int to) const override;
+        void rowsChanged(int first, int last, const QList<int>& roles) override;
+
     private:
-        DbmPtr db_;
         int m_projectId;
 
-        struct EventData{
-            int index;
-            int id;
-            QDate date;
-            QString name;
+        // roles only used to detect changed rows; the view reads columns
+        enum EventRoles {
+            DateRole = Qt::UserRole + 1,
+            NameRole
         };
 
-        mutable QMap<int, EventData> event_map_;
+        int m_generation = 0;
+        bool m_loading = false;
+
+        void applyRows(const QList<EventRow>& rows);
 
 
         // QAbstractItemModel interface
         QString m_deadlineTxt;
 
     public:
-        int rowCount(const QModelIndex &parent) const;
-        int columnCount(const QModelIndex &parent) const;
-        QVariant data(const QModelIndex &index, int role) const;
-        QHash<int, QByteArray> roleNames() const;
+        int columnCount(const QModelIndex &parent) const override;
+        QVariant data(const QModelIndex &index, int role) const override;
+        QHash<int, QByteArray> roleNames() const override;
         QString deadlineTxt() const;
         void setDeadlineTxt(const QString &newDeadlineTxt);
     };
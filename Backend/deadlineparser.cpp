@@ -1,201 +1,431 @@
 #include "deadlineparser.h"
+#include <QJsonArray>
 #include <QJsonDocument>
-#include <QRegularExpression>
+#include <QJsonObject>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QSet>
 #include <QDebug>
+#include <utility>
 
-/* ================= FSM ================= */
+/* ================= Lexer ================= */
 
-ParserStateMachine::ParserStateMachine()
-    : m_state(ParserState::INIT)
-{
-    m_graph[ParserState::INIT][UserAction::RAW_TXT] = ParserState::FILTER_TEXT;
-    m_graph[ParserState::FILTER_TEXT][UserAction::VALID] = ParserState::SPLIT_TEXT;
-    m_graph[ParserState::SPLIT_TEXT][UserAction::VALID] = ParserState::JSON_TEXT;
-
-    // VALID JSON → FINISH
-    m_graph[ParserState::JSON_TEXT][UserAction::JSON_TXT] = ParserState::FINISH;
+namespace {
 
-    // Direct JSON input
-    m_graph[ParserState::INIT][UserAction::JSON_TXT] = ParserState::FINISH;
+bool isWordChar(QChar c)
+{
+    return c.isLetterOrNumber();
+}
 
-    // Error paths
-    m_graph[ParserState::FILTER_TEXT][UserAction::INVALID] = ParserState::PROMPT_USER;
-    m_graph[ParserState::SPLIT_TEXT][UserAction::INVALID] = ParserState::PROMPT_USER;
+// whitespace inside a line, NBSP included
+bool isBlank(QChar c)
+{
+    return c != u'\n' && c.isSpace();
 }
 
-void ParserStateMachine::update(UserAction action)
+bool isDigit(QChar c)
 {
-    if (m_graph[m_state].contains(action))
-        m_state = m_graph[m_state][action];
-    else
-        qWarning() << "[FSM] Invalid transition";
+    return c >= u'0' && c <= u'9';
 }
 
-ParserState ParserStateMachine::state() const
+// length of the digit run at pos, its value in value
+qsizetype readNumber(QStringView text, qsizetype pos, int* value)
 {
-    return m_state;
+    qsizetype end = pos;
+    int n = 0;
+    while (end < text.size() && isDigit(text[end]) && end - pos < 5)
+        n = n * 10 + (text[end++].unicode() - u'0');
+    *value = n;
+    // a longer run is not a day, month or year
+    if (end < text.size() && isDigit(text[end]))
+        return 0;
+    return end - pos;
 }
 
-/* ================= Parser ================= */
+qsizetype skipBlanks(QStringView text, qsizetype pos)
+{
+    while (pos < text.size() && isBlank(text[pos]))
+        ++pos;
+    return pos;
+}
 
-QDate DeadlineParser::parseDate(const QString& dateString)
+qsizetype wordEnd(QStringView text, qsizetype pos)
 {
-    QString cleanDate = dateString.trimmed();
-    if (cleanDate.endsWith(',')) cleanDate.chop(1);
+    while (pos < text.size() && isWordChar(text[pos]))
+        ++pos;
+    return pos;
+}
 
-    static const QStringList formats = {
-        "MM/dd/yyyy", "MM/dd/yy",
-        "MMMM d yyyy", "MMMM d, yyyy",
-        "d MMMM yyyy", "MMM d, yyyy"
+// 1..12 for an English month name or its three-letter form, 0 otherwise
+int monthNumber(QStringView word)
+{
+    static const QLatin1String months[] = {
+        QLatin1String("january"), QLatin1String("february"), QLatin1String("march"),
+        QLatin1String("april"), QLatin1String("may"), QLatin1String("june"),
+        QLatin1String("july"), QLatin1String("august"), QLatin1String("september"),
+        QLatin1String("october"), QLatin1String("november"), QLatin1String("december")
     };
 
-    for (const auto& fmt : formats) {
-        QDate d = QDate::fromString(cleanDate, fmt);
-        if (d.isValid()) return d;
+    if (word.size() < 3 || word.size() > 9)
+        return 0;
+    if (word.size() == 4 && word.compare(QLatin1String("sept"), Qt::CaseInsensitive) == 0)
+        return 9;
+    for (int i = 0; i < 12; ++i) {
+        const QLatin1String name = word.size() == 3 ? months[i].left(3) : months[i];
+        if (word.compare(name, Qt::CaseInsensitive) == 0)
+            return i + 1;
     }
-    return {};
+    return 0;
 }
 
-QString DeadlineParser::filterLinesWithDates(const QString& text,
-                                             const QRegularExpression& pattern)
+// optional comma, then the blanks before the year; false if there is no separator at all
+bool skipYearSeparator(QStringView text, qsizetype* pos)
 {
-    QStringList lines = text.split('\n');
-    QStringList result;
-
-    for (const auto& line : lines) {
-        if (pattern.match(line).hasMatch())
-            result << line.trimmed();
-    }
-    return result.join('\n');
+    const qsizetype start = *pos;
+    if (*pos < text.size() && text[*pos] == u',')
+        ++*pos;
+    *pos = skipBlanks(text, *pos);
+    return *pos > start;
 }
 
-QStringList DeadlineParser::splitTextByDate(const QString& text,
-                                            const QRegularExpression& pattern)
+// four digit year at pos that ends the date
+bool readYear(QStringView text, qsizetype* pos, int* year)
 {
-    QString normalized = text;
+    if (readNumber(text, *pos, year) != 4)
+        return false;
+    *pos += 4;
+    return *pos >= text.size() || !isWordChar(text[*pos]);
+}
 
-    // Normalize whitespace + NBSP
-    normalized.replace(QChar(0x00A0), ' ');
-    normalized.replace(QRegularExpression("\\s+"), " ");
+// event text without the separators around its date, as in "Deadline: May 1, 2025"
+QString cleanEvent(const QString& text)
+{
+    static const QString separators = QStringLiteral(":;,-|\u2013\u2014");
+    qsizetype begin = 0;
+    qsizetype end = text.size();
+    while (begin < end && (text[begin].isSpace() || separators.contains(text[begin])))
+        ++begin;
+    while (end > begin && (text[end - 1].isSpace() || separators.contains(text[end - 1])))
+        --end;
+    return text.mid(begin, end - begin);
+}
 
-    QStringList result;
-    int last = 0;
+}
 
-    auto it = pattern.globalMatch(normalized);
-    while (it.hasNext()) {
-        auto match = it.next();
-        if (match.capturedStart() > last)
-            result << normalized.mid(last, match.capturedStart() - last).trimmed();
-        result << match.captured().trimmed();
-        last = match.capturedEnd();
+QDate DeadlineParser::lexDate(QStringView text, qsizetype pos, qsizetype* end)
+{
+    if (pos >= text.size() || (pos > 0 && isWordChar(text[pos - 1])))
+        return {};
+
+    int day = 0;
+    int month = 0;
+    int year = 0;
+    qsizetype i = pos;
+
+    if (isDigit(text[i])) {
+        int first = 0;
+        const qsizetype digits = readNumber(text, i, &first);
+        if (digits < 1 || digits > 2)
+            return {};
+        i += digits;
+
+        if (i < text.size() && text[i] == u'/') {
+            // MM/dd/yyyy or MM/dd/yy
+            month = first;
+            const qsizetype dayDigits = readNumber(text, ++i, &day);
+            if (dayDigits < 1 || dayDigits > 2)
+                return {};
+            i += dayDigits;
+            if (i >= text.size() || text[i] != u'/')
+                return {};
+            const qsizetype yearDigits = readNumber(text, ++i, &year);
+            if (yearDigits != 2 && yearDigits != 4)
+                return {};
+            i += yearDigits;
+            if (i < text.size() && isWordChar(text[i]))
+                return {};
+            if (yearDigits == 2)
+                year += 2000;
+        } else {
+            // d Month yyyy
+            day = first;
+            const qsizetype monthStart = skipBlanks(text, i);
+            if (monthStart == i)
+                return {};
+            i = wordEnd(text, monthStart);
+            month = monthNumber(text.sliced(monthStart, i - monthStart));
+            if (!month || !skipYearSeparator(text, &i) || !readYear(text, &i, &year))
+                return {};
+        }
+    } else {
+        // Month d, yyyy
+        i = wordEnd(text, pos);
+        month = monthNumber(text.sliced(pos, i - pos));
+        if (!month)
+            return {};
+        const qsizetype dayStart = skipBlanks(text, i);
+        if (dayStart == i)
+            return {};
+        const qsizetype dayDigits = readNumber(text, dayStart, &day);
+        if (dayDigits < 1 || dayDigits > 2)
+            return {};
+        i = dayStart + dayDigits;
+        if (i < text.size() && isWordChar(text[i]))
+            return {};
+        if (!skipYearSeparator(text, &i) || !readYear(text, &i, &year))
+            return {};
     }
 
-    if (last < normalized.length())
-        result << normalized.mid(last).trimmed();
-
-    result.removeAll("");
-    return result;
+    const QDate date(year, month, day);
+    if (date.isValid())
+        *end = i;
+    return date;
 }
 
-QJsonArray DeadlineParser::serializeText(const QStringList& parts)
+/* ================= Parser ================= */
+
+namespace {
+
+// a date and the text since the previous one
+struct Segment {
+    QString before;
+    QDate date;
+};
+
+// one lexed piece of text; pieces that end at a line boundary are joined by stitch()
+struct Lexed {
+    QList<Segment> segments;
+    QString trailing;
+};
+
+Lexed lex(QStringView text)
 {
-    QJsonArray array;
+    Lexed lexed;
+    // text since the last date, whitespace collapsed
+    QString event;
+    // event.size() where the current line began, rolled back if the line has no date
+    qsizetype lineStart = 0;
+    bool lineHasDate = false;
+
+    auto appendSpace = [&event]() {
+        if (!event.isEmpty() && !event.endsWith(u' '))
+            event += u' ';
+    };
 
-    for (int i = 0; i + 1 < parts.size(); ++i) {
-        QDate d1 = parseDate(parts[i]);
-        QDate d2 = parseDate(parts[i + 1]);
+    auto endLine = [&]() {
+        if (!lineHasDate)
+            event.truncate(lineStart);
+        appendSpace();
+        lineStart = event.size();
+        lineHasDate = false;
+    };
 
-        if (d1.isValid()) {
-            array.append(QJsonObject{
-                {"date", d1.toString(Qt::ISODate)},
-                {"event", parts[i + 1]}
-            });
+    const qsizetype size = text.size();
+    qsizetype i = 0;
+    while (i < size) {
+        const QChar c = text[i];
+        if (c == u'\n') {
+            endLine();
             ++i;
-        }
-        else if (d2.isValid()) {
-            array.append(QJsonObject{
-                {"date", d2.toString(Qt::ISODate)},
-                {"event", parts[i]}
-            });
+        } else if (c.isSpace()) {
+            appendSpace();
+            ++i;
+        } else if (isWordChar(c) && (i == 0 || !isWordChar(text[i - 1]))) {
+            qsizetype end = i;
+            const QDate date = DeadlineParser::lexDate(text, i, &end);
+            if (date.isValid()) {
+                lexed.segments.append({std::exchange(event, QString()), date});
+                lineStart = 0;
+                lineHasDate = true;
+                i = end;
+            } else {
+                // not a date, take the whole word
+                end = wordEnd(text, i);
+                event += text.sliced(i, end - i);
+                i = end;
+            }
+        } else {
+            event += c;
             ++i;
         }
     }
-    return array;
-}
+    endLine();
 
-/* ================= Action Resolver ================= */
+    lexed.trailing = event;
+    return lexed;
+}
 
-UserAction DeadlineParser::getAction(const QString& text, ParserState state)
+// append the next piece of the text; dates never span a line, only the event text between them does
+void stitch(Lexed& into, Lexed&& next)
 {
-    QJsonParseError err;
-    QJsonDocument::fromJson(text.toUtf8(), &err);
-    if (err.error == QJsonParseError::NoError)
-        return UserAction::JSON_TXT;
-
-    if (state == ParserState::INIT)
-        return UserAction::RAW_TXT;
-
-    if (state == ParserState::FILTER_TEXT)
-        return text.length() > 1 ? UserAction::VALID : UserAction::INVALID;
+    auto join = [](QString& left, const QString& right) {
+        if (!left.isEmpty() && !right.isEmpty() && !left.endsWith(u' '))
+            left += u' ';
+        left += right;
+    };
 
-    return UserAction::INVALID;
+    if (next.segments.isEmpty()) {
+        join(into.trailing, next.trailing);
+        return;
+    }
+    join(into.trailing, next.segments.first().before);
+    next.segments.first().before = std::move(into.trailing);
+    into.segments.append(std::move(next.segments));
+    into.trailing = std::move(next.trailing);
 }
 
-UserAction DeadlineParser::getAction(const QStringList& text, ParserState state)
+// the text decides whether events come before or after their date
+QList<Deadline> pairUp(const Lexed& lexed, bool* ok)
 {
-    if (state == ParserState::SPLIT_TEXT)
-        return (text.size() % 2 == 0) ? UserAction::VALID : UserAction::INVALID;
-    return UserAction::INVALID;
+    QList<Deadline> deadlines;
+    deadlines.reserve(lexed.segments.size());
+    bool paired = !lexed.segments.isEmpty();
+    const QString trailing = cleanEvent(lexed.trailing);
+
+    if (paired && !cleanEvent(lexed.segments.first().before).isEmpty()) {
+        // Deadline 15 July 2024
+        for (const Segment& segment : lexed.segments) {
+            QString event = cleanEvent(segment.before);
+            if (event.isEmpty())
+                paired = false;
+            else
+                deadlines.append({segment.date, std::move(event)});
+        }
+        if (!trailing.isEmpty())
+            paired = false;
+    } else if (paired) {
+        // 15 July 2024 Deadline
+        for (qsizetype i = 1; i < lexed.segments.size(); ++i) {
+            QString event = cleanEvent(lexed.segments.at(i).before);
+            if (event.isEmpty())
+                paired = false;
+            else
+                deadlines.append({lexed.segments.at(i - 1).date, std::move(event)});
+        }
+        if (trailing.isEmpty())
+            paired = false;
+        else
+            deadlines.append({lexed.segments.last().date, trailing});
+    }
+
+    if (ok)
+        *ok = paired;
+    return deadlines;
 }
 
-/* ================= Public API ================= */
+}
 
-QPair<QString, ParserState> DeadlineParser::parseDeadlines(const QString& input)
+QList<Deadline> DeadlineParser::extract(QStringView text, bool* ok)
 {
-    QString text = input;
-    QString original = input;
-
-    // Normalize NBSP early
-    text.replace(QChar(0x00A0), ' ');
-
-    ParserStateMachine fsm;
+    return pairUp(lex(text), ok);
+}
 
-    // ✅ FIXED REGEX (correct precedence)
-    QRegularExpression datePattern(
-        R"(\b(?:\d{1,2}/\d{1,2}/\d{2,4}|\d{1,2}\s\w+\s\d{4}|\w+\s\d{1,2},?\s\d{4})\b)"
-        );
+QList<Deadline> DeadlineParser::extractChunked(QStringView text, QThreadPool* pool, bool* ok,
+                                               qsizetype chunkSize)
+{
+    if (!pool)
+        pool = QThreadPool::globalInstance();
+    chunkSize = qMax<qsizetype>(1, chunkSize);
+
+    // cut after a newline so no date is split
+    QList<QStringView> chunks;
+    for (qsizetype start = 0; start < text.size();) {
+        qsizetype end = start + chunkSize;
+        if (end < text.size()) {
+            const qsizetype newline = text.indexOf(u'\n', end);
+            end = newline < 0 ? text.size() : newline + 1;
+        } else {
+            end = text.size();
+        }
+        chunks.append(text.sliced(start, end - start));
+        start = end;
+    }
+    if (chunks.size() < 2)
+        return extract(text, ok);
+
+    QList<Lexed> lexed(chunks.size());
+    // every task writes its own slot, no detach while they run
+    Lexed* results = lexed.data();
+    QSemaphore done;
+    int queued = 0;
+    for (qsizetype i = 1; i < chunks.size(); ++i) {
+        // a busy pool leaves the rest to this thread, the caller may itself be a pool thread
+        const bool started = pool->tryStart([results, &chunks, &done, i]() {
+            results[i] = lex(chunks.at(i));
+            done.release();
+        });
+        if (started)
+            ++queued;
+        else
+            results[i] = lex(chunks.at(i));
+    }
+    results[0] = lex(chunks.first());
+    done.acquire(queued);
 
-    while (fsm.state() != ParserState::FINISH) {
+    Lexed all = std::move(lexed[0]);
+    for (qsizetype i = 1; i < lexed.size(); ++i)
+        stitch(all, std::move(lexed[i]));
+    return pairUp(all, ok);
+}
 
-        if (fsm.state() == ParserState::SPLIT_TEXT) {
-            QStringList parts = splitTextByDate(text, datePattern);
-            fsm.update(getAction(parts, fsm.state()));
+QList<Deadline> DeadlineParser::removeDuplicates(const QList<Deadline>& deadlines)
+{
+    QList<Deadline> unique;
+    unique.reserve(deadlines.size());
+    QSet<QPair<qint64, QString>> seen;
+    seen.reserve(deadlines.size());
+    for (const Deadline& deadline : deadlines) {
+        if (!seen.contains({deadline.date.toJulianDay(), deadline.event})) {
+            seen.insert({deadline.date.toJulianDay(), deadline.event});
+            unique.append(deadline);
+        }
+    }
+    return unique;
+}
 
-            if (fsm.state() == ParserState::JSON_TEXT) {
-                QJsonArray arr = serializeText(parts);
-                text = QJsonDocument(arr).toJson(QJsonDocument::Compact);
-                fsm.update(UserAction::JSON_TXT);
+QList<Deadline> DeadlineParser::parse(const QString& text, bool* ok)
+{
+    // a JSON array pasted back in
+    if (QStringView(text).trimmed().startsWith(u'[')) {
+        QJsonParseError error;
+        const QJsonDocument doc = QJsonDocument::fromJson(text.toUtf8(), &error);
+        if (error.error == QJsonParseError::NoError && doc.isArray()) {
+            QList<Deadline> deadlines;
+            for (const QJsonValue& value : doc.array()) {
+                const QJsonObject obj = value.toObject();
+                const QDate date = QDate::fromString(obj["date"].toString(), Qt::ISODate);
+                if (!date.isValid()) {
+                    qWarning() << "[DeadlineParser] Invalid date:" << obj["date"].toString();
+                    continue;
+                }
+                deadlines.append({date, obj["event"].toString()});
             }
+            if (ok)
+                *ok = true;
+            return deadlines;
         }
-        else {
-            fsm.update(getAction(text, fsm.state()));
-        }
-
-        switch (fsm.state()) {
-        case ParserState::FILTER_TEXT:
-            text = filterLinesWithDates(text, datePattern);
-            break;
+    }
+    // big imports are lexed in parallel
+    if (text.size() > defaultChunkSize)
+        return removeDuplicates(extractChunked(text, nullptr, ok));
+    return removeDuplicates(extract(text, ok));
+}
 
-        case ParserState::PROMPT_USER:
-            return { "[INVALID TEXT]\n\n" + original, fsm.state() };
+/* ================= Public API ================= */
 
-        case ParserState::FINISH:
-            return { text, fsm.state() };
+QPair<QString, ParserState> DeadlineParser::parseDeadlines(const QString& input)
+{
+    bool ok = false;
+    const QList<Deadline> deadlines = parse(input, &ok);
+    if (!ok)
+        return { "[INVALID TEXT]\n\n" + input, ParserState::PROMPT_USER };
 
-        default:
-            break;
-        }
+    QJsonArray array;
+    for (const Deadline& deadline : deadlines) {
+        array.append(QJsonObject{
+            {"date", deadline.date.toString(Qt::ISODate)},
+            {"event", deadline.event}
+        });
     }
-
-    return { text, fsm.state() };
+    return { QString::fromUtf8(QJsonDocument(array).toJson(QJsonDocument::Compact)), ParserState::FINISH };
 }
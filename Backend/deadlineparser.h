@@ -1,11 +1,11 @@
 #ifndef DEADLINEPARSER_H
 #define DEADLINEPARSER_H
 #include <QString>
-#include <QStringList>
-#include <QJsonArray>
-#include <QJsonObject>
+#include <QStringView>
+#include <QList>
 #include <QDate>
-#include <QHash>
+
+class QThreadPool;
 
 enum class ParserState {
     INIT,
@@ -16,40 +16,64 @@ enum class ParserState {
     FINISH
 };
 
-enum class UserAction {
-    RAW_TXT,
-    SPLIT_TXT,
-    JSON_TXT,
-    EMPTY_TXT,
-    INVALID,
-    VALID
+struct Deadline {
+    QDate date;
+    QString event;
 };
 
-class ParserStateMachine
+/**
+ * @brief Finds (date, event) pairs in pasted text such as CFP pages.
+ *
+ * A single-pass lexer recognizes three date shapes:
+ *   - numeric:         1/30/2026, 01/30/26 (month first)
+ *   - Month d, yyyy:   September 15, 2024 / Sep 15 2024
+ *   - d Month yyyy:    15 September 2024 / 15 Sep, 2024
+ * Month names come from a fixed English table, full or three letters,
+ * in any case. Lines without a date are dropped, whitespace is collapsed,
+ * and the text between dates becomes the event. The text decides whether
+ * events come before ("Deadline 15 July 2024") or after their date.
+ */
+class DeadlineParser
 {
 public:
-    ParserStateMachine();
+    /**
+     * @brief Lex text into deadlines
+     * @param ok set to false when the dates and events do not pair up
+     */
+    static QList<Deadline> extract(QStringView text, bool* ok = nullptr);
 
-    void update(UserAction action);
-    ParserState state() const;
+    // characters per chunk for extractChunked(), and the size above which parse() uses it
+    static constexpr qsizetype defaultChunkSize = 256 * 1024;
 
-private:
-    ParserState m_state;
-    QHash<ParserState, QHash<UserAction, ParserState>> m_graph;
-};
+    /**
+     * @brief extract() for large text: cut at line boundaries into chunks lexed on pool
+     *        (the global pool if null), then stitched back in order. Blocks until done.
+     */
+    static QList<Deadline> extractChunked(QStringView text, QThreadPool* pool = nullptr,
+                                          bool* ok = nullptr, qsizetype chunkSize = defaultChunkSize);
 
-class DeadlineParser
-{
-public:
+    /**
+     * @brief The same (date, event) pairs only once, first occurrence kept
+     */
+    static QList<Deadline> removeDuplicates(const QList<Deadline>& deadlines);
+
+    /**
+     * @brief Deadlines from a paste, either raw text or the JSON array
+     *        [{"date": "yyyy-MM-dd", "event": "..."}] parseDeadlines() returns;
+     *        duplicates removed
+     */
+    static QList<Deadline> parse(const QString& text, bool* ok = nullptr);
+
+    /**
+     * @brief JSON form of parse(), or the input marked invalid with PROMPT_USER
+     */
     static QPair<QString, ParserState> parseDeadlines(const QString& text);
 
-private:
-    static QDate parseDate(const QString& dateString);
-    static QString filterLinesWithDates(const QString& text, const QRegularExpression& pattern);
-    static QStringList splitTextByDate(const QString& text, const QRegularExpression& pattern);
-    static QJsonArray serializeText(const QStringList& parts);
-    static UserAction getAction(const QString& text, ParserState state);
-    static UserAction getAction(const QStringList& text, ParserState state);
+    /**
+     * @brief The date starting at pos, if any
+     * @param end set past the date when one is found
+     */
+    static QDate lexDate(QStringView text, qsizetype pos, qsizetype* end);
 };
 
 
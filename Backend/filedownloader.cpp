@@ -4,29 +4,33 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QStandardPaths>
+#include <QDateTime>
+#include <QTextStream>
 #include <QDebug>
 
 using namespace project;
 
-FileDownloader::FileDownloader(QObject *parent)
+FileDownloader::FileDownloader(DbmPtr db, QNetworkAccessManager *network, QObject *parent)
     : QObject{parent}
-    , m_networkManager(new QNetworkAccessManager(this))
-    , m_currentReply(nullptr)
-    , m_downloadFile(nullptr)
+    , db_(db)
+    , m_networkManager(network)
     , m_isDownloading(false)
+    , m_readBuffer(256 * 1024, Qt::Uninitialized)
+    , m_progressTimer(new QTimer(this))
 {
+    if (!m_networkManager)
+        m_networkManager = new QNetworkAccessManager(this);
+
+    // trailing update for progress that was held back by the rate limit
+    m_progressTimer->setSingleShot(true);
+    connect(m_progressTimer, &QTimer::timeout, this, [this]() { updateProgress(); });
 }
 
 FileDownloader::~FileDownloader()
 {
-    if (m_currentReply) {
-        m_currentReply->abort();
-        m_currentReply->deleteLater();
-    }
-    if (m_downloadFile) {
-        m_downloadFile->close();
-        delete m_downloadFile;
-    }
+    // partial files stay on disk and are resumed next time
+    for (const auto& job : std::as_const(m_active))
+        stop(job);
 }
 
 bool FileDownloader::isDownloading() const
@@ -44,6 +48,102 @@ QString FileDownloader::downloadDirectory() const
     return m_downloadDirectory;
 }
 
+int FileDownloader::maxConcurrent() const
+{
+    return m_maxConcurrent;
+}
+
+void FileDownloader::setMaxConcurrent(int count)
+{
+    count = qMax(1, count);
+    if (m_maxConcurrent == count)
+        return;
+    m_maxConcurrent = count;
+    emit maxConcurrentChanged();
+    schedule();
+}
+
+int FileDownloader::segmentsPerFile() const
+{
+    return m_segmentsPerFile;
+}
+
+void FileDownloader::setSegmentsPerFile(int count)
+{
+    m_segmentsPerFile = qMax(1, count);
+}
+
+qint64 FileDownloader::segmentThreshold() const
+{
+    return m_segmentThreshold;
+}
+
+void FileDownloader::setSegmentThreshold(qint64 bytes)
+{
+    m_segmentThreshold = bytes;
+}
+
+int FileDownloader::maxRetries() const
+{
+    return m_maxRetries;
+}
+
+void FileDownloader::setMaxRetries(int count)
+{
+    m_maxRetries = qMax(0, count);
+}
+
+int FileDownloader::writeBufferSize() const
+{
+    return m_writeBufferSize;
+}
+
+void FileDownloader::setWriteBufferSize(int bytes)
+{
+    m_writeBufferSize = qMax(4096, bytes);
+}
+
+int FileDownloader::progressInterval() const
+{
+    return m_progressInterval;
+}
+
+void FileDownloader::setProgressInterval(int ms)
+{
+    m_progressInterval = qMax(0, ms);
+}
+
+int FileDownloader::activeCount() const
+{
+    return m_active.size();
+}
+
+int FileDownloader::queuedCount() const
+{
+    return m_queue.size();
+}
+
+int FileDownloader::completedCount() const
+{
+    return m_completed;
+}
+
+int FileDownloader::failedCount() const
+{
+    return m_failed;
+}
+
+double FileDownloader::progress() const
+{
+    if (m_batchSize == 0)
+        return 0.0;
+    double done = m_completed + m_failed;
+    for (const auto& job : m_active)
+        if (job->total > 0)
+            done += qMin(1.0, double(job->received) / job->total);
+    return done / m_batchSize;
+}
+
 void FileDownloader::setDownloadDirectory(const QString& directory)
 {
     if (m_downloadDirectory == directory)
@@ -74,28 +174,16 @@ QString FileDownloader::extractFileName(const QString& url)
     QUrl qurl(url);
     QString path = qurl.path();
     QString fileName = QFileInfo(path).fileName();
-    
+
     if (fileName.isEmpty()) {
         fileName = "downloaded_file";
     }
-    
+
     return fileName;
 }
 
-void FileDownloader::setDownloadLink(const QString& link)
+QString FileDownloader::targetPath(const QString& fileName, const QUrl& source) const
 {
-    if (link.isEmpty()) {
-        qWarning() << "Empty download link provided";
-        return;
-    }
-
-    // Cancel any existing download
-    if (m_isDownloading) {
-        cancelDownload();
-    }
-
-    qInfo() << "Starting download from:" << link;
-    
     // Prepare the download directory (use custom directory if set, otherwise Downloads folder)
     QString downloadDir;
     if (!m_downloadDirectory.isEmpty() && QDir(m_downloadDirectory).exists()) {
@@ -103,129 +191,683 @@ void FileDownloader::setDownloadLink(const QString& link)
     } else {
         downloadDir = QStandardPaths::writableLocation(QStandardPaths::DownloadLocation);
     }
-    
+
     QDir dir;
     if (!dir.exists(downloadDir)) {
         dir.mkpath(downloadDir);
     }
 
-    // Extract filename from URL
-    QString fileName = extractFileName(link);
-    m_currentDownloadPath = downloadDir + "/" + fileName;
+    auto taken = [this](const QString& path) {
+        for (const auto& job : m_queue)
+            if (job->target == path)
+                return true;
+        for (const auto& job : m_active)
+            if (job->target == path)
+                return true;
+        return false;
+    };
+
+    QString path = downloadDir + "/" + fileName;
+    // an interrupted download of the same link is continued; the same name alone is not enough
+    if (!source.isEmpty() && !QFile::exists(path) && QFile::exists(path + ".part") && !taken(path)
+        && partSource(path + ".part") == source)
+        return path;
 
     // Handle file name conflicts
     int counter = 1;
-    while (QFile::exists(m_currentDownloadPath)) {
+    while (QFile::exists(path) || QFile::exists(path + ".part") || taken(path)) {
         QFileInfo fileInfo(fileName);
         QString baseName = fileInfo.completeBaseName();
         QString extension = fileInfo.suffix();
         if (!extension.isEmpty()) {
-            m_currentDownloadPath = downloadDir + "/" + baseName + QString("_%1.").arg(counter) + extension;
+            path = downloadDir + "/" + baseName + QString("_%1.").arg(counter) + extension;
         } else {
-            m_currentDownloadPath = downloadDir + "/" + fileName + QString("_%1").arg(counter);
+            path = downloadDir + "/" + fileName + QString("_%1").arg(counter);
         }
         counter++;
     }
+    return path;
+}
+
+void FileDownloader::setDownloadLink(const QString& link)
+{
+    enqueue(link);
+}
+
+int FileDownloader::enqueue(const QString& link)
+{
+    if (link.trimmed().isEmpty()) {
+        qWarning() << "Empty download link provided";
+        return -1;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->id = m_nextId++;
+    job->source = QUrl::fromUserInput(link.trimmed());
+    job->url = job->source;
+    job->target = targetPath(extractFileName(link.trimmed()), job->source);
+    job->partPath = job->target + ".part";
+    qInfo() << "[FileDownloader] queued" << link << "->" << job->target;
+
+    // a new batch starts once the previous one has drained
+    if (m_active.isEmpty() && m_queue.isEmpty()) {
+        m_batchSize = 0;
+        m_completed = 0;
+        m_failed = 0;
+    }
+    ++m_batchSize;
+    m_queue.append(job);
+    schedule();
+    return job->id;
+}
 
-    qInfo() << "Download will be saved to:" << m_currentDownloadPath;
+void FileDownloader::enqueueLinks(const QStringList& links)
+{
+    for (const auto& link : links)
+        enqueue(link);
+}
 
-    // Create the file
-    m_downloadFile = new QFile(m_currentDownloadPath);
-    if (!m_downloadFile->open(QIODevice::WriteOnly)) {
-        qWarning() << "Failed to open file for writing:" << m_currentDownloadPath;
-        setDownloadStatus("Error: Cannot create file");
-        emit downloadError("Cannot create file: " + m_currentDownloadPath);
-        delete m_downloadFile;
-        m_downloadFile = nullptr;
+void FileDownloader::cancel(int id)
+{
+    for (const auto& list : {&m_queue, &m_active}) {
+        for (int i = 0; i < list->size(); ++i) {
+            auto job = list->at(i);
+            if (job->id != id)
+                continue;
+            stop(job);
+            // a cancelled download is not wanted any more, unlike a failed one
+            QFile::remove(job->partPath);
+            QFile::remove(job->partPath + ".segments");
+            list->removeAt(i);
+            --m_batchSize;
+            qInfo() << "[FileDownloader] cancelled" << job->url;
+            schedule();
+            return;
+        }
+    }
+}
+
+void FileDownloader::cancelDownload()
+{
+    // queued ones first, so cancelling a running download does not start them
+    QList<int> ids;
+    for (const auto& job : std::as_const(m_queue))
+        ids << job->id;
+    for (const auto& job : std::as_const(m_active))
+        ids << job->id;
+    for (int id : ids)
+        cancel(id);
+
+    setDownloadStatus("Download cancelled");
+    qInfo() << "Download cancelled";
+}
+
+void FileDownloader::schedule()
+{
+    while (m_active.size() < m_maxConcurrent && !m_queue.isEmpty()) {
+        auto job = m_queue.takeFirst();
+        m_active.append(job);
+        start(job);
+    }
+    setIsDownloading(!m_active.isEmpty());
+    updateProgress();
+}
+
+void FileDownloader::start(const std::shared_ptr<Job>& job)
+{
+    job->file = std::make_unique<QFile>(job->partPath);
+    job->hash = std::make_unique<QCryptographicHash>(QCryptographicHash::Sha256);
+    // ReadWrite keeps what an earlier attempt already wrote; writes are buffered per segment instead
+    if (!job->file->open(QIODevice::ReadWrite | QIODevice::Unbuffered)) {
+        qWarning() << "Failed to open file for writing:" << job->partPath;
+        fail(job, "Cannot create file: " + job->partPath);
         return;
     }
+    job->running = true;
 
-    // Start the download
-    QNetworkRequest request(link);
+    if (loadSegments(*job)) {
+        qInfo() << "[FileDownloader] resuming" << job->target << "at" << job->received << "bytes";
+        if (!advanceHash(*job)) {
+            fail(job, "Cannot read file: " + job->partPath);
+            return;
+        }
+        bool finished = true;
+        for (const auto& segment : std::as_const(job->segments))
+            finished = finished && segment.finished;
+        if (finished) {
+            complete(job);
+            return;
+        }
+        for (int i = 0; i < job->segments.size(); ++i)
+            if (!job->segments.at(i).finished)
+                startSegment(job, i);
+        return;
+    }
+
+    // no record of what these bytes are: they cannot be continued
+    if (job->file->size() > 0) {
+        qInfo() << "[FileDownloader]" << job->partPath << "has no matching resume record, starting over";
+        job->file->resize(0);
+    }
+
+    if (m_segmentsPerFile > 1) {
+        probe(job);
+        return;
+    }
+    job->segments = {Segment{}};
+    startSegment(job, 0);
+}
+
+void FileDownloader::probe(const std::shared_ptr<Job>& job)
+{
+    QNetworkRequest request(job->url);
     request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
-    
-    m_currentReply = m_networkManager->get(request);
-    
-    // Connect signals
-    connect(m_currentReply, &QNetworkReply::finished, this, &FileDownloader::onDownloadFinished);
-    connect(m_currentReply, &QNetworkReply::downloadProgress, this, &FileDownloader::onDownloadProgress);
-    connect(m_currentReply, &QNetworkReply::errorOccurred, this, &FileDownloader::onDownloadError);
-    connect(m_currentReply, &QNetworkReply::readyRead, this, [this]() {
-        if (m_downloadFile && m_currentReply) {
-            m_downloadFile->write(m_currentReply->readAll());
+    job->probe = m_networkManager->head(request);
+
+    connect(job->probe, &QNetworkReply::finished, this, [this, job]() {
+        QNetworkReply* reply = job->probe;
+        job->probe = nullptr;
+        reply->deleteLater();
+
+        const qint64 length = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+        const bool ranges = reply->rawHeader("Accept-Ranges").toLower().contains("bytes");
+        if (reply->error() == QNetworkReply::NoError && ranges && length >= m_segmentThreshold
+            && job->file->resize(length)) {
+            job->url = reply->url();
+            job->etag = reply->rawHeader("ETag");
+            job->lastModified = reply->rawHeader("Last-Modified");
+            job->total = length;
+            const qint64 size = (length + m_segmentsPerFile - 1) / m_segmentsPerFile;
+            for (qint64 start = 0; start < length; start += size)
+                job->segments.append(Segment{start, qMin(start + size, length) - 1, 0});
+            qInfo() << "[FileDownloader]" << job->target << "in" << job->segments.size() << "segments";
+        } else {
+            // small file, no range support or no HEAD: one plain stream, which also reports real errors
+            job->segments = {Segment{}};
         }
+        for (int i = 0; i < job->segments.size(); ++i)
+            startSegment(job, i);
     });
+}
+
+void FileDownloader::startSegment(const std::shared_ptr<Job>& job, int index)
+{
+    Segment& segment = job->segments[index];
+    QNetworkRequest request(job->url);
+    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
+    // a stalled connection counts as failed and is resumed
+    request.setTransferTimeout(30000);
+
+    const qint64 from = segment.start + segment.done;
+    if (segment.end >= 0)
+        request.setRawHeader("Range", QString("bytes=%1-%2").arg(from).arg(segment.end).toLatin1());
+    else if (from > 0)
+        request.setRawHeader("Range", QString("bytes=%1-").arg(from).toLatin1());
+    // the range only applies to the same version of the file, a changed one comes back whole (200)
+    if (request.hasRawHeader("Range")) {
+        if (!job->etag.isEmpty() && !job->etag.startsWith("W/"))
+            request.setRawHeader("If-Range", job->etag);
+        else if (!job->lastModified.isEmpty())
+            request.setRawHeader("If-Range", job->lastModified);
+    }
 
-    setIsDownloading(true);
-    setDownloadStatus("Downloading...");
+    segment.reply = m_networkManager->get(request);
+    QNetworkReply* reply = segment.reply;
+    connect(reply, &QNetworkReply::metaDataChanged, this, [this, job, index]() { onSegmentMetaData(job, index); });
+    connect(reply, &QNetworkReply::readyRead, this, [this, job, index]() { onSegmentReadyRead(job, index); });
+    connect(reply, &QNetworkReply::finished, this, [this, job, index]() { onSegmentFinished(job, index); });
 }
 
-void FileDownloader::cancelDownload()
+void FileDownloader::onSegmentMetaData(const std::shared_ptr<Job>& job, int index)
 {
-    if (m_currentReply) {
-        m_currentReply->abort();
-        m_currentReply->deleteLater();
-        m_currentReply = nullptr;
+    Segment& segment = job->segments[index];
+    QNetworkReply* reply = segment.reply;
+    if (!reply || reply->property("checked").toBool())
+        return;
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    // nothing yet, or a redirect that is being followed
+    if (status == 0 || (status >= 300 && status < 400))
+        return;
+    reply->setProperty("checked", true);
+    // a 200 is a new copy of the file, a 206 the version named in If-Range
+    if (status == 200 || job->etag.isEmpty()) {
+        job->etag = reply->rawHeader("ETag");
+        job->lastModified = reply->rawHeader("Last-Modified");
     }
-    
-    if (m_downloadFile) {
-        m_downloadFile->close();
-        m_downloadFile->remove();
-        delete m_downloadFile;
-        m_downloadFile = nullptr;
+
+    const qint64 from = segment.start + segment.done;
+    if (status == 206) {
+        // Content-Range: bytes <first>-<last>/<total>
+        const QByteArray range = reply->rawHeader("Content-Range");
+        const qint64 first = range.mid(6, range.indexOf('-') - 6).trimmed().toLongLong();
+        if (first != from) {
+            restartSingle(job);
+            return;
+        }
+        const qint64 total = range.mid(range.indexOf('/') + 1).toLongLong();
+        if (job->segments.size() == 1 && total > 0)
+            job->total = total;
+    } else if (status == 200) {
+        if (from > 0) {
+            // the server ignored the range and sends the whole file
+            if (job->segments.size() > 1) {
+                restartSingle(job);
+                return;
+            }
+            qInfo() << "[FileDownloader]" << job->url << "cannot be resumed, starting over";
+            job->file->resize(0);
+            job->received = 0;
+            segment.done = 0;
+            segment.pending.resize(0);
+            resetHash(*job);
+        }
+        const qint64 length = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+        if (job->segments.size() == 1 && length > 0)
+            job->total = length;
     }
-    
-    setIsDownloading(false);
-    setDownloadStatus("Download cancelled");
-    qInfo() << "Download cancelled";
 }
 
-void FileDownloader::onDownloadFinished()
+void FileDownloader::onSegmentReadyRead(const std::shared_ptr<Job>& job, int index)
 {
-    if (!m_currentReply || !m_downloadFile) {
+    if (!job->running || index >= job->segments.size())
+        return;
+    QNetworkReply* reply = job->segments.at(index).reply;
+    if (!reply)
+        return;
+    if (!reply->property("checked").toBool())
+        onSegmentMetaData(job, index);
+    // restarted or failed meanwhile
+    if (!job->running || index >= job->segments.size() || job->segments.at(index).reply != reply)
+        return;
+
+    // error pages are not part of the file
+    if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() >= 400) {
+        reply->readAll();
         return;
     }
 
+    Segment& segment = job->segments[index];
+    if (segment.pending.capacity() < m_writeBufferSize)
+        segment.pending.reserve(m_writeBufferSize);
+
+    while (reply->bytesAvailable() > 0) {
+        qint64 wanted = m_readBuffer.size();
+        if (segment.end >= 0)
+            wanted = qMin(wanted, segment.end + 1 - segment.start - segment.done);
+        if (wanted <= 0) {
+            // more than the requested range
+            reply->skip(reply->bytesAvailable());
+            break;
+        }
+        const qint64 count = reply->read(m_readBuffer.data(), wanted);
+        if (count <= 0)
+            break;
+
+        const QByteArrayView chunk(m_readBuffer.constData(), count);
+        // in file order with what was hashed so far: hash it while it is in memory
+        if (segment.start + segment.done == job->hashed) {
+            job->hash->addData(chunk);
+            job->hashed += count;
+        }
+        segment.pending.append(chunk);
+        segment.done += count;
+        job->received += count;
+
+        if (segment.pending.size() >= m_writeBufferSize && !flush(*job, segment)) {
+            fail(job, "Cannot write file: " + job->partPath);
+            return;
+        }
+    }
+    updateProgress(false);
+}
+
+void FileDownloader::onSegmentFinished(const std::shared_ptr<Job>& job, int index)
+{
+    if (!job->running || index >= job->segments.size())
+        return;
+    QNetworkReply* reply = job->segments.at(index).reply;
+    if (!reply)
+        return;
+
     // Write any remaining data
-    if (m_currentReply->bytesAvailable() > 0) {
-        m_downloadFile->write(m_currentReply->readAll());
+    onSegmentReadyRead(job, index);
+    if (!job->running || index >= job->segments.size() || job->segments.at(index).reply != reply)
+        return;
+
+    Segment& segment = job->segments[index];
+    segment.reply = nullptr;
+    reply->deleteLater();
+    // also on errors, a retry or the next attempt resumes after these bytes
+    if (!flush(*job, segment)) {
+        fail(job, "Cannot write file: " + job->partPath);
+        return;
+    }
+
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    QString error = reply->errorString();
+    if (reply->error() == QNetworkReply::NoError) {
+        const bool whole = segment.end < 0 ? job->total <= 0 || segment.done >= job->total
+                                           : segment.start + segment.done > segment.end;
+        if (whole) {
+            segment.finished = true;
+            // the segments after this one may now be hashed from disk
+            if (!advanceHash(*job)) {
+                fail(job, "Cannot read file: " + job->partPath);
+                return;
+            }
+            for (const auto& other : std::as_const(job->segments))
+                if (!other.finished)
+                    return;
+            complete(job);
+            return;
+        }
+        error = "Connection closed before the end of the file";
+    }
+
+    // resume offset past the end of the file (e.g. it changed on the server): start over
+    if (status == 416) {
+        restartSingle(job);
+        return;
+    }
+
+    // dropped connections and server trouble are worth another try, other HTTP errors are final
+    const bool transient = status < 400 || status == 408 || status == 429 || status >= 500;
+    if (transient && segment.retries < m_maxRetries) {
+        ++segment.retries;
+        const int delay = 500 * (1 << (segment.retries - 1));
+        qInfo() << "[FileDownloader]" << error << "- resuming" << job->url << "at"
+                << segment.start + segment.done << "in" << delay << "ms";
+        QTimer::singleShot(delay, this, [this, job, index]() {
+            if (job->running && index < job->segments.size() && !job->segments.at(index).reply
+                && !job->segments.at(index).finished)
+                startSegment(job, index);
+        });
+        return;
+    }
+    fail(job, error);
+}
+
+void FileDownloader::restartSingle(const std::shared_ptr<Job>& job)
+{
+    qInfo() << "[FileDownloader]" << job->url << "does not serve the requested range, starting over";
+    for (auto& segment : job->segments) {
+        if (segment.reply) {
+            disconnect(segment.reply, nullptr, this, nullptr);
+            segment.reply->abort();
+            segment.reply->deleteLater();
+        }
+    }
+    QFile::remove(job->partPath + ".segments");
+    job->file->resize(0);
+    job->received = 0;
+    job->total = -1;
+    resetHash(*job);
+    job->segments = {Segment{}};
+    startSegment(job, 0);
+}
+
+void FileDownloader::complete(const std::shared_ptr<Job>& job)
+{
+    for (auto& segment : job->segments) {
+        if (!flush(*job, segment)) {
+            fail(job, "Cannot write file: " + job->partPath);
+            return;
+        }
     }
+    // normally everything was hashed on the way; otherwise hash the file once more
+    if (!advanceHash(*job) || job->hashed != job->file->size()) {
+        resetHash(*job);
+        job->segments = {Segment{0, -1, job->file->size()}};
+        if (!advanceHash(*job)) {
+            fail(job, "Cannot read file: " + job->partPath);
+            return;
+        }
+    }
+    const QString sha256 = QString::fromLatin1(job->hash->result().toHex());
+
+    job->running = false;
+    job->file->close();
+    QFile::remove(job->partPath + ".segments");
+
+    // the name may have been taken while downloading
+    QString target = job->target;
+    if (QFile::exists(target))
+        target = targetPath(QFileInfo(target).fileName());
+    if (!QFile::rename(job->partPath, target)) {
+        fail(job, "Cannot rename " + job->partPath + " to " + target);
+        return;
+    }
+
+    m_active.removeOne(job);
+    ++m_completed;
+    qInfo() << "Download completed successfully:" << target << "sha256" << sha256;
+    record(*job, target, sha256);
+    emit downloadComplete(target);
+    emit downloadVerified(target, sha256);
+    schedule();
+}
+
+void FileDownloader::fail(const std::shared_ptr<Job>& job, const QString& error)
+{
+    stop(job);
+    // keep what arrived so the next attempt resumes; nothing arrived, nothing to keep
+    if (job->received == 0) {
+        QFile::remove(job->partPath);
+        QFile::remove(job->partPath + ".segments");
+    }
+    m_active.removeOne(job);
+    m_queue.removeOne(job);
+    ++m_failed;
+
+    qWarning() << "Download failed with error:" << job->url << error;
+    emit downloadError(error);
+    schedule();
+}
+
+void FileDownloader::stop(const std::shared_ptr<Job>& job)
+{
+    job->running = false;
+    auto drop = [this](QNetworkReply*& reply) {
+        if (!reply)
+            return;
+        disconnect(reply, nullptr, this, nullptr);
+        reply->abort();
+        reply->deleteLater();
+        reply = nullptr;
+    };
+    drop(job->probe);
+    for (auto& segment : job->segments) {
+        drop(segment.reply);
+        // bytes that cannot be written are fetched again
+        if (job->file && job->file->isOpen() && !flush(*job, segment)) {
+            segment.done -= segment.pending.size();
+            segment.pending.resize(0);
+        }
+    }
+
+    if (job->received > 0)
+        saveSegments(*job);
+    if (job->file)
+        job->file->close();
+}
+
+bool FileDownloader::flush(Job &job, Segment &segment)
+{
+    if (segment.pending.isEmpty())
+        return true;
+    const qint64 offset = segment.start + segment.done - segment.pending.size();
+    if (!job.file->seek(offset) || job.file->write(segment.pending) != segment.pending.size())
+        return false;
+    // resize keeps the capacity, the buffer is reused for the next chunks
+    segment.pending.resize(0);
+    return true;
+}
 
-    m_downloadFile->close();
-    delete m_downloadFile;
-    m_downloadFile = nullptr;
+bool FileDownloader::advanceHash(Job &job)
+{
+    // segments are in file order; hash what is on disk from the hashed prefix on
+    for (auto& segment : job.segments) {
+        if (segment.end >= 0 && job.hashed > segment.end)
+            continue;
+        const qint64 available = segment.start + segment.done;
+        if (job.hashed < available) {
+            if (!flush(job, segment))
+                return false;
+            while (job.hashed < available) {
+                const qint64 count = job.file->seek(job.hashed)
+                    ? job.file->read(m_readBuffer.data(), qMin<qint64>(m_readBuffer.size(), available - job.hashed))
+                    : -1;
+                if (count <= 0)
+                    return false;
+                job.hash->addData(QByteArrayView(m_readBuffer.constData(), count));
+                job.hashed += count;
+            }
+        }
+        // the prefix ends inside this segment, its next bytes are hashed as they arrive
+        if (segment.end < 0 || job.hashed <= segment.end)
+            break;
+    }
+    return true;
+}
 
-    if (m_currentReply->error() == QNetworkReply::NoError) {
-        qInfo() << "Download completed successfully:" << m_currentDownloadPath;
-        setDownloadStatus("Download complete");
-        emit downloadComplete(m_currentDownloadPath);
+void FileDownloader::resetHash(Job &job)
+{
+    job.hash->reset();
+    job.hashed = 0;
+}
+
+void FileDownloader::record(const Job &job, const QString &path, const QString &sha256)
+{
+    if (!db_)
+        return;
+
+    for (const auto& copy : copiesOf(sha256)) {
+        if (copy != path) {
+            qInfo() << "[FileDownloader]" << path << "duplicates" << copy;
+            emit duplicateDownloaded(path, copy);
+            break;
+        }
+    }
+    if (!db_->exec("INSERT OR REPLACE INTO Downloads (path, url, size, sha256, completed_at) VALUES (?, ?, ?, ?, ?)",
+                   {path, job.url.toString(), QFileInfo(path).size(), sha256, QDateTime::currentSecsSinceEpoch()}))
+        qWarning() << "[FileDownloader] failed to record" << path;
+}
+
+QStringList FileDownloader::copiesOf(const QString &sha256) const
+{
+    QStringList copies;
+    if (!db_)
+        return copies;
+    db_->forEachRow<QString>("SELECT path FROM Downloads WHERE sha256 = ? ORDER BY completed_at", {sha256.toLower()},
+                             [&copies](const QString& path) {
+        if (QFile::exists(path))
+            copies << path;
+    });
+    return copies;
+}
+
+QUrl FileDownloader::partSource(const QString& partPath)
+{
+    QFile file(partPath + ".segments");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return QUrl();
+    const QString line = QTextStream(&file).readLine();
+    return line.startsWith("url ") ? QUrl(line.mid(4), QUrl::StrictMode) : QUrl();
+}
+
+bool FileDownloader::loadSegments(Job& job) const
+{
+    // "url <link>", "etag <value>", "modified <value>", then one "<start> <end> <done>" line per segment
+    QFile file(job.partPath + ".segments");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+
+    QUrl source;
+    QByteArray etag;
+    QByteArray lastModified;
+    QList<Segment> segments;
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        const QString line = in.readLine();
+        if (line.startsWith("url ")) {
+            source = QUrl(line.mid(4), QUrl::StrictMode);
+            continue;
+        }
+        if (line.startsWith("etag ")) {
+            etag = line.mid(5).toLatin1();
+            continue;
+        }
+        if (line.startsWith("modified ")) {
+            lastModified = line.mid(9).toLatin1();
+            continue;
+        }
+        const QStringList fields = line.split(' ', Qt::SkipEmptyParts);
+        if (fields.size() != 3)
+            continue;
+        Segment segment{fields[0].toLongLong(), fields[1].toLongLong(), fields[2].toLongLong()};
+        segment.finished = segment.end >= 0 && segment.start + segment.done > segment.end;
+        segments.append(segment);
+    }
+    // bytes of another link, or of a version that cannot be named in If-Range
+    if (source != job.source || (etag.isEmpty() && lastModified.isEmpty()) || segments.isEmpty())
+        return false;
+
+    if (segments.size() == 1 && segments.first().end < 0) {
+        // one stream: everything on disk arrived in order
+        segments.first().done = job.file->size();
+        job.total = -1;
     } else {
-        qWarning() << "Download failed with error:" << m_currentReply->errorString();
-        setDownloadStatus("Download failed");
-        emit downloadError(m_currentReply->errorString());
-        
-        // Remove incomplete file
-        QFile::remove(m_currentDownloadPath);
+        // a preallocated file of the wrong size cannot be trusted
+        if (job.file->size() != segments.last().end + 1)
+            return false;
+        job.total = segments.last().end + 1;
     }
 
-    m_currentReply->deleteLater();
-    m_currentReply = nullptr;
-    
-    setIsDownloading(false);
+    job.segments = segments;
+    job.etag = etag;
+    job.lastModified = lastModified;
+    job.received = 0;
+    for (const auto& segment : segments)
+        job.received += segment.done;
+    return job.received > 0;
 }
 
-void FileDownloader::onDownloadProgress(qint64 bytesReceived, qint64 bytesTotal)
+void FileDownloader::saveSegments(const Job& job) const
 {
-    if (bytesTotal > 0) {
-        double progress = (double)bytesReceived / bytesTotal * 100.0;
-        QString status = QString("Downloading... %1%").arg(QString::number(progress, 'f', 1));
-        setDownloadStatus(status);
-        qInfo() << "Download progress:" << progress << "%";
+    QFile file(job.partPath + ".segments");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qWarning() << "[FileDownloader] cannot save segments of" << job.partPath;
+        return;
     }
+    QTextStream out(&file);
+    out << "url " << job.source.toString(QUrl::FullyEncoded) << '\n';
+    if (!job.etag.isEmpty())
+        out << "etag " << job.etag << '\n';
+    if (!job.lastModified.isEmpty())
+        out << "modified " << job.lastModified << '\n';
+    for (const auto& segment : job.segments)
+        out << segment.start << ' ' << segment.end << ' ' << segment.done << '\n';
 }
 
-void FileDownloader::onDownloadError(QNetworkReply::NetworkError error)
+void FileDownloader::updateProgress(bool force)
 {
-    Q_UNUSED(error);
-    qWarning() << "Download error occurred:" << m_currentReply->errorString();
+    // bytes arrive in many small chunks; the view needs a few updates per second at most
+    if (!force && m_progressClock.isValid() && m_progressClock.elapsed() < m_progressInterval) {
+        if (!m_progressTimer->isActive())
+            m_progressTimer->start(int(m_progressInterval - m_progressClock.elapsed()));
+        return;
+    }
+    m_progressTimer->stop();
+    m_progressClock.start();
+
+    if (!m_active.isEmpty() || !m_queue.isEmpty()) {
+        const int current = qMin(m_batchSize, m_completed + m_failed + int(m_active.size()));
+        setDownloadStatus(QString("Downloading %1 of %2... %3%")
+                              .arg(current).arg(m_batchSize)
+                              .arg(QString::number(progress() * 100.0, 'f', 1)));
+    } else if (m_batchSize > 0) {
+        setDownloadStatus(m_failed > 0 ? QString("Download failed (%1 of %2)").arg(m_failed).arg(m_batchSize)
+                                       : QString("Download complete"));
+    }
+    emit progressChanged();
 }
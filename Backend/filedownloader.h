@@ -5,17 +5,49 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QString>
+#include <QStringList>
 #include <QFile>
+#include <QList>
+#include <QUrl>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <memory>
+#include "database.h"
 
 namespace project {
 /**
  * @class FileDownloader
- * @brief Manages network file transfers and synchronizes UI download states.
+ * @brief Download queue behind the FolderViewer download row.
  *
- * This class orchestrates file downloads using the Qt Network module. It responds
- * to signals from the ProjectPage to initiate transfers and update directory paths.
- * Additionally, it manages the visibility of a busy indicator in the FolderViewer
- * search row to provide user feedback during active downloads.
+ * Links are queued and transferred maxConcurrent() files at a time, so a batch
+ * of papers downloads in parallel instead of one after the other. Data is
+ * written to "<target>.part" and renamed once complete; a transfer that fails
+ * keeps its partial file and is retried (or, after the retries are used up,
+ * queued again later) with an HTTP Range request from where it stopped.
+ *
+ * Files of at least segmentThreshold() bytes from servers that accept ranges
+ * are split into segmentsPerFile() parts fetched in parallel into a
+ * preallocated target.
+ *
+ * An interrupted download keeps "<target>.part.segments" next to the partial
+ * file: the link, the ETag / Last-Modified of the response and the segment
+ * offsets. A later download of the same link continues the partial file only
+ * when that record matches, and sends If-Range so a file that changed on the
+ * server comes back whole and starts over. Partial files of other links are
+ * left alone and the new download gets a fresh name.
+ *
+ * Progress over the whole batch is exposed to QML through progress(),
+ * activeCount(), queuedCount() and downloadStatus(); progressChanged() is
+ * emitted at most every progressInterval() ms while bytes stream in.
+ *
+ * Replies are read into one reusable buffer and collected per segment in a
+ * write buffer of writeBufferSize() bytes before they reach the (unbuffered)
+ * file. The SHA-256 of the file is computed while streaming: bytes arriving
+ * in file order are hashed from memory, bytes of later segments are read back
+ * once the segments before them are complete. With a database, every
+ * completed file is recorded with its checksum in the Downloads table, and
+ * duplicateDownloaded() reports files that were already downloaded.
  */
 class FileDownloader : public QObject
 {
@@ -23,44 +55,165 @@ class FileDownloader : public QObject
     Q_PROPERTY(bool isDownloading READ isDownloading NOTIFY isDownloadingChanged FINAL)
     Q_PROPERTY(QString downloadStatus READ downloadStatus NOTIFY downloadStatusChanged FINAL)
     Q_PROPERTY(QString downloadDirectory READ downloadDirectory WRITE setDownloadDirectory NOTIFY downloadDirectoryChanged FINAL)
+    Q_PROPERTY(int maxConcurrent READ maxConcurrent WRITE setMaxConcurrent NOTIFY maxConcurrentChanged FINAL)
+    Q_PROPERTY(int activeCount READ activeCount NOTIFY progressChanged FINAL)
+    Q_PROPERTY(int queuedCount READ queuedCount NOTIFY progressChanged FINAL)
+    Q_PROPERTY(int completedCount READ completedCount NOTIFY progressChanged FINAL)
+    Q_PROPERTY(int failedCount READ failedCount NOTIFY progressChanged FINAL)
+    Q_PROPERTY(double progress READ progress NOTIFY progressChanged FINAL)
 
 public:
-    explicit FileDownloader(QObject *parent = nullptr);
+    explicit FileDownloader(DbmPtr db = nullptr, QNetworkAccessManager *network = nullptr,
+                            QObject *parent = nullptr);
     ~FileDownloader();
 
     bool isDownloading() const;
     QString downloadStatus() const;
     QString downloadDirectory() const;
 
+    int maxConcurrent() const;
+    void setMaxConcurrent(int count);
+
+    int segmentsPerFile() const;
+    void setSegmentsPerFile(int count);
+
+    qint64 segmentThreshold() const;
+    void setSegmentThreshold(qint64 bytes);
+
+    int maxRetries() const;
+    void setMaxRetries(int count);
+
+    int writeBufferSize() const;
+    void setWriteBufferSize(int bytes);
+
+    int progressInterval() const;
+    void setProgressInterval(int ms);
+
+    int activeCount() const;
+    int queuedCount() const;
+    int completedCount() const;
+    int failedCount() const;
+
+    /**
+     * @brief Fraction of the current batch that has arrived, 0 to 1
+     */
+    double progress() const;
+
+    /**
+     * @brief Queue link into the download directory
+     * @return download id, or -1 for an empty link
+     */
+    Q_INVOKABLE int enqueue(const QString& link);
+    Q_INVOKABLE void enqueueLinks(const QStringList& links);
+    Q_INVOKABLE void cancel(int id);
+
+    /**
+     * @brief Recorded downloads with the given SHA-256 (hex) that still exist on disk
+     */
+    Q_INVOKABLE QStringList copiesOf(const QString& sha256) const;
+
 public slots:
     void setDownloadLink(const QString& link);
     void setDownloadDirectory(const QString& directory);
+    // cancel every queued and running download
     void cancelDownload();
 
 signals:
     void isDownloadingChanged();
     void downloadStatusChanged();
     void downloadDirectoryChanged();
+    void maxConcurrentChanged();
+    void progressChanged();
     void downloadComplete(const QString& filePath);
+    void downloadVerified(const QString& filePath, const QString& sha256);
+    void duplicateDownloaded(const QString& filePath, const QString& existingPath);
     void downloadError(const QString& error);
 
-private slots:
-    void onDownloadFinished();
-    void onDownloadProgress(qint64 bytesReceived, qint64 bytesTotal);
-    void onDownloadError(QNetworkReply::NetworkError error);
-
 private:
+    struct Segment {
+        qint64 start = 0;
+        // last byte, -1 while the size is unknown
+        qint64 end = -1;
+        qint64 done = 0;
+        QNetworkReply* reply = nullptr;
+        int retries = 0;
+        bool finished = false;
+        // received bytes not written yet, they end at start + done
+        QByteArray pending;
+    };
+
+    struct Job {
+        int id;
+        // the queued link; url follows redirects
+        QUrl source;
+        QUrl url;
+        QString target;
+        QString partPath;
+        std::unique_ptr<QFile> file;
+        QList<Segment> segments;
+        QNetworkReply* probe = nullptr;
+        qint64 total = -1;
+        qint64 received = 0;
+        bool running = false;
+        std::unique_ptr<QCryptographicHash> hash;
+        // the first `hashed` bytes of the file went into hash
+        qint64 hashed = 0;
+        // validators of the file being fetched, sent as If-Range when resuming
+        QByteArray etag;
+        QByteArray lastModified;
+    };
+
+    DbmPtr db_;
     QNetworkAccessManager* m_networkManager;
-    QNetworkReply* m_currentReply;
-    QFile* m_downloadFile;
+    QList<std::shared_ptr<Job>> m_queue;
+    QList<std::shared_ptr<Job>> m_active;
+    int m_nextId = 1;
     bool m_isDownloading;
     QString m_downloadStatus;
-    QString m_currentDownloadPath;
     QString m_downloadDirectory;
 
+    int m_maxConcurrent = 4;
+    int m_segmentsPerFile = 4;
+    qint64 m_segmentThreshold = 8 * 1024 * 1024;
+    int m_maxRetries = 3;
+    int m_writeBufferSize = 1024 * 1024;
+
+    // every reply is read through this buffer, no allocation per chunk
+    QByteArray m_readBuffer;
+
+    int m_progressInterval = 100;
+    QElapsedTimer m_progressClock;
+    QTimer* m_progressTimer;
+
+    // current batch, reset when the queue runs empty
+    int m_batchSize = 0;
+    int m_completed = 0;
+    int m_failed = 0;
+
     void setIsDownloading(bool downloading);
     void setDownloadStatus(const QString& status);
     QString extractFileName(const QString& url);
+    QString targetPath(const QString& fileName, const QUrl& source = QUrl()) const;
+    static QUrl partSource(const QString& partPath);
+
+    void schedule();
+    void start(const std::shared_ptr<Job>& job);
+    void probe(const std::shared_ptr<Job>& job);
+    void startSegment(const std::shared_ptr<Job>& job, int index);
+    void onSegmentMetaData(const std::shared_ptr<Job>& job, int index);
+    void onSegmentReadyRead(const std::shared_ptr<Job>& job, int index);
+    void onSegmentFinished(const std::shared_ptr<Job>& job, int index);
+    void restartSingle(const std::shared_ptr<Job>& job);
+    void complete(const std::shared_ptr<Job>& job);
+    void fail(const std::shared_ptr<Job>& job, const QString& error);
+    void stop(const std::shared_ptr<Job>& job);
+    bool flush(Job& job, Segment& segment);
+    bool advanceHash(Job& job);
+    void resetHash(Job& job);
+    void record(const Job& job, const QString& path, const QString& sha256);
+    bool loadSegments(Job& job) const;
+    void saveSegments(const Job& job) const;
+    void updateProgress(bool force = true);
 };
 
 } // namespace project
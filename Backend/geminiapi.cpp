@@ -0,0 +1,181 @@
+#include "geminiapi.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+namespace gemini {
+
+QUrl defaultEndpoint()
+{
+    return QUrl(QStringLiteral("https://generativelanguage.googleapis.com/v1beta"));
+}
+
+QString defaultModel()
+{
+    return QStringLiteral("gemini-2.5-flash");
+}
+
+static QNetworkRequest modelRequest(const QUrl& endpoint, const QString& model, const QString& method,
+                                    const QString& apiKey)
+{
+    QUrl url = endpoint;
+    QString path = url.path();
+    if (!path.endsWith('/'))
+        path += '/';
+    url.setPath(path + "models/" + model + ':' + method);
+
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    request.setRawHeader("x-goog-api-key", apiKey.toUtf8());
+    return request;
+}
+
+QNetworkRequest generateContentRequest(const QUrl& endpoint, const QString& model, const QString& apiKey)
+{
+    return modelRequest(endpoint, model, "generateContent", apiKey);
+}
+
+QNetworkRequest streamGenerateContentRequest(const QUrl& endpoint, const QString& model, const QString& apiKey)
+{
+    QNetworkRequest request = modelRequest(endpoint, model, "streamGenerateContent", apiKey);
+    QUrl url = request.url();
+    url.setQuery("alt=sse");
+    request.setUrl(url);
+    request.setRawHeader("Accept", "text/event-stream");
+    return request;
+}
+
+QByteArray generateContentBody(const QString& prompt)
+{
+    QJsonObject textPart;
+    textPart["text"] = prompt;
+
+    QJsonObject content;
+    content["parts"] = QJsonArray{textPart};
+
+    QJsonObject body;
+    body["contents"] = QJsonArray{content};
+    return QJsonDocument(body).toJson(QJsonDocument::Compact);
+}
+
+QString responseText(const QByteArray& json, QString* error)
+{
+    const QJsonDocument doc = QJsonDocument::fromJson(json);
+    if (doc.isNull()) {
+        *error = QStringLiteral("Error: Failed to parse response");
+        return QString();
+    }
+
+    const QJsonObject response = doc.object();
+    if (response.contains("error")) {
+        *error = QString("API Error: %1").arg(response["error"].toObject()["message"].toString());
+        return QString();
+    }
+
+    const QJsonArray candidates = response["candidates"].toArray();
+    if (candidates.isEmpty()) {
+        *error = QStringLiteral("Error: No candidates in response");
+        return QString();
+    }
+
+    const QJsonArray parts = candidates[0].toObject()["content"].toObject()["parts"].toArray();
+    if (parts.isEmpty()) {
+        *error = QStringLiteral("Error: Empty response from API");
+        return QString();
+    }
+    return parts[0].toObject()["text"].toString();
+}
+
+QString chunkText(const QByteArray& json, QString* error)
+{
+    const QJsonDocument doc = QJsonDocument::fromJson(json);
+    if (doc.isNull()) {
+        *error = QStringLiteral("Error: Failed to parse response");
+        return QString();
+    }
+
+    const QJsonObject chunk = doc.object();
+    if (chunk.contains("error")) {
+        *error = QString("API Error: %1").arg(chunk["error"].toObject()["message"].toString());
+        return QString();
+    }
+
+    QString text;
+    const QJsonArray candidates = chunk["candidates"].toArray();
+    if (candidates.isEmpty())
+        return text;
+    for (const QJsonValue& part : candidates[0].toObject()["content"].toObject()["parts"].toArray())
+        text += part.toObject()["text"].toString();
+    return text;
+}
+
+QList<QByteArray> SseParser::feed(QByteArrayView chunk)
+{
+    QList<QByteArray> events;
+    qsizetype start = 0;
+    while (start < chunk.size()) {
+        const qsizetype end = chunk.indexOf('\n', start);
+        if (end < 0) {
+            m_line.append(chunk.sliced(start));
+            break;
+        }
+        if (m_line.isEmpty()) {
+            processLine(chunk.sliced(start, end - start), events);
+        } else {
+            m_line.append(chunk.sliced(start, end - start));
+            processLine(m_line, events);
+            m_line.clear();
+        }
+        start = end + 1;
+    }
+    return events;
+}
+
+QList<QByteArray> SseParser::finish()
+{
+    QList<QByteArray> events;
+    if (!m_line.isEmpty()) {
+        processLine(m_line, events);
+        m_line.clear();
+    }
+    processLine(QByteArrayView(), events);
+    return events;
+}
+
+void SseParser::processLine(QByteArrayView line, QList<QByteArray>& events)
+{
+    if (line.endsWith('\r'))
+        line.chop(1);
+
+    // a blank line ends the event
+    if (line.isEmpty()) {
+        if (m_hasData)
+            events.append(m_data);
+        m_data.clear();
+        m_hasData = false;
+        return;
+    }
+    if (line.startsWith(':'))
+        return;
+
+    const qsizetype colon = line.indexOf(':');
+    const QByteArrayView field = colon < 0 ? line : line.first(colon);
+    if (field != "data")
+        return;
+
+    QByteArrayView value = colon < 0 ? QByteArrayView() : line.sliced(colon + 1);
+    if (value.startsWith(' '))
+        value = value.sliced(1);
+    if (m_hasData)
+        m_data.append('\n');
+    m_data.append(value);
+    m_hasData = true;
+}
+
+bool isTransient(int httpStatus)
+{
+    // 0 covers connection errors and timeouts
+    return httpStatus == 0 || httpStatus == 408 || httpStatus == 429 || httpStatus >= 500;
+}
+
+}
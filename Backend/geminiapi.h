@@ -0,0 +1,96 @@
+#ifndef GEMINIAPI_H
+#define GEMINIAPI_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+#include <QNetworkRequest>
+#include <QString>
+#include <QUrl>
+
+/**
+ * @brief Request and response format of the Gemini generateContent API.
+ *
+ * Shared by AiConfig and the batch jobs so every caller talks to the same
+ * endpoint; the endpoint is configurable so tests can point it at a local
+ * stand-in server.
+ */
+namespace gemini {
+
+/**
+ * @brief Public API root, "https://generativelanguage.googleapis.com/v1beta"
+ */
+QUrl defaultEndpoint();
+
+/**
+ * @brief Model used when none is configured
+ */
+QString defaultModel();
+
+/**
+ * @brief POST request for <endpoint>/models/<model>:generateContent
+ */
+QNetworkRequest generateContentRequest(const QUrl& endpoint, const QString& model, const QString& apiKey);
+
+/**
+ * @brief POST request for <endpoint>/models/<model>:streamGenerateContent?alt=sse
+ *
+ * The answer arrives as server-sent events, each carrying one partial
+ * generateContent response; read them with SseParser and chunkText().
+ */
+QNetworkRequest streamGenerateContentRequest(const QUrl& endpoint, const QString& model, const QString& apiKey);
+
+/**
+ * @brief JSON body with prompt as the single user part
+ */
+QByteArray generateContentBody(const QString& prompt);
+
+/**
+ * @brief Text of the first candidate of a generateContent response
+ * @param error set to a message for the user when no text could be read
+ * @return the text, empty on error
+ */
+QString responseText(const QByteArray& json, QString* error);
+
+/**
+ * @brief Text of one streamed response chunk, all parts of the first candidate
+ *
+ * Chunks without text (e.g. the one carrying only finishReason) give an empty
+ * string and leave error alone.
+ */
+QString chunkText(const QByteArray& json, QString* error);
+
+/**
+ * @brief Incremental parser for a text/event-stream body.
+ *
+ * Bytes are fed as they arrive, split anywhere; feed() returns the data of
+ * every event completed by them and keeps the unfinished rest. Only data
+ * fields are collected, comments and other fields are skipped.
+ */
+class SseParser
+{
+public:
+    QList<QByteArray> feed(QByteArrayView chunk);
+
+    /**
+     * @brief Data of a last event the stream did not terminate with a blank line
+     */
+    QList<QByteArray> finish();
+
+private:
+    // unterminated line from the previous chunk
+    QByteArray m_line;
+    QByteArray m_data;
+    bool m_hasData = false;
+
+    void processLine(QByteArrayView line, QList<QByteArray>& events);
+};
+
+/**
+ * @brief Whether a failed call is worth repeating (timeouts, 429 and 5xx)
+ */
+bool isTransient(int httpStatus);
+
+}
+
+#endif // GEMINIAPI_H
@@ -1,67 +1,45 @@
 #include "homepage.h"
+#include "migrations.h"
 #include <QDebug>
 
 namespace homepage{
     ProjectView::ProjectView(DbmPtr db, QObject *parent)
     : QAbstractListModel{parent}, db_(db)
     {
+        m_subscriptions << db_->subscribe("projects", [this](const ChangeEvent& change) {
+            applyChange(change);
+        });
+        // category names are part of every row, so any change reloads
+        m_subscriptions << db_->subscribe("categories", [this](const ChangeEvent&) {
+            reload();
+        });
+        if (db_->database().isOpen())
+            reload();
+    }
 
-
+    ProjectView::~ProjectView()
+    {
+        for (int id : m_subscriptions)
+            db_->unsubscribe(id);
     }
 
 int ProjectView::rowCount(const QModelIndex &parent) const
 {
     if (parent.isValid())
         return 0;
-
-    QString sql = "SELECT name, id FROM categories";
-    auto cat_response = db_->queryRow(sql);
-
-    QMap<int, QString> catMap;
-    for(int i =0; i < cat_response.size(); i+= 2)
-    {
-        int j = i + 1;
-        catMap[cat_response[j].toInt()] = cat_response[i];
-    }
-
-    data_.clear();
-    sql = "SELECT name, category_id FROM projects";
-    auto project_response = db_->queryRow(sql);
-    for(int i =0; i < project_response.size(); i+=2)
-    {
-        int j = i + 1;
-        auto cat = catMap[project_response[j].toInt()];
-        data_[cat] << project_response[i];
-    }
-
-    // qInfo() << "Projects have following data \n" << data_;
-    return data_.size();
+    return groups_.size();
 }
 
     QVariant ProjectView::data(const QModelIndex &index, int role) const
     {
         int row = index.row();
-        if (!index.isValid() || row > data_.size())
+        if (!index.isValid() || row >= groups_.size())
             return QVariant();
 
-
-        int i = 0;
-        QVariant folderName, category;
-        for(const auto& item: data_.keys())
-        {
-            if(i == row)
-            {
-                folderName = item;
-                category = data_.value(item);
-                break;
-            }
-            ++i;
-        }
-
-        // qInfo() << "[FolderName]: " << folderName;
+        const auto& group = groups_.at(row);
         switch (role) {
-            case NameRole: return folderName;
-            case CategoryRole:   return category;
+            case NameRole: return group.name;
+            case CategoryRole:   return group.projectNames;
             default: return QVariant();
         }
     }
@@ -74,107 +52,179 @@ int ProjectView::rowCount(const QModelIndex &parent) const
         };
     }
 
+    void ProjectView::reload()
+    {
+        beginResetModel();
+        groups_.clear();
+        categoryNames_.clear();
+        projectCategory_.clear();
+
+        db_->forEachRow<int, QString>("SELECT id, name FROM categories", {},
+                                      [&](int id, const QString& name) {
+            categoryNames_[id] = name;
+        });
+
+        const auto projects = db_->selectRows<ProjectRow, int, QString, int>(
+            "SELECT id, name, category_id FROM projects ORDER BY category_id, id");
+        QList<std::pair<int, QString>> names;
+        names.reserve(projects.size());
+        for (const auto& project : projects) {
+            if (groups_.isEmpty() || groups_.last().categoryId != project.categoryId)
+                groups_.append({project.categoryId, categoryNames_.value(project.categoryId), {}, {}});
+            groups_.last().projectIds << project.id;
+            groups_.last().projectNames << project.name;
+            projectCategory_[project.id] = project.categoryId;
+            names.append({project.id, project.name});
+        }
+        m_searchIndex.rebuild(names);
+        endResetModel();
+
+        updateProjectsList();
+    }
+
+    int ProjectView::groupIndex(int categoryId) const
+    {
+        for (int i = 0; i < groups_.size(); ++i)
+            if (groups_.at(i).categoryId == categoryId)
+                return i;
+        return -1;
+    }
+
+    void ProjectView::applyChange(const ChangeEvent &change)
+    {
+        if (change.rowid < 0) {
+            reload();
+            return;
+        }
+
+        const int id = int(change.rowid);
+        // an update may move the project to another category
+        removeProject(id);
+        if (change.op != ChangeOp::Delete) {
+            const auto rows = db_->selectRows<ProjectRow, int, QString, int>(
+                "SELECT id, name, category_id FROM projects WHERE id = ?", {id});
+            if (!rows.isEmpty())
+                addProject(rows.first());
+        }
+        updateProjectsList();
+    }
+
+    void ProjectView::addProject(const ProjectRow &project)
+    {
+        projectCategory_[project.id] = project.categoryId;
+        m_searchIndex.insert(project.id, project.name);
+
+        int row = groupIndex(project.categoryId);
+        if (row < 0) {
+            row = 0;
+            while (row < groups_.size() && groups_.at(row).categoryId < project.categoryId)
+                ++row;
+            beginInsertRows(QModelIndex(), row, row);
+            groups_.insert(row, {project.categoryId, categoryNames_.value(project.categoryId),
+                                 {project.id}, {project.name}});
+            endInsertRows();
+            return;
+        }
+
+        auto& group = groups_[row];
+        int position = 0;
+        while (position < group.projectIds.size() && group.projectIds.at(position) < project.id)
+            ++position;
+        group.projectIds.insert(position, project.id);
+        group.projectNames.insert(position, project.name);
+        const QModelIndex modelIndex = createIndex(row, 0);
+        emit dataChanged(modelIndex, modelIndex, {CategoryRole});
+    }
+
+    void ProjectView::removeProject(int id)
+    {
+        auto it = projectCategory_.find(id);
+        if (it == projectCategory_.end())
+            return;
+        const int row = groupIndex(it.value());
+        projectCategory_.erase(it);
+        m_searchIndex.remove(id);
+        if (row < 0)
+            return;
+
+        auto& group = groups_[row];
+        const int position = group.projectIds.indexOf(id);
+        if (position < 0)
+            return;
+
+        if (group.projectIds.size() == 1) {
+            beginRemoveRows(QModelIndex(), row, row);
+            groups_.removeAt(row);
+            endRemoveRows();
+            return;
+        }
+        group.projectIds.removeAt(position);
+        group.projectNames.removeAt(position);
+        const QModelIndex modelIndex = createIndex(row, 0);
+        emit dataChanged(modelIndex, modelIndex, {CategoryRole});
+    }
+
     void ProjectView::deleteProject(const QString &projectName)
     {
         qInfo() << "[ProjectView]: deleting  project = " << projectName;
-        QString sqlCmd= QString("DELETE FROM projects WHERE name = '%1'").arg(projectName);
-        if(db_->deleteItem(sqlCmd))
+        QList<int> ids;
+        db_->forEachRow<int>("SELECT id FROM projects WHERE name = ?", {projectName},
+                             [&](int id) { ids << id; });
+
+        // the rows leave the model through the change feed
+        if(!ids.isEmpty() && db_->deleteByIds("projects", ids))
         {
-            qInfo() << "[DeadlineModel] success ";
+            qInfo() << "[ProjectView] success ";
         }
         else{
-            qInfo() << sqlCmd;
+            qInfo() << "[ProjectView] failed to delete project " << projectName;
         }
-
-        emit layoutChanged();
     }
 
     void ProjectView::setReserachDB(const QString &db_path)
     {
         qInfo() << "[ProjectView]: setReserachDB " << db_path;
         db_->connect(db_path);
-        ensureDefaultCategories();
-        updateProjectsList();
-        emit layoutChanged();
+        if (!db_->migrate(migrations::research())) {
+            qWarning() << "[ProjectView] Failed to migrate" << db_path;
+        }
+        // snapshot of the new workspace; kept current by the change feed afterwards.
+        // Seeding the categories already reloaded through that feed.
+        if (!ensureDefaultCategories())
+            reload();
     }
 
-    void ProjectView::ensureDefaultCategories()
+    bool ProjectView::ensureDefaultCategories()
     {
         // Check if categories already exist
-        QString checkSql = "SELECT COUNT(*) FROM categories";
-        auto result = db_->queryRow(checkSql);
-        if (!result.isEmpty() && result[0].toInt() > 0) {
+        if (db_->selectValue<int>("SELECT COUNT(*) FROM categories") > 0) {
             qInfo() << "[ProjectView]: Categories already exist, skipping initialization";
-            return;
+            return false;
         }
 
         // Create default categories for existing databases
         QStringList defaultCategories = {"Research Projects", "Publications", "Presentations", "Grants & Funding", "Teaching", "Service"};
 
+        QList<QVariantList> rows;
         for (int i = 0; i < defaultCategories.size(); ++i) {
-            auto query = db_->getBinder(
-                "INSERT INTO categories (id, name, year_id) VALUES (:id, :name, :year)"
-            );
-            query.bindValue(":id", i + 1);
-            query.bindValue(":name", defaultCategories[i]);
-            query.bindValue(":year", 0); // year_id can be 0 for general categories
-
-            if (!query.exec()) {
-                qWarning() << "[ProjectView] Failed to insert default category:" << defaultCategories[i]
-                          << query.lastError().text();
-            } else {
-                qInfo() << "[ProjectView] Added default category:" << defaultCategories[i];
-            }
+            // year_id can be 0 for general categories
+            rows.append({i + 1, defaultCategories[i], 0});
+        }
+
+        if (!db_->insertBatch("categories", {"id", "name", "year_id"}, rows)) {
+            qWarning() << "[ProjectView] Failed to insert default categories";
+            return false;
         }
 
         qInfo() << "[ProjectView] Initialized" << defaultCategories.size() << "default categories for existing database";
+        return true;
     }
 
     void ProjectView::searchProjects(const QString &searchText)
     {
-        m_searchSuggestions.clear();
-        
-        if (searchText.isEmpty()) {
-            emit searchSuggestionsChanged();
-            return;
-        }
-        
-        // Get all project names from data_
-        QStringList allProjectNames = getAllProjectNames();
-        
-        // Filter projects that contain the search text (case-insensitive)
-        QString lowerSearchText = searchText.toLower();
-        for (const QString &projectName : allProjectNames) {
-            if (projectName.toLower().contains(lowerSearchText)) {
-                m_searchSuggestions.append(projectName);
-            }
-        }
-        
-        // Sort suggestions: exact matches first, then prefix matches, then contains
-        std::sort(m_searchSuggestions.begin(), m_searchSuggestions.end(),
-                  [&lowerSearchText](const QString &a, const QString &b) {
-            QString lowerA = a.toLower();
-            QString lowerB = b.toLower();
-            
-            // Exact match
-            bool aExact = (lowerA == lowerSearchText);
-            bool bExact = (lowerB == lowerSearchText);
-            if (aExact != bExact) return aExact;
-            
-            // Starts with
-            bool aStarts = lowerA.startsWith(lowerSearchText);
-            bool bStarts = lowerB.startsWith(lowerSearchText);
-            if (aStarts != bStarts) return aStarts;
-            
-            // Alphabetical
-            return a < b;
-        });
-        
-        // Limit to top 10 suggestions
-        if (m_searchSuggestions.size() > 10) {
-            m_searchSuggestions = m_searchSuggestions.mid(0, 10);
-        }
-        
+        // ranked exact > prefix > word start > substring > typo, top 10
+        m_searchSuggestions = m_searchIndex.suggest(searchText, 10);
+
         qInfo() << "[ProjectView]: Search for '" << searchText << "' found" << m_searchSuggestions.size() << "matches";
         emit searchSuggestionsChanged();
     }
@@ -184,9 +234,8 @@ int ProjectView::rowCount(const QModelIndex &parent) const
         QStringList allNames;
         
         // Iterate through all categories and collect project names
-        for (const QString &category : data_.keys()) {
-            const QStringList &projects = data_.value(category);
-            for (const QString &projectName : projects) {
+        for (const auto &group : groups_) {
+            for (const QString &projectName : group.projectNames) {
                 if (!projectName.isEmpty()) {
                     allNames.append(projectName);
                 }
@@ -204,9 +253,7 @@ int ProjectView::rowCount(const QModelIndex &parent) const
 
     bool ProjectView::isValidProject(const QString &folder)
     {
-        auto allProjects = getAllProjectNames();
-        qInfo() << allProjects;
-        return allProjects.contains(folder, Qt::CaseInsensitive);
+        return !folder.isEmpty() && m_searchIndex.contains(folder);
     }
     
     void ProjectView::updateProjectsList()
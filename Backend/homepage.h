@@ -3,9 +3,11 @@
 
 #include <QObject>
 #include <QHash>
+#include <QList>
 #include <QMap>
 #include <QAbstractListModel>
 #include "database.h"
+#include "projectsearchindex.h"
 
 namespace homepage{
 
@@ -17,6 +19,7 @@ class ProjectView : public QAbstractListModel
     
 public:
     explicit ProjectView(DbmPtr db, QObject *parent = nullptr);
+    ~ProjectView() override;
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
 
@@ -49,13 +52,39 @@ private:
         CategoryRole
     };
 
-    mutable QHash<QString, QStringList> data_;
+    // one row per category that has projects, ordered by category id
+    struct CategoryGroup {
+        int categoryId;
+        QString name;
+        QList<int> projectIds;
+        QStringList projectNames;
+    };
+
+    struct ProjectRow {
+        int id;
+        QString name;
+        int categoryId;
+    };
+
+    QList<CategoryGroup> groups_;
+    QHash<int, QString> categoryNames_;
+    // project id -> category id, to find the group of a deleted project
+    QHash<int, int> projectCategory_;
+    // autocomplete over the project names of the snapshot
+    ProjectSearchIndex m_searchIndex;
     DbmPtr db_;
     QStringList m_searchSuggestions;
     QStringList m_allProjects;
+    QList<int> m_subscriptions;
 
+    void reload();
+    void applyChange(const ChangeEvent& change);
+    void addProject(const ProjectRow& project);
+    void removeProject(int id);
+    int groupIndex(int categoryId) const;
     void updateProjectsList();
-    void ensureDefaultCategories();
+    // true when the defaults were inserted (and the change feed reloaded the model)
+    bool ensureDefaultCategories();
 
 };
 
@@ -0,0 +1,242 @@
+#include "linkhealthchecker.h"
+#include <QNetworkRequest>
+#include <QDateTime>
+#include <QTimer>
+#include <QDebug>
+
+using namespace project;
+
+LinkHealthChecker::LinkHealthChecker(DbmPtr db, QNetworkAccessManager *network, QObject *parent)
+    : QObject{parent}, db_(db), m_network(network)
+{
+    if (!m_network)
+        m_network = new QNetworkAccessManager(this);
+}
+
+LinkHealthChecker::~LinkHealthChecker()
+{
+    // replies belong to the shared manager, make sure none calls back into a deleted checker
+    for (auto* reply : m_active.keys()) {
+        disconnect(reply, nullptr, this, nullptr);
+        reply->abort();
+        reply->deleteLater();
+    }
+}
+
+bool LinkHealthChecker::isRunning() const
+{
+    return m_running;
+}
+
+int LinkHealthChecker::maxConcurrent() const
+{
+    return m_maxConcurrent;
+}
+
+void LinkHealthChecker::setMaxConcurrent(int count)
+{
+    m_maxConcurrent = qMax(1, count);
+}
+
+int LinkHealthChecker::maxPerHost() const
+{
+    return m_maxPerHost;
+}
+
+void LinkHealthChecker::setMaxPerHost(int count)
+{
+    m_maxPerHost = qMax(1, count);
+}
+
+int LinkHealthChecker::timeoutMs() const
+{
+    return m_timeoutMs;
+}
+
+void LinkHealthChecker::setTimeoutMs(int ms)
+{
+    m_timeoutMs = ms;
+}
+
+qint64 LinkHealthChecker::staleAfter() const
+{
+    return m_staleAfter;
+}
+
+void LinkHealthChecker::setStaleAfter(qint64 seconds)
+{
+    m_staleAfter = seconds;
+}
+
+bool LinkHealthChecker::isBroken(int status)
+{
+    return status == 0 || status >= 400;
+}
+
+int LinkHealthChecker::check(int projectId)
+{
+    struct LinkUrl { int id; QString url; };
+    const qint64 oldest = QDateTime::currentSecsSinceEpoch() - m_staleAfter;
+    const auto links = db_->selectRows<LinkUrl, int, QString>(
+        "SELECT l.id, l.url FROM links l LEFT JOIN link_health h ON h.link_id = l.id "
+        "WHERE (? < 0 OR l.project_id = ?) AND (h.checked_at IS NULL OR h.checked_at <= ?) ORDER BY l.id",
+        {projectId, projectId, oldest});
+
+    if (!m_running) {
+        m_checked = 0;
+        m_broken = 0;
+    }
+
+    int queued = 0;
+    for (const auto& link : links) {
+        if (m_pending.contains(link.id))
+            continue;
+
+        Probe probe;
+        probe.linkId = link.id;
+        probe.url = QUrl::fromUserInput(link.url.trimmed());
+        const QString scheme = probe.url.scheme();
+        if (!probe.url.isValid() || (scheme != "http" && scheme != "https")) {
+            record(probe, 0, QUrl(), QStringLiteral("unsupported URL"));
+            continue;
+        }
+        probe.host = probe.url.host().toLower() + ':' + QString::number(probe.url.port(scheme == "https" ? 443 : 80));
+        m_queue.append(probe);
+        m_pending.insert(link.id);
+        ++queued;
+    }
+
+    qInfo() << "[LinkHealthChecker] queued" << queued << "of" << links.size() << "stale links";
+    if (queued > 0 && !m_running) {
+        m_running = true;
+        emit runningChanged();
+    }
+    dispatch();
+    return queued;
+}
+
+void LinkHealthChecker::cancel()
+{
+    m_queue.clear();
+    const auto replies = m_active.keys();
+    m_active.clear();
+    m_perHost.clear();
+    m_pending.clear();
+    for (auto* reply : replies) {
+        disconnect(reply, nullptr, this, nullptr);
+        reply->abort();
+        reply->deleteLater();
+    }
+
+    if (m_running) {
+        m_running = false;
+        emit finished(m_checked, m_broken);
+        emit runningChanged();
+    }
+}
+
+void LinkHealthChecker::dispatch()
+{
+    // first queued link whose host still has a free slot
+    for (int i = 0; i < m_queue.size() && m_active.size() < m_maxConcurrent;) {
+        if (m_perHost.value(m_queue.at(i).host) >= m_maxPerHost) {
+            ++i;
+            continue;
+        }
+        send(m_queue.takeAt(i));
+    }
+
+    if (m_running && m_queue.isEmpty() && m_active.isEmpty()) {
+        m_running = false;
+        qInfo() << "[LinkHealthChecker] checked" << m_checked << "links," << m_broken << "broken";
+        emit finished(m_checked, m_broken);
+        emit runningChanged();
+    }
+}
+
+void LinkHealthChecker::send(Probe probe)
+{
+    QNetworkRequest request(probe.url);
+    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
+
+    QNetworkReply* reply = nullptr;
+    if (probe.ranged) {
+        // only the status line matters, the body is cut off as soon as headers arrive
+        request.setRawHeader("Range", "bytes=0-0");
+        reply = m_network->get(request);
+        connect(reply, &QNetworkReply::metaDataChanged, this, [this, reply]() { onMetaData(reply); });
+        connect(reply, &QNetworkReply::readyRead, this, [this, reply]() { onMetaData(reply); });
+    } else {
+        reply = m_network->head(request);
+    }
+
+    probe.latency.start();
+    ++m_perHost[probe.host];
+    m_active.insert(reply, probe);
+
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() { onFinished(reply); });
+    QTimer::singleShot(m_timeoutMs, reply, [reply]() {
+        reply->setProperty("timedOut", true);
+        reply->abort();
+    });
+}
+
+void LinkHealthChecker::onMetaData(QNetworkReply *reply)
+{
+    const QVariant status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute);
+    if (!status.isValid() || reply->property("enough").toBool())
+        return;
+    // headers of a redirect that is about to be followed
+    if (status.toInt() >= 300 && status.toInt() < 400)
+        return;
+    reply->setProperty("enough", true);
+    reply->abort();
+}
+
+void LinkHealthChecker::onFinished(QNetworkReply *reply)
+{
+    auto it = m_active.find(reply);
+    if (it == m_active.end())
+        return;
+    Probe probe = it.value();
+    m_active.erase(it);
+    reply->deleteLater();
+    if (--m_perHost[probe.host] <= 0)
+        m_perHost.remove(probe.host);
+
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (!probe.ranged && status >= 400 && status != 404 && status != 410) {
+        // servers refusing HEAD answer 405, 501 or an arbitrary 4xx; ask for one byte instead
+        probe.ranged = true;
+        m_queue.prepend(probe);
+    } else if (status > 0) {
+        record(probe, status, reply->url(),
+               status >= 400 ? reply->attribute(QNetworkRequest::HttpReasonPhraseAttribute).toString() : QString());
+    } else {
+        const QString error = reply->property("timedOut").toBool()
+                                  ? QStringLiteral("timed out after %1 ms").arg(m_timeoutMs)
+                                  : reply->errorString();
+        record(probe, 0, QUrl(), error);
+    }
+    dispatch();
+}
+
+void LinkHealthChecker::record(const Probe &probe, int status, const QUrl &finalUrl, const QString &error)
+{
+    const qint64 latency = probe.latency.isValid() ? probe.latency.elapsed() : 0;
+    // the link may have been deleted while it was being checked
+    if (!db_->exec("INSERT OR REPLACE INTO link_health (link_id, status, final_url, latency_ms, error, checked_at) "
+                   "SELECT ?, ?, ?, ?, ?, ? WHERE EXISTS (SELECT 1 FROM links WHERE id = ?)",
+                   {probe.linkId, status, finalUrl.isEmpty() ? QVariant() : QVariant(finalUrl.toString()),
+                    latency, error.isEmpty() ? QVariant() : QVariant(error),
+                    QDateTime::currentSecsSinceEpoch(), probe.linkId}))
+        qWarning() << "[LinkHealthChecker] failed to record link" << probe.linkId;
+
+    ++m_checked;
+    if (isBroken(status))
+        ++m_broken;
+    m_pending.remove(probe.linkId);
+
+    db_->notifyChange("links", probe.linkId, ChangeOp::Update);
+    emit linkChecked(probe.linkId, status);
+}
@@ -0,0 +1,103 @@
+#ifndef LINKHEALTHCHECKER_H
+#define LINKHEALTHCHECKER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QSet>
+#include <QUrl>
+#include "database.h"
+
+namespace project {
+/**
+ * @class LinkHealthChecker
+ * @brief Checks the saved links of a workspace in the background.
+ *
+ * check() queues every link whose last result is missing or older than
+ * staleAfter() seconds, so repeated runs only revisit stale entries. Links are
+ * probed concurrently over a shared QNetworkAccessManager, at most
+ * maxConcurrent() requests in total and maxPerHost() per host. Each probe is a
+ * HEAD request; when a server refuses HEAD the link is fetched again with a
+ * GET for its first byte only. Redirects are followed.
+ *
+ * The status code, final URL, latency and error of every link are stored in
+ * the link_health table and published as an update of the link, so LinkViewer
+ * refreshes the row through the change feed.
+ */
+class LinkHealthChecker : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged FINAL)
+public:
+    explicit LinkHealthChecker(DbmPtr db, QNetworkAccessManager *network, QObject *parent = nullptr);
+    ~LinkHealthChecker() override;
+
+    /**
+     * @brief Queue the stale links of projectId, or of the whole workspace when projectId < 0
+     * @return number of links queued
+     */
+    Q_INVOKABLE int check(int projectId = -1);
+    Q_INVOKABLE void cancel();
+
+    bool isRunning() const;
+
+    int maxConcurrent() const;
+    void setMaxConcurrent(int count);
+
+    int maxPerHost() const;
+    void setMaxPerHost(int count);
+
+    int timeoutMs() const;
+    void setTimeoutMs(int ms);
+
+    qint64 staleAfter() const;
+    void setStaleAfter(qint64 seconds);
+
+    /**
+     * @brief Whether a recorded status means the link is broken; 0 is a network error, -1 not checked yet
+     */
+    static bool isBroken(int status);
+
+signals:
+    void linkChecked(int linkId, int status);
+    void finished(int checked, int broken);
+    void runningChanged();
+
+private:
+    struct Probe {
+        int linkId;
+        QUrl url;
+        QString host;
+        QElapsedTimer latency;
+        bool ranged = false;
+    };
+
+    DbmPtr db_;
+    QNetworkAccessManager* m_network;
+    QList<Probe> m_queue;
+    QHash<QNetworkReply*, Probe> m_active;
+    QHash<QString, int> m_perHost;
+    // links queued or in flight, never probed twice in one run
+    QSet<int> m_pending;
+    bool m_running = false;
+    int m_checked = 0;
+    int m_broken = 0;
+
+    int m_maxConcurrent = 8;
+    int m_maxPerHost = 2;
+    int m_timeoutMs = 10000;
+    qint64 m_staleAfter = 7 * 24 * 3600;
+
+    void dispatch();
+    void send(Probe probe);
+    void onMetaData(QNetworkReply* reply);
+    void onFinished(QNetworkReply* reply);
+    void record(const Probe& probe, int status, const QUrl& finalUrl, const QString& error);
+};
+
+} // namespace project
+
+#endif // LINKHEALTHCHECKER_H
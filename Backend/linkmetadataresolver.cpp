@@ -0,0 +1,180 @@
+#include "linkmetadataresolver.h"
+#include <QNetworkRequest>
+#include <QRegularExpression>
+#include <QDateTime>
+#include <QTimer>
+#include <QUrl>
+#include <QDebug>
+
+using namespace project;
+
+LinkMetadataResolver::LinkMetadataResolver(DbmPtr cache, QNetworkAccessManager *network, QObject *parent)
+    : QObject{parent}, cache_(cache), m_manager(network)
+{
+    if (!m_manager)
+        m_manager = new QNetworkAccessManager(this);
+}
+
+LinkMetadataResolver::~LinkMetadataResolver()
+{
+    // no signals from replies aborted during destruction
+    for (auto* reply : std::as_const(m_inFlight)) {
+        disconnect(reply, nullptr, this, nullptr);
+        reply->abort();
+    }
+}
+
+int LinkMetadataResolver::timeoutMs() const
+{
+    return m_timeoutMs;
+}
+
+void LinkMetadataResolver::setTimeoutMs(int ms)
+{
+    m_timeoutMs = ms;
+}
+
+qint64 LinkMetadataResolver::maxBytes() const
+{
+    return m_maxBytes;
+}
+
+void LinkMetadataResolver::setMaxBytes(qint64 bytes)
+{
+    m_maxBytes = bytes;
+}
+
+qint64 LinkMetadataResolver::cacheTtl() const
+{
+    return m_cacheTtl;
+}
+
+void LinkMetadataResolver::setCacheTtl(qint64 seconds)
+{
+    m_cacheTtl = seconds;
+}
+
+QString LinkMetadataResolver::cachedTitle(const QString &url)
+{
+    if (!cache_)
+        return QString();
+    const qint64 oldest = QDateTime::currentSecsSinceEpoch() - m_cacheTtl;
+    return cache_->selectValue<QString>("SELECT title FROM LinkMetadata WHERE url = ? AND fetched_at > ?",
+                                        {url, oldest});
+}
+
+void LinkMetadataResolver::store(const QString &url, const QString &title)
+{
+    if (!cache_)
+        return;
+    if (!cache_->exec("INSERT OR REPLACE INTO LinkMetadata (url, title, fetched_at) VALUES (?, ?, ?)",
+                      {url, title, QDateTime::currentSecsSinceEpoch()}))
+        qWarning() << "[LinkMetadataResolver] failed to cache" << url;
+}
+
+void LinkMetadataResolver::resolve(const QString &url)
+{
+    if (m_inFlight.contains(url))
+        return;
+
+    QNetworkRequest request{QUrl(url)};
+    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
+    request.setRawHeader("Accept", "text/html,application/xhtml+xml");
+
+    QNetworkReply* reply = m_manager->get(request);
+    // reply->url() follows redirects, results are reported for the requested url
+    reply->setProperty("sourceUrl", url);
+    m_inFlight.insert(url, reply);
+    m_buffers.insert(reply, QByteArray());
+
+    connect(reply, &QNetworkReply::readyRead, this, [this, reply]() { onReadyRead(reply); });
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() { finish(reply); });
+    // overall deadline, also for servers that trickle bytes forever
+    QTimer::singleShot(m_timeoutMs, reply, [reply]() {
+        reply->setProperty("timedOut", true);
+        reply->abort();
+    });
+}
+
+void LinkMetadataResolver::onReadyRead(QNetworkReply *reply)
+{
+    auto it = m_buffers.find(reply);
+    if (it == m_buffers.end())
+        return;
+
+    const qsizetype scanned = it->size();
+    it->append(reply->read(qMax<qint64>(0, m_maxBytes - it->size())));
+    // only the new bytes, plus enough of the old ones for a marker split between
+    // chunks, can end a name; the full extraction runs once one has been seen
+    const qsizetype overlap = qsizetype(sizeof("og:site_name")) - 2;
+    const QByteArray fresh = it->mid(qMax<qsizetype>(0, scanned - overlap)).toLower();
+    if (fresh.contains("</title") || fresh.contains("og:site_name"))
+        reply->setProperty("marker", true);
+    bool complete = false;
+    if (reply->property("marker").toBool())
+        extractTitle(*it, &complete);
+    if (complete || it->size() >= m_maxBytes) {
+        // the rest of the page is not needed; finish() runs from abort()
+        reply->setProperty("enough", true);
+        reply->abort();
+    }
+}
+
+void LinkMetadataResolver::finish(QNetworkReply *reply)
+{
+    const QString url = reply->property("sourceUrl").toString();
+    QByteArray body = m_buffers.take(reply);
+    m_inFlight.remove(url);
+    reply->deleteLater();
+
+    const bool enough = reply->property("enough").toBool();
+    if (reply->error() != QNetworkReply::NoError && !enough) {
+        const QString error = reply->property("timedOut").toBool()
+                                  ? QStringLiteral("timed out after %1 ms").arg(m_timeoutMs)
+                                  : reply->errorString();
+        qInfo() << "[LinkMetadataResolver]" << url << error;
+        emit failed(url, error);
+        return;
+    }
+    if (!enough)
+        body.append(reply->read(qMax<qint64>(0, m_maxBytes - body.size())));
+
+    QString title = extractTitle(body);
+    if (title.isEmpty())
+        title = QUrl(url).host();
+    store(url, title);
+    emit resolved(url, title);
+}
+
+QString LinkMetadataResolver::extractTitle(const QByteArray &html, bool *complete)
+{
+    static const QRegularExpression titleRegex("<title[^>]*>(.*?)</title>",
+                                               QRegularExpression::CaseInsensitiveOption
+                                                   | QRegularExpression::DotMatchesEverythingOption);
+    // og:site_name with either attribute order
+    static const QRegularExpression metaRegex(
+        "<meta[^>]*property=[\"']og:site_name[\"'][^>]*content=[\"']([^\"']*)[\"']"
+        "|<meta[^>]*content=[\"']([^\"']*)[\"'][^>]*property=[\"']og:site_name[\"']",
+        QRegularExpression::CaseInsensitiveOption);
+
+    auto decode = [](QString text) {
+        text.replace("&lt;", "<").replace("&gt;", ">").replace("&quot;", "\"")
+            .replace("&#39;", "'").replace("&#x27;", "'").replace("&nbsp;", " ").replace("&amp;", "&");
+        return text.simplified();
+    };
+
+    const QString text = QString::fromUtf8(html);
+    const auto titleMatch = titleRegex.match(text);
+    const auto metaMatch = metaRegex.match(text);
+    if (complete)
+        *complete = titleMatch.hasMatch() || metaMatch.hasMatch();
+
+    if (titleMatch.hasMatch()) {
+        const QString title = decode(titleMatch.captured(1));
+        if (!title.isEmpty())
+            return title;
+    }
+    if (metaMatch.hasMatch())
+        return decode(metaMatch.captured(1).isEmpty() ? metaMatch.captured(2) : metaMatch.captured(1));
+    return QString();
+}
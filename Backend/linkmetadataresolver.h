@@ -0,0 +1,78 @@
+#ifndef LINKMETADATARESOLVER_H
+#define LINKMETADATARESOLVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include "database.h"
+
+namespace project {
+/**
+ * @class LinkMetadataResolver
+ * @brief Fetches the display name of a web page in the background.
+ *
+ * resolve() issues an asynchronous GET with a transfer timeout and reads the
+ * body only until a <title> or og:site_name has been seen, or maxBytes()
+ * arrived; the reply is then aborted. Names are cached by URL in the
+ * LinkMetadata table of the config database and reused for cacheTtl()
+ * seconds, so known pages cost no network at all. Requests for a URL that
+ * is already in flight are merged. Without a network manager the resolver
+ * creates its own.
+ */
+class LinkMetadataResolver : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LinkMetadataResolver(DbmPtr cache, QNetworkAccessManager *network = nullptr,
+                                  QObject *parent = nullptr);
+    ~LinkMetadataResolver() override;
+
+    /**
+     * @brief Cached name of url, or an empty string when unknown or expired
+     */
+    QString cachedTitle(const QString& url);
+
+    /**
+     * @brief Start fetching url; ends with resolved() or failed()
+     */
+    void resolve(const QString& url);
+
+    int timeoutMs() const;
+    void setTimeoutMs(int ms);
+
+    qint64 maxBytes() const;
+    void setMaxBytes(qint64 bytes);
+
+    qint64 cacheTtl() const;
+    void setCacheTtl(qint64 seconds);
+
+    /**
+     * @brief Name found in a (possibly truncated) HTML prefix: <title> first, then og:site_name
+     *
+     * complete is set once the name can no longer change with more input.
+     */
+    static QString extractTitle(const QByteArray& html, bool* complete = nullptr);
+
+signals:
+    void resolved(const QString& url, const QString& title);
+    void failed(const QString& url, const QString& error);
+
+private:
+    DbmPtr cache_;
+    QNetworkAccessManager* m_manager;
+    // in-flight replies and the body read so far
+    QHash<QNetworkReply*, QByteArray> m_buffers;
+    QHash<QString, QNetworkReply*> m_inFlight;
+    int m_timeoutMs = 8000;
+    qint64 m_maxBytes = 256 * 1024;
+    qint64 m_cacheTtl = 30 * 24 * 3600;
+
+    void onReadyRead(QNetworkReply* reply);
+    void finish(QNetworkReply* reply);
+    void store(const QString& url, const QString& title);
+};
+
+} // namespace project
+
+#endif // LINKMETADATARESOLVER_H
@@ -1,131 +1,121 @@
 #include "linkviewer.h"
+#include <QUrl>
 using namespace project;
 
 LinkViewer::LinkViewer(DbmPtr dbm, QObject *parent)
-    : QAbstractListModel{parent}, db_(dbm), m_projectId(-1)
+    : SqlListModel(dbm, "links", {
+          bindRole<&WebData::url>(UrlRole, "url"),
+          bindRole<&WebData::website>(WebsiteRole, "website"),
+          bindRole<&WebData::checked>(CheckBoxRole, "checked"),
+          bindRole<&WebData::status>(StatusRole, "status"),
+          {BrokenRole, "broken", [](const WebData& web) {
+               return QVariant(web.status >= 0 && LinkHealthChecker::isBroken(web.status));
+           }},
+          bindRole<&WebData::finalUrl>(FinalUrlRole, "finalUrl"),
+          bindRole<&WebData::latencyMs>(LatencyRole, "latency"),
+          bindRole<&WebData::error>(ErrorRole, "error")
+      }, parent), m_projectId(-1)
 {
-
 }
 
-int LinkViewer::rowCount(const QModelIndex &parent) const
+void LinkViewer::refresh()
 {
-    if(m_projectId < 0) return 0;
-
-    QString sqlCmd= QString("SELECT id, website, url FROM links WHERE project_id = %1").arg(m_projectId);
-    auto results = db_->queryRow(sqlCmd);
-    web_map_.clear();
-
-    int index = 0;
-    for(int i = 0; i < results.size(); i+=3)
+    if(m_projectId < 0)
     {
-        int j = i + 1;
-        int k = i + 2;
-
-        WebData web;
-        web.checked = false;
-        web.index = index;
-        web.id = results[i].toInt();
-        web.website = results[j];
-        web.url = results[k];
-        web_map_[index] = web;
-        ++index;
+        setRows({});
+        return;
     }
-
-    return web_map_.size();
+    setRows(db_->selectRows<WebData, int, QString, QString, int, QString, int, QString>(
+        "SELECT l.id, l.website, l.url, COALESCE(h.status, -1), h.final_url, h.latency_ms, h.error "
+        "FROM links l LEFT JOIN link_health h ON h.link_id = l.id WHERE l.project_id = ? ORDER BY l.id",
+        {m_projectId}));
 }
 
-QVariant LinkViewer::data(const QModelIndex &index, int role) const
+std::optional<WebData> LinkViewer::fetchRow(int id)
 {
-    int row = index.row();
-    if (!index.isValid() || m_projectId < 0 || !web_map_.contains(row))
-        return QVariant();
-
-    auto web = web_map_[row];
-    switch (role) {
-        case UrlRole: return web.url;
-        case WebsiteRole:   return web.website;
-        case  CheckBoxRole:   return web.checked;
-        default: return QVariant();
-    }
+    const auto found = db_->selectRows<WebData, int, QString, QString, int, QString, int, QString>(
+        "SELECT l.id, l.website, l.url, COALESCE(h.status, -1), h.final_url, h.latency_ms, h.error "
+        "FROM links l LEFT JOIN link_health h ON h.link_id = l.id WHERE l.id = ? AND l.project_id = ?",
+        {id, m_projectId});
+    if(found.isEmpty())
+        return std::nullopt;
+    return found.first();
 }
 
-QHash<int, QByteArray> LinkViewer::roleNames() const
+void LinkViewer::mergeRow(WebData &current, const WebData &fetched) const
 {
-    return {
-        { UrlRole, "url" },
-        { WebsiteRole,   "website" },
-        {CheckBoxRole, "checked"}
-    };
+    const bool checked = current.checked;
+    current = fetched;
+    current.checked = checked;
 }
 
 void LinkViewer::projectIdChanged(int id)
 {
     m_projectId = id;
     qInfo() << "[LinkViewer] project id updated = " << id;
-    emit layoutChanged();
+    refresh();
 }
 
-QString LinkViewer::getWebsiteName(const QString &urlString)
+void LinkViewer::setMetadataResolver(LinkMetadataResolver *resolver)
 {
-    QUrl url(urlString);
-    QNetworkRequest request(url);
-
-    // Sync wait (similar to Python's requests.get)
-    QNetworkReply *reply = m_manager.get(request);
-    QEventLoop loop;
-    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    loop.exec();
-
-    if (reply->error() != QNetworkReply::NoError) {
-        qDebug() << "Error fetching URL:" << reply->errorString();
-        reply->deleteLater();
-        return url.host();
+    if(m_resolver)
+        disconnect(m_resolver, nullptr, this, nullptr);
+    m_resolver = resolver;
+    if(m_resolver)
+    {
+        connect(m_resolver, &LinkMetadataResolver::resolved, this, &LinkViewer::titleResolved);
+        connect(m_resolver, &LinkMetadataResolver::failed, this, [this](const QString& url) {
+            // keep the host name
+            m_pendingTitles.remove(url);
+        });
     }
+}
 
-    QString html = QString::fromUtf8(reply->readAll());
-    reply->deleteLater();
+void LinkViewer::setHealthChecker(LinkHealthChecker *checker)
+{
+    m_checker = checker;
+}
 
-    // 1. Try to find <title> tag
-    QRegularExpression titleRegex("<title>(.*?)</title>", QRegularExpression::CaseInsensitiveOption);
-    QRegularExpressionMatch titleMatch = titleRegex.match(html);
-    if (titleMatch.hasMatch()) {
-        return titleMatch.captured(1).trimmed();
-    }
+void LinkViewer::checkLinks()
+{
+    if(!m_checker || m_projectId < 0)
+        return;
+    m_checker->check(m_projectId);
+}
 
-    // 2. Try to find meta og:site_name
-    // Matches: <meta property="og:site_name" content="TheName">
-    QRegularExpression metaRegex("<meta[^>]*property=[\"']og:site_name[\"'][^>]*content=[\"'](.*?)[\"']",
-                                 QRegularExpression::CaseInsensitiveOption);
-    QRegularExpressionMatch metaMatch = metaRegex.match(html);
-    if (metaMatch.hasMatch()) {
-        return metaMatch.captured(1).trimmed();
+void LinkViewer::titleResolved(const QString &url, const QString &title)
+{
+    const QList<int> ids = m_pendingTitles.values(url);
+    m_pendingTitles.remove(url);
+    // the workspace was switched meanwhile; the ids are rows of the old database
+    if(db_->database().databaseName() != m_pendingDatabase)
+    {
+        m_pendingTitles.clear();
+        return;
     }
-
-    return url.host();
+    for(int id : ids)
+        db_->updateRow("links", id, {"website"}, {title});
 }
 
-
 void LinkViewer::checkData(int index, bool value)
 {
-    if(!web_map_.contains(index))
+    if(index < 0 || index >= rows().size())
         return;
 
-    web_map_[index].checked = value;
+    rowAt(index).checked = value;
 
     // Notify view that this item has changed
-    QModelIndex modelIndex = createIndex(index, 0);
-    emit dataChanged(modelIndex, modelIndex, {CheckBoxRole});
-
-    // debug purposes only
-    for(const auto& val:web_map_.values())
-        if(val.checked)
-            qInfo() << "[LinkViewer] checked = " << val.index;
+    rowsChanged(index, index, {CheckBoxRole});
 }
 
 void LinkViewer::addLink(const QString &rlink)
 {
     QString link = rlink.trimmed();
-    QString website = getWebsiteName(link);
+    // known pages are named from the cache; others show the host until the title arrives
+    QString website = m_resolver ? m_resolver->cachedTitle(link) : QString();
+    const bool fetchTitle = website.isEmpty() && m_resolver;
+    if(website.isEmpty())
+        website = QUrl(link).host();
     QString safeDescription = ""; // Use actual empty string, QSqlQuery handles nulls/empties
 
     qInfo() << "[LinkViewer]: website =" << website;
@@ -140,76 +130,47 @@ void LinkViewer::addLink(const QString &rlink)
     // // 4. Execute (Assuming your db_ helper can accept a QSqlQuery or just use query.exec())
     // db_->updateDB(sqlCmd);
 
-    auto query = db_->getBinder(
-        "INSERT INTO links (url, website, description, project_id) "
-        "VALUES (:url, :web, :desc, :pid)"
-        );
-
-    query.bindValue(":url", link);
-    query.bindValue(":web", website);
-    query.bindValue(":desc", safeDescription);
-    query.bindValue(":pid", m_projectId);
-    query.exec();
-
-    emit layoutChanged();
+    // the new row reaches the model through the change feed
+    const qint64 id = db_->insertRow("links", {"url", "website", "description", "project_id"},
+                                     {link, website, safeDescription, m_projectId});
+    if(id >= 0 && fetchTitle)
+    {
+        const QString database = db_->database().databaseName();
+        if(database != m_pendingDatabase)
+        {
+            m_pendingTitles.clear();
+            m_pendingDatabase = database;
+        }
+        m_pendingTitles.insert(link, int(id));
+        m_resolver->resolve(link);
+    }
 }
 
 void LinkViewer::deleteLinks()
 {
-    QList<int> indicesToRemove;
     QList<int> idsToDelete;
-
-    // Collect indices and IDs to delete
-    for(const auto& pair : web_map_.toStdMap())
+    for(const auto& web : rows())
     {
-        if(pair.second.checked)
-        {
-            indicesToRemove.append(pair.first);
-            idsToDelete.append(pair.second.id);
-        }
+        if(web.checked)
+            idsToDelete.append(web.id);
     }
 
     if(idsToDelete.isEmpty())
         return;
 
-    // Delete from database
-    for(int id : idsToDelete)
+    // removed rows are taken out by the change feed
+    if(db_->deleteByIds("links", idsToDelete))
     {
-        QString sqlCmd = QString("DELETE FROM links WHERE id = %1").arg(id);
-        if(db_->deleteItem(sqlCmd))
-        {
-            qInfo() << "[LinkViewer] deleted link id " << id;
-        }
-        else{
-            qInfo() << "Failed to delete link: " << sqlCmd;
-        }
+        qInfo() << "[LinkViewer] deleted links " << idsToDelete;
     }
-
-    // Remove from model in reverse order to maintain indices
-    std::sort(indicesToRemove.begin(), indicesToRemove.end(), std::greater<int>());
-    for(int index : indicesToRemove)
-    {
-        beginRemoveRows(QModelIndex(), index, index);
-        web_map_.remove(index);
-        endRemoveRows();
-    }
-
-    // Update remaining indices
-    QMap<int, WebData> updatedMap;
-    int newIndex = 0;
-    for(const auto& web : web_map_)
-    {
-        WebData updatedWeb = web;
-        updatedWeb.index = newIndex;
-        updatedMap[newIndex] = updatedWeb;
-        newIndex++;
+    else{
+        qInfo() << "Failed to delete links: " << idsToDelete;
     }
-    web_map_ = updatedMap;
 }
 
 bool LinkViewer::anyCheck()
 {
-    for(const auto& web: web_map_.values())
+    for(const auto& web: rows())
         if(web.checked)
             return true;
     return false;
@@ -217,14 +178,13 @@ bool LinkViewer::anyCheck()
 
 void LinkViewer::updateWebsiteName(int index, const QString &webName)
 {
-    if(!web_map_.contains(index))
+    if(index < 0 || index >= rows().size())
         return;
 
-    auto web = web_map_[index];
-    auto query = db_->getBinder("UPDATE links SET website = :web WHERE id = :id");
-    query.bindValue(":web", webName);
-    query.bindValue(":id", web.id);
-    query.exec();
+    // a name typed by the user wins over a title still being fetched
+    const int id = rows().at(index).id;
+    for(auto it = m_pendingTitles.begin(); it != m_pendingTitles.end();)
+        it = it.value() == id ? m_pendingTitles.erase(it) : std::next(it);
 
-    emit layoutChanged();
+    db_->updateRow("links", rows().at(index).id, {"website"}, {webName});
 }
@@ -4,28 +4,50 @@
 #include <QObject>
 #include <QAbstractListModel>
 #include <QCoreApplication>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QRegularExpression>
-#include <QEventLoop>
+#include <QMultiHash>
+#include <QPointer>
 #include "database.h"
+#include "sqllistmodel.h"
+#include "linkmetadataresolver.h"
+#include "linkhealthchecker.h"
 namespace project{
 
-class LinkViewer : public QAbstractListModel
+struct WebData{
+    int id;
+    QString website;
+    QString url;
+    // last health check, status -1 until the link has been checked
+    int status = -1;
+    QString finalUrl;
+    int latencyMs = 0;
+    QString error;
+    // view-only state, not stored in the database
+    bool checked = false;
+};
+
+class LinkViewer : public SqlListModel<WebData>
 {
     Q_OBJECT
 public:
     explicit LinkViewer(DbmPtr dbm, QObject *parent = nullptr);
-    // QAbstractItemModel interface
-    int rowCount(const QModelIndex &parent) const override;
-    QVariant data(const QModelIndex &index, int role) const override;
-    QHash<int, QByteArray> roleNames() const override;
+
+    /**
+     * @brief Resolver naming new links in the background; without one the host name is used
+     */
+    void setMetadataResolver(LinkMetadataResolver* resolver);
+
+    /**
+     * @brief Checker behind checkLinks(); results arrive through the change feed
+     */
+    void setHealthChecker(LinkHealthChecker* checker);
 
     Q_INVOKABLE void checkData(int index, bool value);
     Q_INVOKABLE void addLink(const QString& link);
     Q_INVOKABLE void deleteLinks();
     Q_INVOKABLE bool anyCheck();
     Q_INVOKABLE void updateWebsiteName(int index, const QString& webName);
+    // recheck the stale links of the current project
+    Q_INVOKABLE void checkLinks();
 
 
 signals:
@@ -34,27 +56,31 @@ public slots:
     void projectIdChanged(int);
 
 protected:
-    QString getWebsiteName(const QString &urlString);
+    void refresh() override;
+    std::optional<WebData> fetchRow(int id) override;
+    void mergeRow(WebData& current, const WebData& fetched) const override;
 
 private:
-    struct WebData{
-        int index;
-        int id;
-        bool checked;
-        QString website;
-        QString url;
-    };
-
-    DbmPtr db_;
-    mutable QMap<int, WebData> web_map_;
     int m_projectId;
 
-    QNetworkAccessManager m_manager;
+    QPointer<LinkMetadataResolver> m_resolver;
+    QPointer<LinkHealthChecker> m_checker;
+    // links still showing the host name while their title is fetched
+    QMultiHash<QString, int> m_pendingTitles;
+    // database file those row ids belong to
+    QString m_pendingDatabase;
+
+    void titleResolved(const QString& url, const QString& title);
 
     enum LinkRoles {
         UrlRole = Qt::UserRole + 1,
         WebsiteRole,
-        CheckBoxRole
+        CheckBoxRole,
+        StatusRole,
+        BrokenRole,
+        FinalUrlRole,
+        LatencyRole,
+        ErrorRole
     };
 };
 }
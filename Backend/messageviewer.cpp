@@ -49,31 +49,17 @@ void MessageViewer::setCurrentName(const QString &newCurrentName)
         return;
     m_currentName = newCurrentName;
     //query from database
-    auto sqlCmd = QString(R"(
+    const auto rows = db_->selectRows<MsgData, QString, QString, QString>(R"(
         SELECT title, description, tag_name FROM collaborators AS c
         INNER JOIN tasks AS t ON c.project_id = t.project_id
-        WHERE c.name = '%1' AND c.project_id = %2
+        WHERE c.name = ? AND c.project_id = ?
           AND t.title LIKE  c.tag_name || '%' ;
-    )").arg(newCurrentName)
-        .arg(m_projectID);
-
-    auto results = db_->queryRow(sqlCmd);
+    )", {newCurrentName, m_projectID});
 
     int index = 0;
     task_map_.clear();
-    for(int i = 0; i < results.size(); i += 3)
-    {
-        int j = i + 1;
-        int k = i + 2;
-        MsgData msg;
-        msg.title = results[i];
-        msg.desc = results[j];
-
-        qInfo() << "[MessageViewer]: " << msg.title;
-        msg.tag = results[k];
-        task_map_[index] = msg;
-        ++index;
-    }
+    for(const auto& msg : rows)
+        task_map_[index++] = msg;
 
     emit currentNameChanged();
     emit layoutChanged();
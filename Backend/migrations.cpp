@@ -0,0 +1,233 @@
+#include "migrations.h"
+#include "orderkey.h"
+#include <QDebug>
+
+namespace {
+
+bool execAll(DatabaseManager& db, const QStringList& statements)
+{
+    QSqlQuery query(db.database());
+    for (const auto& sql : statements) {
+        if (!query.exec(sql)) {
+            qWarning() << "[migrations]" << query.lastError().text() << "in" << sql;
+            return false;
+        }
+    }
+    return true;
+}
+
+// External-content FTS5 table over table(columns) plus the triggers keeping it in sync
+QStringList fullTextIndex(const QString& table, const QStringList& columns)
+{
+    const QString fts = table + "_fts";
+    const QString cols = columns.join(", ");
+    QStringList newValues, oldValues;
+    for (const auto& column : columns) {
+        newValues << "new.\"" + column + "\"";
+        oldValues << "old.\"" + column + "\"";
+    }
+    const QString insertNew = QString("INSERT INTO %1 (rowid, %2) VALUES (new.id, %3);")
+                                  .arg(fts, cols, newValues.join(", "));
+    const QString deleteOld = QString("INSERT INTO %1 (%1, rowid, %2) VALUES ('delete', old.id, %3);")
+                                  .arg(fts, cols, oldValues.join(", "));
+
+    return {
+        QString("CREATE VIRTUAL TABLE IF NOT EXISTS %1 USING fts5(%2, content='%3', content_rowid='id', "
+                "tokenize='unicode61 remove_diacritics 2')").arg(fts, cols, table),
+        QString("CREATE TRIGGER IF NOT EXISTS %1_ai AFTER INSERT ON \"%2\" BEGIN %3 END")
+            .arg(fts, table, insertNew),
+        QString("CREATE TRIGGER IF NOT EXISTS %1_ad AFTER DELETE ON \"%2\" BEGIN %3 END")
+            .arg(fts, table, deleteOld),
+        QString("CREATE TRIGGER IF NOT EXISTS %1_au AFTER UPDATE OF %3 ON \"%2\" BEGIN %4 %5 END")
+            .arg(fts, table, cols, deleteOld, insertNew),
+        // index the rows that existed before the migration
+        QString("INSERT INTO %1 (%1) VALUES ('rebuild')").arg(fts)
+    };
+}
+
+// FTS5 is a compile-time option of SQLite, try it on a scratch table
+bool hasFts5(DatabaseManager& db)
+{
+    QSqlQuery query(db.database());
+    if (!query.exec("CREATE VIRTUAL TABLE temp.fts5_probe USING fts5(x)"))
+        return false;
+    query.exec("DROP TABLE temp.fts5_probe");
+    return true;
+}
+
+bool hasColumn(DatabaseManager& db, const QString& table, const QString& column)
+{
+    bool found = false;
+    db.forEachRow<int, QString>(QString("SELECT cid, name FROM pragma_table_info('%1')").arg(table), {},
+                                [&](int, const QString& name) {
+        if (name.compare(column, Qt::CaseInsensitive) == 0)
+            found = true;
+    });
+    return found;
+}
+
+}
+
+namespace migrations {
+
+QList<Migration> research()
+{
+    return {
+        {1, "base schema", [](DatabaseManager& db) {
+             return db.initializeDatabase() && execAll(db, {R"(
+                CREATE TABLE IF NOT EXISTS "collaborators" (
+                    "id" INTEGER PRIMARY KEY AUTOINCREMENT,
+                    "name" TEXT NOT NULL,
+                    "tag_name" TEXT,
+                    "photo" TEXT,
+                    "project_id" INTEGER NOT NULL,
+                    UNIQUE("name", "project_id"),
+                    FOREIGN KEY("project_id") REFERENCES "projects"("id") ON DELETE CASCADE
+                )
+            )"});
+         }},
+        {2, "hot-path indexes", [](DatabaseManager& db) {
+             return execAll(db, {
+                 R"(CREATE INDEX IF NOT EXISTS "idx_tasks_project_timestamp" ON "tasks" ("project_id", "timestamp"))",
+                 R"(CREATE INDEX IF NOT EXISTS "idx_links_project" ON "links" ("project_id"))",
+                 R"(CREATE INDEX IF NOT EXISTS "idx_calendars_project_timestamp" ON "calendars" ("project_id", "timestamp"))",
+                 R"(CREATE INDEX IF NOT EXISTS "idx_calendars_timestamp" ON "calendars" ("timestamp"))",
+                 R"(CREATE INDEX IF NOT EXISTS "idx_collaborators_project" ON "collaborators" ("project_id"))",
+                 R"(CREATE INDEX IF NOT EXISTS "idx_contacts_project" ON "contacts" ("project_id"))",
+                 R"(CREATE INDEX IF NOT EXISTS "idx_references_project" ON "references" ("project_id"))",
+                 R"(CREATE INDEX IF NOT EXISTS "idx_projects_name" ON "projects" ("name"))"
+             });
+         }},
+        {3, "full-text search", [](DatabaseManager& db) {
+             // without FTS5 the index is skipped so later steps still apply;
+             // SearchModel falls back to LIKE when tasks_fts is missing
+             if (!hasFts5(db)) {
+                 qWarning() << "[migrations] SQLite lacks FTS5, full-text index skipped on"
+                            << db.connectionName();
+                 return true;
+             }
+             return execAll(db, fullTextIndex("tasks", {"title", "description"}))
+                    && execAll(db, fullTextIndex("links", {"url", "website"}))
+                    && execAll(db, fullTextIndex("references", {"title", "bibtex"}))
+                    && execAll(db, fullTextIndex("calendars", {"event", "description"}));
+         }},
+        {4, "task sort keys", [](DatabaseManager& db) {
+             if (!hasColumn(db, "tasks", "sort_key")
+                 && !execAll(db, {"ALTER TABLE tasks ADD COLUMN sort_key TEXT"}))
+                 return false;
+
+             // keep the order TaskManger used to derive from the timestamps
+             struct TaskOrder { int id; int projectId; };
+             const auto tasks = db.selectRows<TaskOrder, int, int>(
+                 "SELECT id, project_id FROM tasks ORDER BY project_id, timestamp DESC, id", {});
+             QString key;
+             int projectId = -1;
+             for (const auto& task : tasks) {
+                 key = task.projectId == projectId ? OrderKey::after(key) : OrderKey::after(QString());
+                 projectId = task.projectId;
+                 if (!db.exec("UPDATE tasks SET sort_key = ? WHERE id = ?", {key, task.id}))
+                     return false;
+             }
+             return execAll(db, {
+                 R"(CREATE INDEX IF NOT EXISTS "idx_tasks_project_sort_key" ON "tasks" ("project_id", "sort_key"))"
+             });
+         }},
+        {5, "link health", [](DatabaseManager& db) {
+             return execAll(db, {
+                 R"(CREATE TABLE IF NOT EXISTS "link_health" (
+                    "link_id" INTEGER PRIMARY KEY,
+                    "status" INTEGER NOT NULL,
+                    "final_url" TEXT,
+                    "latency_ms" INTEGER,
+                    "error" TEXT,
+                    "checked_at" INTEGER NOT NULL,
+                    FOREIGN KEY("link_id") REFERENCES "links"("id") ON DELETE CASCADE
+                ))",
+                 // foreign keys are not enforced on every connection, drop results with their link
+                 R"(CREATE TRIGGER IF NOT EXISTS "link_health_ad" AFTER DELETE ON "links" BEGIN
+                    DELETE FROM "link_health" WHERE "link_id" = old."id";
+                END)"
+             });
+         }},
+    };
+}
+
+QList<Migration> config()
+{
+    return {
+        {1, "base schema", [](DatabaseManager& db) {
+             return execAll(db, {
+                 "CREATE TABLE IF NOT EXISTS Workspace (name TEXT, database TEXT, year INTEGER, workspace TEXT, icon TEXT)",
+                 "CREATE TABLE IF NOT EXISTS Contacts ("
+                 "name TEXT NOT NULL,"
+                 "affiliation TEXT,"
+                 "website TEXT,"
+                 "phone TEXT,"
+                 "email TEXT NOT NULL,"
+                 "zoom TEXT,"
+                 "photo TEXT,"
+                 "UNIQUE(name),"
+                 "PRIMARY KEY(name)"
+                 ")",
+                 "CREATE TABLE IF NOT EXISTS Template ("
+                 "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+                 "items TEXT NOT NULL,"
+                 "category_id INTEGER"
+                 ")"
+             });
+         }},
+        {2, "workspace year column", [](DatabaseManager& db) {
+             // older config files were created without Workspace.year
+             if (hasColumn(db, "Workspace", "year"))
+                 return true;
+             return execAll(db, {"ALTER TABLE Workspace ADD COLUMN year INTEGER"});
+         }},
+        {3, "link metadata cache", [](DatabaseManager& db) {
+             return execAll(db, {
+                 "CREATE TABLE IF NOT EXISTS LinkMetadata ("
+                 "url TEXT PRIMARY KEY,"
+                 "title TEXT NOT NULL,"
+                 "fetched_at INTEGER NOT NULL"
+                 ")"
+             });
+         }},
+        {4, "download checksums", [](DatabaseManager& db) {
+             return execAll(db, {
+                 "CREATE TABLE IF NOT EXISTS Downloads ("
+                 "path TEXT PRIMARY KEY,"
+                 "url TEXT NOT NULL,"
+                 "size INTEGER NOT NULL,"
+                 "sha256 TEXT NOT NULL,"
+                 "completed_at INTEGER NOT NULL"
+                 ")",
+                 "CREATE INDEX IF NOT EXISTS idx_downloads_sha256 ON Downloads (sha256)"
+             });
+         }},
+        {5, "ai response cache", [](DatabaseManager& db) {
+             return execAll(db, {
+                 "CREATE TABLE IF NOT EXISTS AiResponses ("
+                 "key TEXT PRIMARY KEY,"
+                 "model TEXT NOT NULL,"
+                 "response TEXT NOT NULL,"
+                 "bytes INTEGER NOT NULL,"
+                 "created_at INTEGER NOT NULL,"
+                 "last_used INTEGER NOT NULL"
+                 ")",
+                 "CREATE INDEX IF NOT EXISTS idx_airesponses_last_used ON AiResponses (last_used)"
+             });
+         }},
+    };
+}
+
+bool upgradeResearchDatabase(const QString& db_path)
+{
+    bool ok = false;
+    {
+        DatabaseManager dbm("researchMigration", db_path);
+        ok = dbm.database().isOpen() && dbm.migrate(research());
+    }
+    QSqlDatabase::removeDatabase("researchMigration");
+    return ok;
+}
+
+}
@@ -0,0 +1,31 @@
+#ifndef MIGRATIONS_H
+#define MIGRATIONS_H
+
+#include "database.h"
+
+/**
+ * @brief Ordered schema migrations for the two kinds of database.
+ *
+ * Append new steps with the next version number; never edit a step that has
+ * already shipped, existing databases will not run it again.
+ */
+namespace migrations {
+
+/**
+ * @brief Migrations for a workspace research database (research.db)
+ */
+QList<Migration> research();
+
+/**
+ * @brief Migrations for the shared config database (common_config.db)
+ */
+QList<Migration> config();
+
+/**
+ * @brief Open db_path with a temporary connection and apply research()
+ */
+bool upgradeResearchDatabase(const QString& db_path);
+
+}
+
+#endif // MIGRATIONS_H
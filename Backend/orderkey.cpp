@@ -0,0 +1,185 @@
+#include "orderkey.h"
+#include <QByteArray>
+#include <QDebug>
+
+namespace {
+
+const QByteArray Digits = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+const int Base = 62;
+// "A" followed by 26 zeros: the one integer nothing can be placed before
+const QByteArray SmallestInteger = "A" + QByteArray(26, '0');
+
+int digitIndex(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'z') return c - 'a' + 36;
+    return -1;
+}
+
+// head 'a'..'z' covers positive integers of 1..26 digits, 'Z'..'A' negative ones
+int integerLength(char head)
+{
+    if (head >= 'a' && head <= 'z') return head - 'a' + 2;
+    if (head >= 'A' && head <= 'Z') return 'Z' - head + 2;
+    return -1;
+}
+
+bool validKey(const QByteArray& key)
+{
+    if (key.isEmpty() || key == SmallestInteger)
+        return false;
+    const int length = integerLength(key[0]);
+    if (length < 0 || length > key.size())
+        return false;
+    for (int i = 1; i < key.size(); ++i)
+        if (digitIndex(key[i]) < 0)
+            return false;
+    // a trailing zero in the fraction would leave no room below the key
+    return key.size() == length || key.back() != '0';
+}
+
+// Fraction strictly between a and b (b unbounded when !bounded); neither ends in '0'
+QByteArray midpoint(const QByteArray& a, const QByteArray& b, bool bounded)
+{
+    if (bounded) {
+        int n = 0;
+        while (n < b.size() && (n < a.size() ? a[n] : '0') == b[n])
+            ++n;
+        if (n > 0)
+            return b.left(n) + midpoint(a.mid(n), b.mid(n), true);
+    }
+
+    const int digitA = a.isEmpty() ? 0 : digitIndex(a[0]);
+    const int digitB = bounded ? digitIndex(b[0]) : Base;
+    if (digitB - digitA > 1)
+        return QByteArray(1, Digits[(digitA + digitB + 1) / 2]);
+    if (bounded && b.size() > 1)
+        return b.left(1);
+    return QByteArray(1, Digits[digitA]) + midpoint(a.mid(1), QByteArray(), false);
+}
+
+// Next integer part, or empty when x is already the largest one
+QByteArray incrementInteger(const QByteArray& x)
+{
+    char head = x[0];
+    QByteArray digits = x.mid(1);
+    bool carry = true;
+    for (int i = digits.size() - 1; carry && i >= 0; --i) {
+        const int d = digitIndex(digits[i]) + 1;
+        if (d == Base) {
+            digits[i] = Digits[0];
+        } else {
+            digits[i] = Digits[d];
+            carry = false;
+        }
+    }
+    if (!carry)
+        return head + digits;
+
+    if (head == 'Z')
+        return QByteArray("a") + Digits[0];
+    if (head == 'z')
+        return QByteArray();
+    ++head;
+    if (head > 'a')
+        digits.append(Digits[0]);
+    else
+        digits.chop(1);
+    return head + digits;
+}
+
+// Previous integer part, or empty when x is already the smallest one
+QByteArray decrementInteger(const QByteArray& x)
+{
+    char head = x[0];
+    QByteArray digits = x.mid(1);
+    bool borrow = true;
+    for (int i = digits.size() - 1; borrow && i >= 0; --i) {
+        const int d = digitIndex(digits[i]) - 1;
+        if (d < 0) {
+            digits[i] = Digits[Base - 1];
+        } else {
+            digits[i] = Digits[d];
+            borrow = false;
+        }
+    }
+    if (!borrow)
+        return head + digits;
+
+    if (head == 'a')
+        return QByteArray("Z") + Digits[Base - 1];
+    if (head == 'A')
+        return QByteArray();
+    --head;
+    if (head < 'Z')
+        digits.append(Digits[Base - 1]);
+    else
+        digits.chop(1);
+    return head + digits;
+}
+
+}
+
+bool OrderKey::isValid(const QString &key)
+{
+    return validKey(key.toLatin1());
+}
+
+QString OrderKey::between(const QString &lower, const QString &upper)
+{
+    const QByteArray a = lower.toLatin1();
+    const QByteArray b = upper.toLatin1();
+
+    if ((!a.isEmpty() && !validKey(a)) || (!b.isEmpty() && !validKey(b))) {
+        qWarning() << "[OrderKey] invalid key" << lower << upper;
+        return QString();
+    }
+    if (!a.isEmpty() && !b.isEmpty() && a >= b) {
+        qWarning() << "[OrderKey] keys out of order" << lower << upper;
+        return QString();
+    }
+
+    if (a.isEmpty() && b.isEmpty())
+        return QStringLiteral("a0");
+
+    if (a.isEmpty()) {
+        const QByteArray ib = b.left(integerLength(b[0]));
+        const QByteArray fb = b.mid(ib.size());
+        if (ib == SmallestInteger)
+            return QString::fromLatin1(ib + midpoint(QByteArray(), fb, true));
+        if (ib < b)
+            return QString::fromLatin1(ib);
+        return QString::fromLatin1(decrementInteger(ib));
+    }
+
+    const QByteArray ia = a.left(integerLength(a[0]));
+    const QByteArray fa = a.mid(ia.size());
+
+    if (b.isEmpty()) {
+        const QByteArray next = incrementInteger(ia);
+        return QString::fromLatin1(next.isEmpty() ? ia + midpoint(fa, QByteArray(), false) : next);
+    }
+
+    const QByteArray ib = b.left(integerLength(b[0]));
+    const QByteArray fb = b.mid(ib.size());
+    if (ia == ib)
+        return QString::fromLatin1(ia + midpoint(fa, fb, true));
+
+    const QByteArray next = incrementInteger(ia);
+    if (!next.isEmpty() && next < b)
+        return QString::fromLatin1(next);
+    return QString::fromLatin1(ia + midpoint(fa, QByteArray(), false));
+}
+
+QStringList OrderKey::sequence(int count)
+{
+    QStringList keys;
+    keys.reserve(count);
+    QString key;
+    for (int i = 0; i < count; ++i) {
+        key = after(key);
+        keys << key;
+    }
+    return keys;
+}
@@ -0,0 +1,42 @@
+#ifndef ORDERKEY_H
+#define ORDERKEY_H
+
+#include <QString>
+#include <QStringList>
+
+/**
+ * @class OrderKey
+ * @brief Lexicographic fractional keys for user-ordered rows.
+ *
+ * A key sorts by plain byte comparison (SQLite's default BINARY collation), so
+ * "ORDER BY sort_key" gives the display order. A new key can always be made
+ * between two neighbours, which turns any move into a single-row update.
+ *
+ * Keys are base-62 ("0-9A-Za-z"): a head character encoding the length of an
+ * integer part, the integer digits, then an optional fraction that never ends
+ * in '0'. Appending or prepending only bumps the integer part, so keys stay
+ * short when rows are always added at one end.
+ *
+ * An empty QString stands for "no neighbour" on that side; an empty result
+ * means the input keys were invalid or not in order.
+ */
+class OrderKey
+{
+public:
+    /**
+     * @brief Key sorting strictly between lower and upper
+     */
+    static QString between(const QString& lower, const QString& upper);
+
+    static QString before(const QString& upper) { return between(QString(), upper); }
+    static QString after(const QString& lower) { return between(lower, QString()); }
+
+    /**
+     * @brief count ascending keys for a freshly ordered list
+     */
+    static QStringList sequence(int count);
+
+    static bool isValid(const QString& key);
+};
+
+#endif // ORDERKEY_H
@@ -0,0 +1,476 @@
+#include "pdfrenamejob.h"
+#include "geminiapi.h"
+#include "airesponsecache.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QFuture>
+#include <QPromise>
+#include <QRegularExpression>
+#include <QDebug>
+#include <memory>
+#include <algorithm>
+
+#ifdef HAS_QT_PDF
+#include <QPdfDocument>
+#include <QPdfSelection>
+#endif
+
+using namespace project;
+
+PdfRenameJob::PdfRenameJob(AiRequestScheduler *scheduler, QObject *parent)
+    : QAbstractListModel{parent}, m_scheduler(scheduler)
+    , m_endpoint(gemini::defaultEndpoint()), m_model(gemini::defaultModel())
+{
+    if (!m_scheduler)
+        m_scheduler = new AiRequestScheduler(nullptr, this);
+}
+
+PdfRenameJob::~PdfRenameJob()
+{
+    // the scheduler is shared, make sure none of its callbacks reaches a deleted job
+    for (const auto& item : m_items) {
+        if (item.request && m_scheduler)
+            m_scheduler->cancel(item.request);
+    }
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+int PdfRenameJob::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(m_items.size());
+}
+
+QVariant PdfRenameJob::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_items.size())
+        return QVariant();
+
+    const Item& item = m_items.at(index.row());
+    switch (role) {
+    case PathRole: return item.path;
+    case FileNameRole: return QFileInfo(item.path).fileName();
+    case NewPathRole: return item.newPath;
+    case NewNameRole: return item.newPath.isEmpty() ? QString() : QFileInfo(item.newPath).fileName();
+    case StatusRole: return int(item.status);
+    case StatusTextRole: return statusText(item.status);
+    case ErrorRole: return item.error;
+    case AttemptsRole: return item.attempts;
+    case CachedRole: return item.cached;
+    }
+    return QVariant();
+}
+
+QHash<int, QByteArray> PdfRenameJob::roleNames() const
+{
+    return {
+        {PathRole, "path"},
+        {FileNameRole, "fileName"},
+        {NewPathRole, "newPath"},
+        {NewNameRole, "newName"},
+        {StatusRole, "status"},
+        {StatusTextRole, "statusText"},
+        {ErrorRole, "error"},
+        {AttemptsRole, "attempts"},
+        {CachedRole, "cached"},
+    };
+}
+
+bool PdfRenameJob::isRunning() const
+{
+    return m_running;
+}
+
+int PdfRenameJob::pendingCount() const
+{
+    return int(std::count_if(m_items.begin(), m_items.end(), [](const Item& item) {
+        return item.status != Renamed && item.status != Failed;
+    }));
+}
+
+int PdfRenameJob::renamedCount() const
+{
+    return int(std::count_if(m_items.begin(), m_items.end(), [](const Item& item) {
+        return item.status == Renamed;
+    }));
+}
+
+int PdfRenameJob::failedCount() const
+{
+    return int(std::count_if(m_items.begin(), m_items.end(), [](const Item& item) {
+        return item.status == Failed;
+    }));
+}
+
+void PdfRenameJob::setApiKey(const QString &key)
+{
+    m_apiKey = key;
+}
+
+void PdfRenameJob::setPrompt(const QString &prompt)
+{
+    m_prompt = prompt;
+}
+
+void PdfRenameJob::setEndpoint(const QUrl &endpoint)
+{
+    m_endpoint = endpoint;
+}
+
+void PdfRenameJob::setModel(const QString &model)
+{
+    m_model = model;
+}
+
+int PdfRenameJob::maxConcurrent() const
+{
+    return m_maxConcurrent;
+}
+
+void PdfRenameJob::setMaxConcurrent(int count)
+{
+    m_maxConcurrent = qMax(1, count);
+    dispatch();
+}
+
+AiRequestScheduler *PdfRenameJob::scheduler() const
+{
+    return m_scheduler;
+}
+
+void PdfRenameJob::setCache(AiResponseCache *cache)
+{
+    m_cache = cache;
+}
+
+void PdfRenameJob::setTextExtractor(TextExtractor extractor)
+{
+    m_extractor = std::move(extractor);
+}
+
+int PdfRenameJob::addFiles(const QStringList &paths)
+{
+    QStringList accepted;
+    for (const QString& path : paths) {
+        const QFileInfo info(path);
+        if (!info.isFile() || info.suffix().toLower() != "pdf") {
+            qWarning() << "[PdfRenameJob] skipping" << path << "- not a PDF file";
+            continue;
+        }
+        const QString absolute = info.absoluteFilePath();
+        const bool queued = std::any_of(m_items.begin(), m_items.end(), [&absolute](const Item& item) {
+            return item.path == absolute && item.status != Renamed && item.status != Failed;
+        });
+        if (!queued && !accepted.contains(absolute))
+            accepted << absolute;
+    }
+    if (accepted.isEmpty())
+        return 0;
+
+    const int first = int(m_items.size());
+    beginInsertRows(QModelIndex(), first, first + int(accepted.size()) - 1);
+    for (const QString& path : accepted) {
+        Item item;
+        item.id = m_nextId++;
+        item.path = path;
+        m_items.append(item);
+    }
+    endInsertRows();
+
+    qInfo() << "[PdfRenameJob] queued" << accepted.size() << "files";
+    emit progressChanged();
+    updateRunning();
+    for (int row = first; row < m_items.size(); ++row)
+        extract(m_items.at(row).id);
+    return int(accepted.size());
+}
+
+int PdfRenameJob::addFolder(const QString &folder)
+{
+    QStringList paths;
+    const QDir dir(folder);
+    for (const QFileInfo& info : dir.entryInfoList({"*.pdf"}, QDir::Files, QDir::Name))
+        paths << info.absoluteFilePath();
+    return addFiles(paths);
+}
+
+void PdfRenameJob::cancel()
+{
+    m_pool.clear();
+    m_waiting.clear();
+    for (int row = 0; row < m_items.size(); ++row) {
+        Item& item = m_items[row];
+        if (item.status == Renamed || item.status == Failed)
+            continue;
+        if (item.request) {
+            m_scheduler->cancel(item.request);
+            item.request = 0;
+            --m_inFlight;
+        }
+        item.status = Failed;
+        item.error = QStringLiteral("cancelled");
+        emit dataChanged(index(row), index(row));
+    }
+    emit progressChanged();
+    updateRunning();
+}
+
+void PdfRenameJob::clearFinished()
+{
+    for (int row = int(m_items.size()) - 1; row >= 0; --row) {
+        const Status status = m_items.at(row).status;
+        if (status != Renamed && status != Failed)
+            continue;
+        beginRemoveRows(QModelIndex(), row, row);
+        m_items.removeAt(row);
+        endRemoveRows();
+    }
+    emit progressChanged();
+}
+
+QString PdfRenameJob::extractFirstPage(const QString &path)
+{
+    QString firstPageText;
+#ifdef HAS_QT_PDF
+    QPdfDocument pdfDoc;
+    QPdfDocument::Error loadError = pdfDoc.load(path);
+
+    if (loadError == QPdfDocument::Error::None && pdfDoc.pageCount() > 0) {
+        firstPageText = pdfDoc.getAllText(0).text();
+
+        // Truncate if too long (to avoid API limits)
+        if (firstPageText.length() > 4000) {
+            firstPageText = firstPageText.left(4000) + "...";
+        }
+    } else {
+        qWarning() << "[PdfRenameJob] Failed to load PDF or no pages found. Error:" << static_cast<int>(loadError);
+    }
+#else
+    Q_UNUSED(path);
+    qWarning() << "[PdfRenameJob] PDF text extraction not available - Qt6::Pdf module not installed";
+#endif
+    return firstPageText;
+}
+
+QString PdfRenameJob::targetPath(const QString &oldPath, const QString &suggestion)
+{
+    // Clean up the suggested name - remove any quotes, newlines, extra text
+    QString suggestedName = suggestion.trimmed().split('\n').first().trimmed();
+    suggestedName.remove(QRegularExpression("^[\"']|[\"']$"));
+
+    // Sanitize filename - remove invalid characters
+    suggestedName.remove(QRegularExpression("[<>:\"/\\\\|?*]"));
+    suggestedName = suggestedName.trimmed();
+
+    if (suggestedName.toLower().endsWith(".pdf"))
+        suggestedName.chop(4);
+    if (suggestedName.isEmpty())
+        return QString();
+
+    const QFileInfo oldFileInfo(oldPath);
+    const QString folder = oldFileInfo.absolutePath() + "/";
+    QString newPath = folder + suggestedName + ".pdf";
+
+    // Add a number suffix to make it unique
+    int counter = 1;
+    while (QFile::exists(newPath) && newPath != oldFileInfo.absoluteFilePath()) {
+        newPath = folder + suggestedName + "_" + QString::number(counter) + ".pdf";
+        counter++;
+    }
+    return newPath;
+}
+
+int PdfRenameJob::indexOf(int id) const
+{
+    for (int row = 0; row < m_items.size(); ++row) {
+        if (m_items.at(row).id == id)
+            return row;
+    }
+    return -1;
+}
+
+void PdfRenameJob::setStatus(int id, Status status, const QString &error)
+{
+    const int row = indexOf(id);
+    if (row < 0)
+        return;
+    m_items[row].status = status;
+    m_items[row].error = error;
+    emit dataChanged(index(row), index(row));
+    emit progressChanged();
+}
+
+void PdfRenameJob::extract(int id)
+{
+    const QString path = m_items.at(indexOf(id)).path;
+    const TextExtractor extractor = m_extractor ? m_extractor : TextExtractor(&PdfRenameJob::extractFirstPage);
+
+    // the page is parsed on the pool, the result comes back on this thread
+    auto promise = std::make_shared<QPromise<QString>>();
+    QFuture<QString> future = promise->future();
+    promise->start();
+    m_pool.start([promise, extractor, path]() {
+        promise->addResult(extractor(path));
+        promise->finish();
+    });
+
+    future.then(this, [this, id](QString text) {
+        const int row = indexOf(id);
+        // cancelled while the page was extracted
+        if (row < 0 || m_items.at(row).status != Queued)
+            return;
+        m_items[row].text = text;
+
+        // same text and prompt as an earlier request, reuse its answer; without text
+        // every unreadable file would share one key
+        const QString cached = m_cache && !text.isEmpty() ? m_cache->lookup(cacheKey(m_items.at(row))) : QString();
+        if (!cached.isEmpty()) {
+            m_items[row].cached = true;
+            rename(id, cached);
+            updateRunning();
+            return;
+        }
+
+        setStatus(id, Waiting);
+        m_waiting.append(id);
+        dispatch();
+    });
+}
+
+void PdfRenameJob::dispatch()
+{
+    while (m_inFlight < m_maxConcurrent && !m_waiting.isEmpty())
+        send(m_waiting.takeFirst());
+    updateRunning();
+}
+
+void PdfRenameJob::send(int id)
+{
+    const int row = indexOf(id);
+    if (row < 0)
+        return;
+    if (m_apiKey.isEmpty()) {
+        fail(id, QStringLiteral("API key is not set. Please configure your Gemini API key."));
+        return;
+    }
+
+    Item& item = m_items[row];
+    ++m_inFlight;
+    item.request = m_scheduler->submit(gemini::generateContentRequest(m_endpoint, m_model, m_apiKey),
+                                       gemini::generateContentBody(buildPrompt(item)),
+                                       AiRequestScheduler::Batch,
+                                       [this, id](const AiRequestScheduler::Response& response) {
+                                           onFinished(id, response);
+                                       });
+    setStatus(id, Requesting);
+}
+
+void PdfRenameJob::onFinished(int id, const AiRequestScheduler::Response &response)
+{
+    --m_inFlight;
+    const int row = indexOf(id);
+    if (row < 0) {
+        dispatch();
+        return;
+    }
+    m_items[row].request = 0;
+    m_items[row].attempts += response.attempts;
+
+    QString error;
+    if (!response.ok()) {
+        // the API explains rejected requests in the body
+        gemini::responseText(response.body, &error);
+        if (!error.startsWith("API Error"))
+            error = QString("Network Error: %1").arg(response.errorString);
+        qWarning() << "[PdfRenameJob]" << m_items.at(row).path << error;
+        fail(id, error);
+    } else {
+        const QString suggestion = gemini::responseText(response.body, &error);
+        if (suggestion.trimmed().isEmpty()) {
+            fail(id, error.isEmpty() ? QStringLiteral("AI returned empty filename suggestion") : error);
+        } else {
+            // kept even if the rename below fails, a retry then needs no request
+            if (m_cache && !m_items.at(row).text.isEmpty())
+                m_cache->store(cacheKey(m_items.at(row)), m_model, suggestion);
+            rename(id, suggestion);
+        }
+    }
+    dispatch();
+}
+
+void PdfRenameJob::rename(int id, const QString &suggestion)
+{
+    const int row = indexOf(id);
+    const QString oldPath = m_items.at(row).path;
+    const QString newPath = targetPath(oldPath, suggestion);
+    if (newPath.isEmpty()) {
+        fail(id, QStringLiteral("AI returned empty filename suggestion"));
+        return;
+    }
+
+    QFile file(oldPath);
+    if (newPath != oldPath && !file.rename(newPath)) {
+        qWarning() << "[PdfRenameJob] Failed to rename file:" << file.errorString();
+        fail(id, "Failed to rename file: " + file.errorString());
+        return;
+    }
+
+    qInfo() << "[PdfRenameJob] Renamed PDF:" << oldPath << "to" << newPath;
+    m_items[row].newPath = newPath;
+    m_items[row].text.clear();
+    setStatus(id, Renamed);
+    emit fileRenamed(oldPath, newPath);
+}
+
+void PdfRenameJob::fail(int id, const QString &error)
+{
+    const int row = indexOf(id);
+    if (row < 0)
+        return;
+    m_items[row].text.clear();
+    setStatus(id, Failed, error);
+    emit fileFailed(m_items.at(row).path, error);
+}
+
+void PdfRenameJob::updateRunning()
+{
+    const bool running = pendingCount() > 0;
+    if (running == m_running)
+        return;
+    m_running = running;
+    emit runningChanged();
+    if (!running) {
+        qInfo() << "[PdfRenameJob] batch done," << renamedCount() << "renamed," << failedCount() << "failed";
+        emit finished(renamedCount(), failedCount());
+    }
+}
+
+QString PdfRenameJob::buildPrompt(const Item &item) const
+{
+    return m_prompt +
+           "\n\n--- PDF FIRST PAGE CONTENT ---\n" +
+           (item.text.isEmpty() ? QStringLiteral("(Could not extract text from PDF)") : item.text) +
+           "\n--- END OF CONTENT ---\n\n"
+           "Current filename: " + QFileInfo(item.path).fileName() +
+           "\n\nBased on the content above, please respond with ONLY the new filename "
+           "(without path, with .pdf extension). "
+           "Do not include any explanation or additional text.";
+}
+
+QString PdfRenameJob::cacheKey(const Item &item) const
+{
+    return AiResponseCache::key(m_model, m_prompt, item.text);
+}
+
+QString PdfRenameJob::statusText(Status status)
+{
+    switch (status) {
+    case Queued: return QStringLiteral("Reading");
+    case Waiting: return QStringLiteral("Waiting");
+    case Requesting: return QStringLiteral("Asking AI");
+    case Renamed: return QStringLiteral("Renamed");
+    case Failed: return QStringLiteral("Failed");
+    }
+    return QString();
+}
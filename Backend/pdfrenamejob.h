@@ -0,0 +1,191 @@
+#ifndef PDFRENAMEJOB_H
+#define PDFRENAMEJOB_H
+
+#include <QObject>
+#include <QAbstractListModel>
+#include <QThreadPool>
+#include <QPointer>
+#include <QStringList>
+#include <QUrl>
+#include <QList>
+#include <functional>
+#include "airequestscheduler.h"
+
+namespace project {
+class AiResponseCache;
+
+/**
+ * @class PdfRenameJob
+ * @brief Renames a batch of PDFs after the title Gemini reads from their first page.
+ *
+ * Files are added one by one, as a list or as a whole folder and each becomes
+ * a row of the model. The first page text is extracted on a worker pool, so
+ * a folder of papers does not freeze the UI; at most maxConcurrent() requests
+ * are then handed to the AiRequestScheduler at a time, in its Batch lane. The
+ * scheduler applies the rate limit and retries 429 and 5xx answers.
+ *
+ * The suggested name is cleaned up and made unique in the folder of the file
+ * before it is renamed; the outcome per file is kept in the model and reported
+ * through fileRenamed() and fileFailed(). With a response cache, files whose
+ * text was sent before with the same prompt are renamed without a request.
+ */
+class PdfRenameJob : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged FINAL)
+    Q_PROPERTY(int pendingCount READ pendingCount NOTIFY progressChanged FINAL)
+    Q_PROPERTY(int renamedCount READ renamedCount NOTIFY progressChanged FINAL)
+    Q_PROPERTY(int failedCount READ failedCount NOTIFY progressChanged FINAL)
+
+public:
+    enum Status {
+        // first page text is being extracted
+        Queued,
+        // waiting for a request slot
+        Waiting,
+        Requesting,
+        Renamed,
+        Failed
+    };
+    Q_ENUM(Status)
+
+    enum Roles {
+        PathRole = Qt::UserRole + 1,
+        FileNameRole,
+        NewPathRole,
+        NewNameRole,
+        StatusRole,
+        StatusTextRole,
+        ErrorRole,
+        AttemptsRole,
+        CachedRole
+    };
+
+    // returns the text sent to Gemini for the file at path
+    using TextExtractor = std::function<QString(const QString&)>;
+
+    /**
+     * @param scheduler shared request scheduler, the job creates its own without one
+     */
+    explicit PdfRenameJob(AiRequestScheduler *scheduler = nullptr, QObject *parent = nullptr);
+    ~PdfRenameJob();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    bool isRunning() const;
+    int pendingCount() const;
+    int renamedCount() const;
+    int failedCount() const;
+
+    void setApiKey(const QString& key);
+    void setPrompt(const QString& prompt);
+    void setEndpoint(const QUrl& endpoint);
+    void setModel(const QString& model);
+
+    int maxConcurrent() const;
+    void setMaxConcurrent(int count);
+
+    AiRequestScheduler* scheduler() const;
+
+    /**
+     * @brief Answers are looked up in and stored to cache, owned by the caller
+     */
+    void setCache(AiResponseCache* cache);
+
+    /**
+     * @brief Replace the first page extraction, called on a worker thread;
+     *        it returns empty text when nothing could be extracted
+     */
+    void setTextExtractor(TextExtractor extractor);
+
+    /**
+     * @brief Queue PDF files for renaming, files already in the batch are skipped
+     * @return number of files queued
+     */
+    Q_INVOKABLE int addFiles(const QStringList& paths);
+
+    /**
+     * @brief Queue every PDF directly inside folder
+     */
+    Q_INVOKABLE int addFolder(const QString& folder);
+
+    /**
+     * @brief Stop the batch, unfinished files are marked failed
+     */
+    Q_INVOKABLE void cancel();
+
+    /**
+     * @brief Drop the rows of finished files
+     */
+    Q_INVOKABLE void clearFinished();
+
+    /**
+     * @brief First page text of a PDF, truncated to 4000 characters;
+     *        empty when the file cannot be read or Qt PDF is not available
+     */
+    static QString extractFirstPage(const QString& path);
+
+    /**
+     * @brief Free path next to oldPath for the name suggested by Gemini
+     * @return empty when the suggestion contains no usable name
+     */
+    static QString targetPath(const QString& oldPath, const QString& suggestion);
+
+signals:
+    void runningChanged();
+    void progressChanged();
+    void fileRenamed(const QString& oldPath, const QString& newPath);
+    void fileFailed(const QString& path, const QString& error);
+    void finished(int renamed, int failed);
+
+private:
+    struct Item {
+        int id;
+        QString path;
+        QString newPath;
+        Status status = Queued;
+        QString error;
+        int attempts = 0;
+        bool cached = false;
+        QString text;
+        // scheduler request in flight, 0 for none
+        int request = 0;
+    };
+
+    // shared with AiConfig, which may delete it first
+    QPointer<AiRequestScheduler> m_scheduler;
+    QThreadPool m_pool;
+    TextExtractor m_extractor;
+    AiResponseCache* m_cache = nullptr;
+    QList<Item> m_items;
+    // ids of extracted files waiting for a request slot
+    QList<int> m_waiting;
+    int m_nextId = 1;
+    int m_inFlight = 0;
+    bool m_running = false;
+
+    QString m_apiKey;
+    QString m_prompt;
+    QUrl m_endpoint;
+    QString m_model;
+    int m_maxConcurrent = 3;
+
+    int indexOf(int id) const;
+    void setStatus(int id, Status status, const QString& error = QString());
+    void extract(int id);
+    void dispatch();
+    void send(int id);
+    void onFinished(int id, const AiRequestScheduler::Response& response);
+    void rename(int id, const QString& suggestion);
+    void fail(int id, const QString& error);
+    void updateRunning();
+    QString buildPrompt(const Item& item) const;
+    QString cacheKey(const Item& item) const;
+    static QString statusText(Status status);
+};
+
+} // namespace project
+
+#endif // PDFRENAMEJOB_H
@@ -1,4 +1,5 @@
 #include "projectpage.h"
+#include "migrations.h"
 using namespace project;
 
 ProjectPage::ProjectPage(DbmPtr db, QObject *parent)
@@ -18,19 +19,14 @@ void ProjectPage::setProjectName(const QString &newProjectName)
         return;
     m_projectName = newProjectName;
     emit projectNameChanged();
-    QString sqlCmd = QString("SELECT id FROM projects WHERE name = '%1'").arg(m_projectName);
-    qInfo() << sqlCmd;
-    for(const auto& result: db_->queryRow(sqlCmd))
+    int id_ = db_->selectValue<int>("SELECT id FROM projects WHERE name = ?", {m_projectName}, -1);
+    if(id_ >= 0)
     {
-        int id_ = result.toInt();
         emit projectIdChanged(id_);
         qInfo() << "project id = " << id_;
-
     }
 
-    sqlCmd = QString("SELECT description FROM projects WHERE name = '%1'").arg(m_projectName);
-
-    QString description = db_->queryRow(sqlCmd).front();
+    QString description = db_->selectValue<QString>("SELECT description FROM projects WHERE name = ?", {m_projectName});
     if(description.isEmpty())
         setProjectDescription(newProjectName);
     else
@@ -119,19 +115,14 @@ void ProjectPage::setProjectInfo(const QStringList& pInfo)
     //                 .arg(cat);
     // db_->updateDB(sqlCmd);
 
-    if(db_->initializeDatabase())
+    if(!db_->migrate(migrations::research()))
     {
-        qInfo() << "[ProjectPage] initializing the database for this workspace";
+        qWarning() << "[ProjectPage] Failed to migrate the database for this workspace";
     }
 
-    auto query = db_->getBinder("INSERT INTO projects (name, description, category_id) VALUES (:name, :desc, :cat)");
-    query.bindValue(":name", projectName);
-    query.bindValue(":desc", projectName);
-    query.bindValue(":cat", cat);
-
-    if (! query.exec()) {
-        qWarning() << "[ProjectPage] Error: Failed to execute query:" << query.lastError().text();
-
+    // the home page picks the new project up through the change feed
+    if (db_->insertRow("projects", {"name", "description", "category_id"}, {projectName, projectName, cat}) < 0) {
+        qWarning() << "[ProjectPage] Error: Failed to insert project" << projectName;
     }
 
 }
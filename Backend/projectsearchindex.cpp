@@ -0,0 +1,326 @@
+#include "projectsearchindex.h"
+#include <QSet>
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+bool keyLess(const QString& a, const QString& b)
+{
+    return QStringView(a).compare(QStringView(b)) < 0;
+}
+
+int maxDistanceFor(int length)
+{
+    if (length <= 4)
+        return 1;
+    return length <= 8 ? 2 : 3;
+}
+
+void eraseSorted(std::vector<int>& list, int value)
+{
+    auto it = std::lower_bound(list.begin(), list.end(), value);
+    if (it != list.end() && *it == value)
+        list.erase(it);
+}
+
+}
+
+QList<int> ProjectSearchIndex::wordStarts(const QString& lower)
+{
+    QList<int> starts;
+    for (int i = 0; i < lower.size(); ++i) {
+        const bool word = lower.at(i).isLetterOrNumber();
+        if (word && (i == 0 || !lower.at(i - 1).isLetterOrNumber()))
+            starts << i;
+    }
+    if (starts.isEmpty() || starts.first() != 0)
+        starts.prepend(0);
+    return starts;
+}
+
+QList<quint64> ProjectSearchIndex::trigrams(const QString& lower)
+{
+    QList<quint64> grams;
+    for (int i = 0; i + 2 < lower.size(); ++i) {
+        grams << ((quint64(lower.at(i).unicode()) << 32)
+                  | (quint64(lower.at(i + 1).unicode()) << 16)
+                  | quint64(lower.at(i + 2).unicode()));
+    }
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+void ProjectSearchIndex::insert(int id, const QString& name)
+{
+    remove(id);
+
+    const int slot = int(entries_.size());
+    entries_.push_back({id, name, name.toLower(), true});
+    slotOf_.insert(id, slot);
+    index(slot);
+}
+
+void ProjectSearchIndex::rebuild(const QList<std::pair<int, QString>>& projects)
+{
+    clear();
+    entries_.reserve(projects.size());
+    for (const auto& [id, name] : projects) {
+        auto found = slotOf_.find(id);
+        if (found != slotOf_.end())
+            entries_[found.value()].alive = false;
+        slotOf_.insert(id, int(entries_.size()));
+        entries_.push_back({id, name, name.toLower(), true});
+    }
+
+    for (int slot = 0; slot < int(entries_.size()); ++slot)
+        if (entries_[slot].alive)
+            index(slot, false);
+    sortKeys();
+}
+
+void ProjectSearchIndex::index(int slot, bool keepSorted)
+{
+    const Entry& entry = entries_[slot];
+    ++exactCount_[entry.lower];
+
+    for (int start : wordStarts(entry.lower)) {
+        Key key{entry.lower.mid(start), slot, start};
+        if (!keepSorted) {
+            // bulk load: the caller sorts once at the end
+            keys_.push_back(std::move(key));
+            continue;
+        }
+        auto it = std::lower_bound(keys_.begin(), keys_.end(), key.text,
+                                   [](const Key& k, const QString& text) { return keyLess(k.text, text); });
+        keys_.insert(it, std::move(key));
+    }
+
+    // slots only grow, so appending keeps every posting list sorted
+    for (quint64 gram : trigrams(entry.lower))
+        postings_[gram].push_back(slot);
+}
+
+void ProjectSearchIndex::sortKeys()
+{
+    std::sort(keys_.begin(), keys_.end(), [](const Key& a, const Key& b) { return keyLess(a.text, b.text); });
+}
+
+void ProjectSearchIndex::remove(int id)
+{
+    auto found = slotOf_.find(id);
+    if (found == slotOf_.end())
+        return;
+    const int slot = found.value();
+    slotOf_.erase(found);
+
+    Entry& entry = entries_[slot];
+    entry.alive = false;
+    if (--exactCount_[entry.lower] <= 0)
+        exactCount_.remove(entry.lower);
+
+    keys_.erase(std::remove_if(keys_.begin(), keys_.end(), [slot](const Key& k) { return k.slot == slot; }),
+                keys_.end());
+    for (quint64 gram : trigrams(entry.lower)) {
+        auto it = postings_.find(gram);
+        if (it == postings_.end())
+            continue;
+        eraseSorted(it.value(), slot);
+        if (it.value().empty())
+            postings_.erase(it);
+    }
+
+    // drop dead slots once they outnumber the live ones
+    if (entries_.size() > 64 && entries_.size() > 2 * size_t(slotOf_.size()))
+        compact();
+}
+
+void ProjectSearchIndex::compact()
+{
+    std::vector<Entry> alive;
+    alive.reserve(slotOf_.size());
+    for (const auto& entry : entries_)
+        if (entry.alive)
+            alive.push_back(entry);
+
+    clear();
+    for (const auto& entry : alive) {
+        const int slot = int(entries_.size());
+        entries_.push_back(entry);
+        slotOf_.insert(entry.id, slot);
+        index(slot, false);
+    }
+    sortKeys();
+}
+
+void ProjectSearchIndex::clear()
+{
+    entries_.clear();
+    slotOf_.clear();
+    exactCount_.clear();
+    keys_.clear();
+    postings_.clear();
+}
+
+bool ProjectSearchIndex::contains(const QString& name) const
+{
+    return exactCount_.contains(name.toLower());
+}
+
+int ProjectSearchIndex::editDistance(const QString& a, const QString& b, int maxDistance)
+{
+    const int n = a.size();
+    const int m = b.size();
+    if (qAbs(n - m) > maxDistance)
+        return maxDistance + 1;
+
+    std::vector<int> previous2(m + 1), previous(m + 1), current(m + 1);
+    for (int j = 0; j <= m; ++j)
+        previous[j] = j;
+
+    for (int i = 1; i <= n; ++i) {
+        current[0] = i;
+        int rowMin = current[0];
+        for (int j = 1; j <= m; ++j) {
+            const int cost = a.at(i - 1) == b.at(j - 1) ? 0 : 1;
+            int value = std::min({previous[j] + 1, current[j - 1] + 1, previous[j - 1] + cost});
+            // adjacent transposition
+            if (i > 1 && j > 1 && a.at(i - 1) == b.at(j - 2) && a.at(i - 2) == b.at(j - 1))
+                value = std::min(value, previous2[j - 2] + 1);
+            current[j] = value;
+            rowMin = std::min(rowMin, value);
+        }
+        if (rowMin > maxDistance)
+            return maxDistance + 1;
+        std::swap(previous2, previous);
+        std::swap(previous, current);
+    }
+    return std::min(previous[m], maxDistance + 1);
+}
+
+QList<ProjectSearchIndex::Match> ProjectSearchIndex::search(const QString& query, int limit) const
+{
+    const QString q = query.trimmed().toLower();
+    if (q.isEmpty() || limit <= 0)
+        return {};
+
+    // best tier and distance found per slot
+    QHash<int, std::pair<Tier, int>> best;
+    auto offer = [&best](int slot, Tier tier, int distance) {
+        auto it = best.find(slot);
+        if (it == best.end())
+            best.insert(slot, {tier, distance});
+        else if (std::make_pair(tier, distance) < it.value())
+            it.value() = {tier, distance};
+    };
+
+    // exact, prefix and word start: one binary search in the suffix array
+    auto it = std::lower_bound(keys_.begin(), keys_.end(), q,
+                               [](const Key& k, const QString& text) { return keyLess(k.text, text); });
+    for (; it != keys_.end() && it->text.startsWith(q); ++it) {
+        if (it->position > 0)
+            offer(it->slot, Tier::WordStart, 0);
+        else
+            offer(it->slot, entries_[it->slot].lower.size() == q.size() ? Tier::Exact : Tier::Prefix, 0);
+    }
+
+    const QList<quint64> grams = trigrams(q);
+    if (grams.isEmpty()) {
+        // one or two characters: too short for trigrams, the names are already lowercased
+        for (int slot = 0; slot < int(entries_.size()); ++slot) {
+            if (entries_[slot].alive && entries_[slot].lower.contains(q))
+                offer(slot, Tier::Substring, 0);
+        }
+    } else {
+        // substring candidates contain every trigram of the query
+        QList<const std::vector<int>*> lists;
+        bool complete = true;
+        for (quint64 gram : grams) {
+            auto posting = postings_.find(gram);
+            if (posting == postings_.end()) {
+                complete = false;
+                break;
+            }
+            lists << &posting.value();
+        }
+        if (complete) {
+            std::sort(lists.begin(), lists.end(), [](auto a, auto b) { return a->size() < b->size(); });
+            for (int slot : *lists.first()) {
+                bool all = true;
+                for (int i = 1; i < lists.size() && all; ++i)
+                    all = std::binary_search(lists[i]->begin(), lists[i]->end(), slot);
+                if (all && entries_[slot].lower.contains(q))
+                    offer(slot, Tier::Substring, 0);
+            }
+        }
+
+        // fuzzy: names sharing the most trigrams with the query, checked by edit distance
+        if (best.size() < limit) {
+            QHash<int, int> shared;
+            for (quint64 gram : grams) {
+                auto posting = postings_.find(gram);
+                if (posting == postings_.end())
+                    continue;
+                for (int slot : posting.value())
+                    if (!best.contains(slot))
+                        ++shared[slot];
+            }
+
+            QList<std::pair<int, int>> ranked;
+            ranked.reserve(shared.size());
+            for (auto s = shared.cbegin(); s != shared.cend(); ++s)
+                ranked.append({s.value(), s.key()});
+            std::sort(ranked.begin(), ranked.end(), std::greater<>());
+            if (ranked.size() > 64)
+                ranked.resize(64);
+
+            const int maxDistance = maxDistanceFor(q.size());
+            for (const auto& candidate : ranked) {
+                const QString& lower = entries_[candidate.second].lower;
+                int distance = editDistance(q, lower, maxDistance);
+                // typo in one word of a longer name: compare against the start of each word
+                for (int start : wordStarts(lower)) {
+                    if (distance == 0)
+                        break;
+                    const QString word = lower.mid(start, q.size());
+                    distance = std::min(distance, editDistance(q, word, maxDistance));
+                }
+                if (distance <= maxDistance)
+                    offer(candidate.second, Tier::Fuzzy, distance);
+            }
+        }
+    }
+
+    QList<Match> matches;
+    matches.reserve(best.size());
+    for (auto b = best.cbegin(); b != best.cend(); ++b) {
+        const Entry& entry = entries_[b.key()];
+        matches.append({entry.id, entry.name, b.value().first, b.value().second});
+    }
+
+    auto less = [](const Match& a, const Match& b) {
+        if (a.tier != b.tier)
+            return a.tier < b.tier;
+        if (a.distance != b.distance)
+            return a.distance < b.distance;
+        if (a.name.size() != b.name.size())
+            return a.name.size() < b.name.size();
+        return a.name < b.name;
+    };
+    if (matches.size() > limit) {
+        std::partial_sort(matches.begin(), matches.begin() + limit, matches.end(), less);
+        matches.resize(limit);
+    } else {
+        std::sort(matches.begin(), matches.end(), less);
+    }
+    return matches;
+}
+
+QStringList ProjectSearchIndex::suggest(const QString& query, int limit) const
+{
+    QStringList names;
+    for (const auto& match : search(query, limit))
+        names << match.name;
+    return names;
+}
@@ -0,0 +1,86 @@
+#ifndef PROJECTSEARCHINDEX_H
+#define PROJECTSEARCHINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+#include <vector>
+
+/**
+ * @class ProjectSearchIndex
+ * @brief In-memory autocomplete index over project names.
+ *
+ * Names are lowercased once on insert. Every word suffix of a name is kept in
+ * a sorted array (a flattened prefix trie), so prefix and word-start lookups
+ * are a binary search. Trigram postings narrow substring and fuzzy candidates
+ * without scanning every name. Results are ranked
+ * exact > prefix > word start > substring > edit distance.
+ */
+class ProjectSearchIndex
+{
+public:
+    enum class Tier {
+        Exact,
+        Prefix,
+        WordStart,
+        Substring,
+        Fuzzy
+    };
+
+    struct Match {
+        int id;
+        QString name;
+        Tier tier;
+        int distance;
+    };
+
+    void insert(int id, const QString& name);
+    void remove(int id);
+
+    /**
+     * @brief Replace the whole index with (id, name) pairs, sorting the keys once
+     *        rather than inserting each one in place; a repeated id keeps its last name
+     */
+    void rebuild(const QList<std::pair<int, QString>>& projects);
+    void clear();
+
+    int size() const { return int(slotOf_.size()); }
+    bool contains(const QString& name) const;
+
+    QList<Match> search(const QString& query, int limit = 10) const;
+    QStringList suggest(const QString& query, int limit = 10) const;
+
+    /**
+     * @brief Optimal string alignment distance, or maxDistance + 1 once it is exceeded
+     */
+    static int editDistance(const QString& a, const QString& b, int maxDistance);
+
+private:
+    struct Entry {
+        int id;
+        QString name;
+        QString lower;
+        bool alive;
+    };
+
+    struct Key {
+        QString text;   // suffix of the lowercased name starting at a word
+        int slot;
+        int position;   // 0 for the whole name
+    };
+
+    std::vector<Entry> entries_;
+    QHash<int, int> slotOf_;
+    QHash<QString, int> exactCount_;
+    std::vector<Key> keys_;
+    QHash<quint64, std::vector<int>> postings_;
+
+    void index(int slot, bool keepSorted = true);
+    void sortKeys();
+    void compact();
+    static QList<int> wordStarts(const QString& lower);
+    static QList<quint64> trigrams(const QString& lower);
+};
+
+#endif // PROJECTSEARCHINDEX_H
@@ -0,0 +1,247 @@
+#include "searchmodel.h"
+#include <QDebug>
+#include <QRegularExpression>
+
+namespace homepage{
+
+SearchModel::SearchModel(DbmPtr db, QObject *parent)
+    : QAbstractListModel{parent}, db_(db)
+{
+}
+
+int SearchModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return m_hits.size();
+}
+
+QVariant SearchModel::data(const QModelIndex &index, int role) const
+{
+    const int row = index.row();
+    if (!index.isValid() || row >= m_hits.size())
+        return QVariant();
+
+    const auto& hit = m_hits.at(row);
+    switch (role) {
+    case KindRole: return hit.kind;
+    case RowIdRole: return hit.id;
+    case ProjectIdRole: return hit.projectId;
+    case ProjectNameRole: return hit.projectName;
+    case Qt::DisplayRole:
+    case TitleRole: return hit.title;
+    case SnippetRole: return hit.snippet;
+    case RankRole: return hit.rank;
+    default: return QVariant();
+    }
+}
+
+QHash<int, QByteArray> SearchModel::roleNames() const
+{
+    return {
+        { KindRole, "kind" },
+        { RowIdRole, "rowId" },
+        { ProjectIdRole, "projectId" },
+        { ProjectNameRole, "projectName" },
+        { TitleRole, "title" },
+        { SnippetRole, "snippet" },
+        { RankRole, "rank" }
+    };
+}
+
+bool SearchModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && m_hasMore && !m_loading;
+}
+
+void SearchModel::fetchMore(const QModelIndex &parent)
+{
+    if (canFetchMore(parent))
+        requestPage();
+}
+
+void SearchModel::loadMore()
+{
+    fetchMore(QModelIndex());
+}
+
+void SearchModel::clear()
+{
+    setQuery(QString());
+}
+
+void SearchModel::setQuery(const QString &query)
+{
+    if (m_query == query)
+        return;
+    m_query = query;
+    m_match = matchExpression(query);
+    m_pattern = likePattern(query);
+    emit queryChanged();
+
+    // results of the previous query are dropped when they arrive
+    ++m_generation;
+    beginResetModel();
+    m_hits.clear();
+    endResetModel();
+    setLoading(false);
+    setHasMore(false);
+
+    if (!m_match.isEmpty()) {
+        m_fullText = hasFullTextIndex();
+        requestPage();
+    }
+}
+
+void SearchModel::setPageSize(int pageSize)
+{
+    pageSize = qMax(1, pageSize);
+    if (m_pageSize == pageSize)
+        return;
+    m_pageSize = pageSize;
+    emit pageSizeChanged();
+}
+
+QString SearchModel::matchExpression(const QString &text)
+{
+    static const QRegularExpression separators(R"([^\w]+)", QRegularExpression::UseUnicodePropertiesOption);
+
+    QStringList terms;
+    for (const auto& word : text.split(separators, Qt::SkipEmptyParts)) {
+        // the quotes keep FTS5 operators (AND, NEAR, column:) in user input literal
+        QString term = word;
+        term.replace('"', "\"\"");
+        terms << QString("\"%1\"*").arg(term);
+    }
+    return terms.join(' ');
+}
+
+QString SearchModel::searchSql()
+{
+    return R"(
+        SELECT r.kind, r.id, r.project_id, IFNULL(p.name, ''), r.title, r.snippet, r.rank FROM (
+            SELECT 'task' AS kind, t.id AS id, t.project_id AS project_id, t.title AS title,
+                   snippet(tasks_fts, -1, '<b>', '</b>', '...', 12) AS snippet,
+                   bm25(tasks_fts, 10.0, 1.0) AS rank
+            FROM tasks_fts JOIN tasks AS t ON t.id = tasks_fts.rowid
+            WHERE tasks_fts MATCH ?
+            UNION ALL
+            SELECT 'link', l.id, l.project_id, IFNULL(NULLIF(l.website, ''), l.url),
+                   snippet(links_fts, -1, '<b>', '</b>', '...', 12),
+                   bm25(links_fts, 1.0, 5.0)
+            FROM links_fts JOIN links AS l ON l.id = links_fts.rowid
+            WHERE links_fts MATCH ?
+            UNION ALL
+            SELECT 'reference', f.id, f.project_id, f.title,
+                   snippet(references_fts, -1, '<b>', '</b>', '...', 12),
+                   bm25(references_fts, 10.0, 1.0)
+            FROM references_fts JOIN "references" AS f ON f.id = references_fts.rowid
+            WHERE references_fts MATCH ?
+            UNION ALL
+            SELECT 'event', c.id, c.project_id, c.event,
+                   snippet(calendars_fts, -1, '<b>', '</b>', '...', 12),
+                   bm25(calendars_fts, 10.0, 1.0)
+            FROM calendars_fts JOIN calendars AS c ON c.id = calendars_fts.rowid
+            WHERE calendars_fts MATCH ?
+        ) AS r
+        LEFT JOIN projects AS p ON p.id = r.project_id
+        ORDER BY r.rank, r.kind, r.id
+        LIMIT ? OFFSET ?
+    )";
+}
+
+QString SearchModel::fallbackSql()
+{
+    return R"(
+        SELECT r.kind, r.id, r.project_id, IFNULL(p.name, ''), r.title, r.snippet, r.rank FROM (
+            SELECT 'task' AS kind, t.id AS id, t.project_id AS project_id, t.title AS title,
+                   IFNULL(t.description, '') AS snippet, 0.0 AS rank
+            FROM tasks AS t
+            WHERE t.title LIKE ? ESCAPE '\' OR t.description LIKE ? ESCAPE '\'
+            UNION ALL
+            SELECT 'link', l.id, l.project_id, IFNULL(NULLIF(l.website, ''), l.url), l.url, 0.0
+            FROM links AS l
+            WHERE l.url LIKE ? ESCAPE '\' OR l.website LIKE ? ESCAPE '\'
+            UNION ALL
+            SELECT 'reference', f.id, f.project_id, f.title, '', 0.0
+            FROM "references" AS f
+            WHERE f.title LIKE ? ESCAPE '\' OR f.bibtex LIKE ? ESCAPE '\'
+            UNION ALL
+            SELECT 'event', c.id, c.project_id, c.event, IFNULL(c.description, ''), 0.0
+            FROM calendars AS c
+            WHERE c.event LIKE ? ESCAPE '\' OR c.description LIKE ? ESCAPE '\'
+        ) AS r
+        LEFT JOIN projects AS p ON p.id = r.project_id
+        ORDER BY r.kind, r.id
+        LIMIT ? OFFSET ?
+    )";
+}
+
+QString SearchModel::likePattern(const QString &text)
+{
+    QString pattern = text.simplified();
+    pattern.replace('\\', "\\\\");
+    pattern.replace('%', "\\%");
+    pattern.replace('_', "\\_");
+    return '%' + pattern + '%';
+}
+
+bool SearchModel::hasFullTextIndex() const
+{
+    return db_->selectValue<int>(
+               "SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' AND name = 'tasks_fts'") > 0;
+}
+
+void SearchModel::requestPage()
+{
+    const int generation = m_generation;
+    const int offset = m_hits.size();
+    setLoading(true);
+
+    QVariantList params;
+    if (m_fullText) {
+        params = {m_match, m_match, m_match, m_match};
+    } else {
+        for (int i = 0; i < 8; ++i)
+            params << m_pattern;
+    }
+    // one extra row tells whether another page exists
+    params << m_pageSize + 1 << offset;
+
+    db_->selectRowsAsync<Hit, QString, int, int, QString, QString, QString, double>(
+           m_fullText ? searchSql() : fallbackSql(), params)
+        .then(this, [this, generation](QList<Hit> hits) {
+            if (generation != m_generation)
+                return;
+
+            const bool more = hits.size() > m_pageSize;
+            if (more)
+                hits.removeLast();
+
+            if (!hits.isEmpty()) {
+                beginInsertRows(QModelIndex(), m_hits.size(), m_hits.size() + hits.size() - 1);
+                m_hits.append(hits);
+                endInsertRows();
+            }
+            setLoading(false);
+            setHasMore(more);
+        });
+}
+
+void SearchModel::setLoading(bool loading)
+{
+    if (m_loading == loading)
+        return;
+    m_loading = loading;
+    emit loadingChanged();
+}
+
+void SearchModel::setHasMore(bool hasMore)
+{
+    if (m_hasMore == hasMore)
+        return;
+    m_hasMore = hasMore;
+    emit hasMoreChanged();
+}
+
+}
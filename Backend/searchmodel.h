@@ -0,0 +1,118 @@
+#ifndef SEARCHMODEL_H
+#define SEARCHMODEL_H
+
+#include <QObject>
+#include <QAbstractListModel>
+#include "database.h"
+
+namespace homepage{
+
+/**
+ * @brief Workspace-wide full-text search over tasks, links, references and events.
+ *
+ * Backed by the FTS5 tables of research migration 3. Results are ranked with
+ * bm25 and loaded a page at a time on the database worker thread; views pull
+ * further pages through fetchMore() (or loadMore() from QML). On a SQLite
+ * without FTS5 the migration skips the index and the model falls back to an
+ * unranked substring search (fallbackSql()).
+ */
+class SearchModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(QString query READ query WRITE setQuery NOTIFY queryChanged FINAL)
+    Q_PROPERTY(int pageSize READ pageSize WRITE setPageSize NOTIFY pageSizeChanged FINAL)
+    Q_PROPERTY(bool loading READ loading NOTIFY loadingChanged FINAL)
+    Q_PROPERTY(bool hasMore READ hasMore NOTIFY hasMoreChanged FINAL)
+public:
+    explicit SearchModel(DbmPtr db, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    Q_INVOKABLE void loadMore();
+
+    QString query() const { return m_query; }
+    void setQuery(const QString &query);
+
+    int pageSize() const { return m_pageSize; }
+    void setPageSize(int pageSize);
+
+    bool loading() const { return m_loading; }
+    bool hasMore() const { return m_hasMore; }
+
+    /**
+     * @brief Turn free text into an FTS5 expression: every word quoted, prefix matched, ANDed.
+     */
+    static QString matchExpression(const QString &text);
+
+    /**
+     * @brief The ranked UNION over all indexed tables; binds the match expression
+     * four times, then LIMIT and OFFSET.
+     */
+    static QString searchSql();
+
+    /**
+     * @brief searchSql() without the FTS5 index: substring LIKE over the same
+     * columns, unranked; binds likePattern() eight times, then LIMIT and OFFSET.
+     */
+    static QString fallbackSql();
+
+    /**
+     * @brief "%text%" with LIKE wildcards in text escaped by '\'
+     */
+    static QString likePattern(const QString &text);
+
+public slots:
+    void clear();
+
+signals:
+    void queryChanged();
+    void pageSizeChanged();
+    void loadingChanged();
+    void hasMoreChanged();
+
+private:
+    enum SearchRoles {
+        KindRole = Qt::UserRole + 1,
+        RowIdRole,
+        ProjectIdRole,
+        ProjectNameRole,
+        TitleRole,
+        SnippetRole,
+        RankRole
+    };
+
+    struct Hit{
+        QString kind;
+        int id;
+        int projectId;
+        QString projectName;
+        QString title;
+        QString snippet;
+        double rank;
+    };
+
+    DbmPtr db_;
+    QString m_query;
+    QString m_match;
+    QString m_pattern;
+    // the FTS5 index exists; checked for every new query since the workspace may change
+    bool m_fullText = true;
+    QList<Hit> m_hits;
+    int m_pageSize = 50;
+    int m_generation = 0;
+    bool m_loading = false;
+    bool m_hasMore = false;
+
+    void requestPage();
+    bool hasFullTextIndex() const;
+    void setLoading(bool loading);
+    void setHasMore(bool hasMore);
+};
+
+}
+
+#endif // SEARCHMODEL_H
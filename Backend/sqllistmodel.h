@@ -0,0 +1,412 @@
+#ifndef SQLLISTMODEL_H
+#define SQLLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QVariant>
+#include <algorithm>
+#include <optional>
+#include "database.h"
+
+/**
+ * @brief Maps one item role to a value read from a Row.
+ */
+template<typename Row>
+struct RoleBinding
+{
+    int role;
+    QByteArray name;
+    QVariant (*value)(const Row&);
+};
+
+namespace sqllistmodel_detail {
+template<typename T> struct MemberOf;
+template<typename C, typename M> struct MemberOf<M C::*> { using Class = C; };
+}
+
+/**
+ * @brief Role bound to a data member, e.g. bindRole<&TaskRecord::title>(TitleRole, "title")
+ */
+template<auto Member>
+RoleBinding<typename sqllistmodel_detail::MemberOf<decltype(Member)>::Class> bindRole(int role, const char* name)
+{
+    using Row = typename sqllistmodel_detail::MemberOf<decltype(Member)>::Class;
+    return {role, name, [](const Row& row) { return QVariant::fromValue(row.*Member); }};
+}
+
+/**
+ * @class SqlListModel
+ * @brief Item model over the rows of one table of a DatabaseManager.
+ *
+ * Rows are stored contiguously in the order given by lessThan() (ascending id
+ * unless overridden); Row must have an int `id` member holding the primary
+ * key. Roles are bound to Row members with bindRole(), so data() and
+ * roleNames() need no per-model switch.
+ *
+ * setRows() replaces the content through a keyed diff: rows are matched by id
+ * and the view receives the minimal remove/move/insert/dataChanged signals,
+ * keeping its scroll position and delegates across refreshes. Changes the
+ * DatabaseManager publishes for the table are applied row by row through
+ * fetchRow(), or with refresh() when the changed rows are unknown.
+ *
+ * Base may be QAbstractTableModel for models that also expose columns; those
+ * override data()/columnCount() and usually rowsChanged().
+ */
+template<typename Row, typename Base = QAbstractListModel>
+class SqlListModel : public Base
+{
+public:
+    using Roles = QList<RoleBinding<Row>>;
+
+    SqlListModel(DbmPtr db, const QString& table, const Roles& roles, QObject* parent = nullptr)
+        : Base(parent), db_(db), roles_(roles)
+    {
+        subscription_ = db_->subscribe(table, [this](const ChangeEvent& change) {
+            applyChange(change);
+        });
+    }
+
+    ~SqlListModel() override
+    {
+        db_->unsubscribe(subscription_);
+    }
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override
+    {
+        return parent.isValid() ? 0 : int(rows_.size());
+    }
+
+    QVariant data(const QModelIndex& index, int role) const override
+    {
+        if (!index.isValid() || index.row() >= rows_.size())
+            return QVariant();
+        for (const auto& binding : roles_)
+            if (binding.role == role)
+                return binding.value(rows_.at(index.row()));
+        return QVariant();
+    }
+
+    QHash<int, QByteArray> roleNames() const override
+    {
+        QHash<int, QByteArray> names;
+        for (const auto& binding : roles_)
+            names.insert(binding.role, binding.name);
+        return names;
+    }
+
+protected:
+    DbmPtr db_;
+
+    /**
+     * @brief Reload every row, typically ending in setRows()
+     */
+    virtual void refresh() = 0;
+
+    /**
+     * @brief Read row id, or nothing when it does not belong to this model
+     */
+    virtual std::optional<Row> fetchRow(int id) = 0;
+
+    virtual void applyChange(const ChangeEvent& change)
+    {
+        if (change.rowid < 0) {
+            refresh();
+            return;
+        }
+        const int id = int(change.rowid);
+        std::optional<Row> row;
+        if (change.op != ChangeOp::Delete)
+            row = fetchRow(id);
+        if (row)
+            upsertRow(*row);
+        else
+            removeKey(id);
+    }
+
+    virtual bool lessThan(const Row& a, const Row& b) const
+    {
+        return a.id < b.id;
+    }
+
+    /**
+     * @brief Take the database values of a row that is already shown; override
+     * to keep view-only state such as check marks
+     */
+    virtual void mergeRow(Row& current, const Row& fetched) const
+    {
+        current = fetched;
+    }
+
+    /**
+     * @brief Whether going from one row count to another needs a model reset,
+     * e.g. when columnCount() depends on having rows
+     */
+    virtual bool needsReset(int from, int to) const
+    {
+        Q_UNUSED(from);
+        Q_UNUSED(to);
+        return false;
+    }
+
+    virtual void rowsChanged(int first, int last, const QList<int>& roles)
+    {
+        emit this->dataChanged(this->index(first, 0), this->index(last, 0), roles);
+    }
+
+    const QList<Row>& rows() const { return rows_; }
+
+    /**
+     * @brief Mutable row for view-only state; must not change the sort order
+     */
+    Row& rowAt(int index) { return rows_[index]; }
+
+    int indexOfKey(int id) const
+    {
+        for (int i = 0; i < rows_.size(); ++i)
+            if (rows_.at(i).id == id)
+                return i;
+        return -1;
+    }
+
+    /**
+     * @brief Index row takes among the other rows (itself excluded when present)
+     */
+    int positionFor(const Row& row) const
+    {
+        auto it = std::upper_bound(rows_.begin(), rows_.end(), row, [this](const Row& value, const Row& other) {
+            return lessThan(value, other);
+        });
+        const int position = int(it - rows_.begin());
+        const int current = indexOfKey(row.id);
+        return current >= 0 && current < position ? position - 1 : position;
+    }
+
+    /**
+     * @brief Replace the content with fresh (already in display order) through a keyed diff
+     */
+    void setRows(QList<Row> fresh)
+    {
+        if (rows_.isEmpty() && fresh.isEmpty())
+            return;
+
+        QHash<int, int> freshIndex;
+        freshIndex.reserve(fresh.size());
+        for (int i = 0; i < fresh.size(); ++i)
+            freshIndex.insert(fresh.at(i).id, i);
+
+        bool overlap = false;
+        for (const auto& row : rows_) {
+            if (freshIndex.contains(row.id)) {
+                overlap = true;
+                break;
+            }
+        }
+
+        // nothing to keep (e.g. another project): a reset is cheaper than per-row signals
+        if (!overlap || needsReset(rows_.size(), fresh.size())) {
+            this->beginResetModel();
+            rows_ = std::move(fresh);
+            this->endResetModel();
+            return;
+        }
+
+        // 1. removals, back to front in contiguous ranges
+        for (int last = rows_.size() - 1; last >= 0;) {
+            if (freshIndex.contains(rows_.at(last).id)) {
+                --last;
+                continue;
+            }
+            int first = last;
+            while (first > 0 && !freshIndex.contains(rows_.at(first - 1).id))
+                --first;
+            this->beginRemoveRows(QModelIndex(), first, last);
+            rows_.remove(first, last - first + 1);
+            this->endRemoveRows();
+            last = first - 1;
+        }
+
+        // 2. moves: the longest run already in fresh order stays, every other row
+        //    is moved right behind its predecessor in fresh
+        QHash<int, int> currentIndex;
+        currentIndex.reserve(rows_.size());
+        for (int i = 0; i < rows_.size(); ++i)
+            currentIndex.insert(rows_.at(i).id, i);
+
+        QList<int> order;
+        QList<int> positions;
+        for (const auto& row : fresh) {
+            auto it = currentIndex.constFind(row.id);
+            if (it != currentIndex.cend()) {
+                order << row.id;
+                positions << it.value();
+            }
+        }
+        QSet<int> stable;
+        for (int i : longestIncreasing(positions))
+            stable.insert(order.at(i));
+
+        for (int i = 0; i < order.size(); ++i) {
+            if (stable.contains(order.at(i)))
+                continue;
+            const int from = indexOfKey(order.at(i));
+            const int to = i == 0 ? 0 : indexOfKey(order.at(i - 1)) + 1;
+            if (to == from)
+                continue;
+            this->beginMoveRows(QModelIndex(), from, from, QModelIndex(), to);
+            rows_.move(from, to > from ? to - 1 : to);
+            this->endMoveRows();
+        }
+
+        // 3. inserts and value changes; the kept rows are now in fresh order
+        int changedFirst = -1;
+        QList<int> changedRoles;
+        auto flushChanged = [&](int last) {
+            if (changedFirst >= 0)
+                rowsChanged(changedFirst, last, changedRoles);
+            changedFirst = -1;
+            changedRoles.clear();
+        };
+
+        for (int i = 0; i < fresh.size();) {
+            if (i < rows_.size() && rows_.at(i).id == fresh.at(i).id) {
+                Row merged = rows_.at(i);
+                mergeRow(merged, fresh.at(i));
+                const QList<int> roles = differingRoles(rows_.at(i), merged);
+                if (roles.isEmpty()) {
+                    flushChanged(i - 1);
+                } else {
+                    rows_[i] = std::move(merged);
+                    if (changedFirst < 0)
+                        changedFirst = i;
+                    for (int role : roles)
+                        if (!changedRoles.contains(role))
+                            changedRoles << role;
+                }
+                ++i;
+                continue;
+            }
+
+            flushChanged(i - 1);
+            int count = 1;
+            while (i + count < fresh.size() && !currentIndex.contains(fresh.at(i + count).id))
+                ++count;
+            this->beginInsertRows(QModelIndex(), i, i + count - 1);
+            for (int k = 0; k < count; ++k)
+                rows_.insert(i + k, fresh.at(i + k));
+            this->endInsertRows();
+            i += count;
+        }
+        flushChanged(fresh.size() - 1);
+    }
+
+    /**
+     * @brief Append rows sorting after every current row (next page); known ids are skipped
+     */
+    void appendRows(QList<Row> more)
+    {
+        more.erase(std::remove_if(more.begin(), more.end(), [this](const Row& row) {
+            return indexOfKey(row.id) >= 0;
+        }), more.end());
+        if (more.isEmpty())
+            return;
+
+        const int first = rows_.size();
+        this->beginInsertRows(QModelIndex(), first, first + more.size() - 1);
+        rows_.append(more);
+        this->endInsertRows();
+    }
+
+    /**
+     * @brief Insert row at its sorted position, or update it and move it there
+     */
+    void upsertRow(const Row& fetched)
+    {
+        const int row = indexOfKey(fetched.id);
+        if (row < 0) {
+            const int position = positionFor(fetched);
+            if (needsReset(rows_.size(), rows_.size() + 1)) {
+                this->beginResetModel();
+                rows_.insert(position, fetched);
+                this->endResetModel();
+                return;
+            }
+            this->beginInsertRows(QModelIndex(), position, position);
+            rows_.insert(position, fetched);
+            this->endInsertRows();
+            return;
+        }
+
+        Row merged = rows_.at(row);
+        mergeRow(merged, fetched);
+        const QList<int> roles = differingRoles(rows_.at(row), merged);
+        const int position = positionFor(merged);
+        rows_[row] = merged;
+
+        if (position != row) {
+            // destination is expressed in terms of the rows before the move
+            this->beginMoveRows(QModelIndex(), row, row, QModelIndex(), position > row ? position + 1 : position);
+            rows_.move(row, position);
+            this->endMoveRows();
+        }
+        if (!roles.isEmpty())
+            rowsChanged(position, position, roles);
+    }
+
+    void removeKey(int id)
+    {
+        const int row = indexOfKey(id);
+        if (row < 0)
+            return;
+        if (needsReset(rows_.size(), rows_.size() - 1)) {
+            this->beginResetModel();
+            rows_.removeAt(row);
+            this->endResetModel();
+            return;
+        }
+        this->beginRemoveRows(QModelIndex(), row, row);
+        rows_.removeAt(row);
+        this->endRemoveRows();
+    }
+
+private:
+    Roles roles_;
+    QList<Row> rows_;
+    int subscription_;
+
+    QList<int> differingRoles(const Row& a, const Row& b) const
+    {
+        QList<int> roles;
+        for (const auto& binding : roles_)
+            if (binding.value(a) != binding.value(b))
+                roles << binding.role;
+        return roles;
+    }
+
+    // indexes into seq of one longest strictly increasing subsequence
+    static QList<int> longestIncreasing(const QList<int>& seq)
+    {
+        QList<int> tails;
+        QList<int> previous(seq.size(), -1);
+        for (int i = 0; i < seq.size(); ++i) {
+            auto it = std::lower_bound(tails.begin(), tails.end(), seq.at(i), [&seq](int tail, int value) {
+                return seq.at(tail) < value;
+            });
+            const int length = int(it - tails.begin());
+            if (length > 0)
+                previous[i] = tails.at(length - 1);
+            if (length == tails.size())
+                tails.append(i);
+            else
+                tails[length] = i;
+        }
+
+        QList<int> result;
+        for (int i = tails.isEmpty() ? -1 : tails.last(); i >= 0; i = previous.at(i))
+            result.prepend(i);
+        return result;
+    }
+};
+
+#endif // SQLLISTMODEL_H
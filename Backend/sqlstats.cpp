@@ -0,0 +1,195 @@
+#include "sqlstats.h"
+#include <QJsonArray>
+#include <QRegularExpression>
+#include <algorithm>
+
+namespace {
+
+int bucketFor(qint64 elapsedUs)
+{
+    int bucket = 0;
+    while (elapsedUs > 1 && bucket < SqlStats::BucketCount - 1) {
+        elapsedUs >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+}
+
+qint64 SqlStats::Entry::p95Us() const
+{
+    if (count == 0)
+        return 0;
+    const qint64 target = (count * 95 + 99) / 100;
+    qint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += buckets[i];
+        if (seen >= target)
+            return std::min(qint64(1) << (i + 1), maxUs);
+    }
+    return maxUs;
+}
+
+QString SqlStats::normalize(const QString& sql)
+{
+    static const QRegularExpression stringLiteral(R"('(?:[^']|'')*')");
+    static const QRegularExpression numberLiteral(R"((?<![\w"])-?\d+(?:\.\d+)?\b)");
+    static const QRegularExpression placeholderList(R"(\?(?:\s*,\s*\?)+)");
+    static const QRegularExpression whitespace(R"(\s+)");
+
+    QString text = sql;
+    text.replace(stringLiteral, "?");
+    text.replace(numberLiteral, "?");
+    // IN (?, ?, ?) lists of any length share one entry
+    text.replace(placeholderList, "?...");
+    text.replace(whitespace, " ");
+    return text.trimmed();
+}
+
+void SqlStats::setEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_enabled = enabled;
+}
+
+bool SqlStats::isEnabled() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_enabled;
+}
+
+void SqlStats::setSlowThresholdMs(int ms)
+{
+    QMutexLocker locker(&m_mutex);
+    m_slowThresholdMs = std::max(0, ms);
+}
+
+int SqlStats::slowThresholdMs() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_slowThresholdMs;
+}
+
+void SqlStats::setSlowLogCapacity(int capacity)
+{
+    QMutexLocker locker(&m_mutex);
+    m_slowCapacity = std::max(1, capacity);
+    while (m_slow.size() > m_slowCapacity)
+        m_slow.removeFirst();
+}
+
+bool SqlStats::isSlow(qint64 elapsedUs) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_enabled && elapsedUs >= qint64(m_slowThresholdMs) * 1000;
+}
+
+void SqlStats::record(const QString& sql, qint64 elapsedUs, int rows)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_enabled)
+        return;
+
+    // normalize() runs regexes; statements repeat, so each SQL string is normalized once
+    auto cached = m_keys.constFind(sql);
+    if (cached == m_keys.constEnd()) {
+        // SQL with inlined literals never repeats, keep the cache bounded
+        if (m_keys.size() >= KeyCacheCapacity)
+            m_keys.clear();
+        cached = m_keys.insert(sql, normalize(sql));
+    }
+    const QString key = *cached;
+
+    Entry& e = m_entries[key];
+    if (e.count == 0) {
+        e.sql = key;
+        e.minUs = elapsedUs;
+    }
+    ++e.count;
+    e.totalUs += elapsedUs;
+    e.minUs = std::min(e.minUs, elapsedUs);
+    e.maxUs = std::max(e.maxUs, elapsedUs);
+    e.rows += rows;
+    ++e.buckets[bucketFor(elapsedUs)];
+}
+
+void SqlStats::recordSlow(const QString& sql, qint64 elapsedUs, int rows, const QStringList& plan)
+{
+    SlowQuery slow;
+    slow.sql = sql.simplified();
+    slow.elapsedUs = elapsedUs;
+    slow.rows = rows;
+    slow.when = QDateTime::currentDateTime();
+    slow.plan = plan;
+
+    QMutexLocker locker(&m_mutex);
+    m_slow.append(slow);
+    while (m_slow.size() > m_slowCapacity)
+        m_slow.removeFirst();
+}
+
+QList<SqlStats::Entry> SqlStats::entries() const
+{
+    QMutexLocker locker(&m_mutex);
+    QList<Entry> result = m_entries.values();
+    std::sort(result.begin(), result.end(), [](const Entry& a, const Entry& b) {
+        return a.totalUs > b.totalUs;
+    });
+    return result;
+}
+
+SqlStats::Entry SqlStats::entry(const QString& sql) const
+{
+    const QString key = normalize(sql);
+    QMutexLocker locker(&m_mutex);
+    return m_entries.value(key);
+}
+
+QList<SqlStats::SlowQuery> SqlStats::slowQueries() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_slow;
+}
+
+void SqlStats::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_keys.clear();
+    m_entries.clear();
+    m_slow.clear();
+}
+
+QJsonObject SqlStats::toJson() const
+{
+    QJsonArray statements;
+    for (const auto& e : entries()) {
+        QJsonObject obj;
+        obj["sql"] = e.sql;
+        obj["count"] = e.count;
+        obj["rows"] = e.rows;
+        obj["total_us"] = e.totalUs;
+        obj["mean_us"] = e.meanUs();
+        obj["min_us"] = e.minUs;
+        obj["max_us"] = e.maxUs;
+        obj["p95_us"] = e.p95Us();
+        statements.append(obj);
+    }
+
+    QJsonArray slow;
+    for (const auto& s : slowQueries()) {
+        QJsonObject obj;
+        obj["sql"] = s.sql;
+        obj["elapsed_us"] = s.elapsedUs;
+        obj["rows"] = s.rows;
+        obj["when"] = s.when.toString(Qt::ISODateWithMs);
+        obj["plan"] = QJsonArray::fromStringList(s.plan);
+        slow.append(obj);
+    }
+
+    QJsonObject root;
+    root["slow_threshold_ms"] = slowThresholdMs();
+    root["statements"] = statements;
+    root["slow_queries"] = slow;
+    return root;
+}
@@ -0,0 +1,89 @@
+#ifndef SQLSTATS_H
+#define SQLSTATS_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QMutex>
+#include <QDateTime>
+#include <QJsonObject>
+#include <array>
+
+/**
+ * @class SqlStats
+ * @brief Latency and row counters per normalized SQL statement.
+ *
+ * Statements are grouped after literals are replaced by '?' and whitespace is
+ * collapsed, so "WHERE id = 3" and "WHERE id = 7" share one entry. Latencies
+ * go into power-of-two microsecond buckets from which p95 is estimated.
+ * Statements slower than slowThresholdMs() are kept in a bounded slow-query
+ * log together with their EXPLAIN QUERY PLAN output. Thread-safe: a connection
+ * and its worker/reader connections share one instance.
+ */
+class SqlStats
+{
+public:
+    static constexpr int BucketCount = 32;
+    // raw SQL strings whose normalized form is remembered
+    static constexpr int KeyCacheCapacity = 1024;
+
+    struct Entry {
+        QString sql;
+        qint64 count = 0;
+        qint64 totalUs = 0;
+        qint64 minUs = 0;
+        qint64 maxUs = 0;
+        qint64 rows = 0;
+        std::array<qint64, BucketCount> buckets{};
+
+        double meanUs() const { return count ? double(totalUs) / count : 0.0; }
+        /**
+         * @brief Upper bound of the bucket holding the 95th percentile, capped at maxUs
+         */
+        qint64 p95Us() const;
+    };
+
+    struct SlowQuery {
+        QString sql;
+        qint64 elapsedUs = 0;
+        int rows = 0;
+        QDateTime when;
+        QStringList plan;
+    };
+
+    static QString normalize(const QString& sql);
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    void setSlowThresholdMs(int ms);
+    int slowThresholdMs() const;
+
+    void setSlowLogCapacity(int capacity);
+
+    bool isSlow(qint64 elapsedUs) const;
+
+    void record(const QString& sql, qint64 elapsedUs, int rows);
+    void recordSlow(const QString& sql, qint64 elapsedUs, int rows, const QStringList& plan);
+
+    QList<Entry> entries() const;
+    Entry entry(const QString& sql) const;
+    QList<SlowQuery> slowQueries() const;
+
+    void reset();
+
+    QJsonObject toJson() const;
+
+private:
+    mutable QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+    // raw SQL -> normalize(sql)
+    QHash<QString, QString> m_keys;
+    QList<SlowQuery> m_slow;
+    bool m_enabled = true;
+    int m_slowThresholdMs = 100;
+    int m_slowCapacity = 200;
+};
+
+#endif // SQLSTATS_H
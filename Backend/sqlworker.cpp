@@ -0,0 +1,47 @@
+#include "sqlworker.h"
+#include "database.h"
+#include <QDebug>
+
+SqlWorker::SqlWorker(const QString& connection_name)
+    : m_connectionName(connection_name)
+    , m_context(new QObject)
+    , m_db(nullptr)
+{
+    m_thread.setObjectName(connection_name);
+    m_context->moveToThread(&m_thread);
+    QObject::connect(&m_thread, &QThread::finished, m_context, &QObject::deleteLater);
+    m_thread.start();
+
+    QMetaObject::invokeMethod(m_context, [this]() {
+        m_db = new DatabaseManager(m_connectionName);
+    }, Qt::QueuedConnection);
+}
+
+SqlWorker::~SqlWorker()
+{
+    // The connection has to be torn down on the thread that owns it
+    QMetaObject::invokeMethod(m_context, [this]() {
+        delete m_db;
+        m_db = nullptr;
+        QSqlDatabase::removeDatabase(m_connectionName);
+    }, Qt::BlockingQueuedConnection);
+
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void SqlWorker::open(const QString& db_path)
+{
+    post([db_path](DatabaseManager& db) {
+        if (!db.connect(db_path))
+            qWarning() << "[SqlWorker] Failed to open" << db_path;
+    });
+}
+
+void SqlWorker::post(std::function<void(DatabaseManager&)> task)
+{
+    QMetaObject::invokeMethod(m_context, [this, task]() {
+        if (m_db)
+            task(*m_db);
+    }, Qt::QueuedConnection);
+}
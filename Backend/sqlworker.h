@@ -0,0 +1,68 @@
+#ifndef SQLWORKER_H
+#define SQLWORKER_H
+
+#include <QObject>
+#include <QThread>
+#include <QFuture>
+#include <QPromise>
+#include <QString>
+#include <functional>
+#include <memory>
+
+class DatabaseManager;
+
+/**
+ * @class SqlWorker
+ * @brief Owns a SQLite connection that lives on a dedicated worker thread.
+ *
+ * QSqlDatabase connections may only be used from the thread that created them,
+ * so the worker builds its own DatabaseManager inside the thread and runs every
+ * posted task there. Results are handed back through QFuture; attach a
+ * continuation with QFuture::then(context, ...) to consume them on the GUI thread.
+ */
+class SqlWorker
+{
+public:
+    explicit SqlWorker(const QString& connection_name);
+    ~SqlWorker();
+
+    SqlWorker(const SqlWorker&) = delete;
+    SqlWorker& operator=(const SqlWorker&) = delete;
+
+    /**
+     * @brief (Re)open the worker connection on the given database file
+     */
+    void open(const QString& db_path);
+
+    /**
+     * @brief Queue a task on the worker thread
+     */
+    void post(std::function<void(DatabaseManager&)> task);
+
+    /**
+     * @brief Queue a task and return a future that resolves with its result
+     */
+    template<typename T>
+    QFuture<T> run(std::function<T(DatabaseManager&)> task)
+    {
+        auto promise = std::make_shared<QPromise<T>>();
+        QFuture<T> future = promise->future();
+        promise->start();
+        post([promise, task](DatabaseManager& db) {
+            promise->addResult(task(db));
+            promise->finish();
+        });
+        return future;
+    }
+
+    QString connectionName() const { return m_connectionName; }
+
+private:
+    QString m_connectionName;
+    QThread m_thread;
+    QObject* m_context;
+    // created, used and destroyed on m_thread only
+    DatabaseManager* m_db;
+};
+
+#endif // SQLWORKER_H
@@ -1,75 +1,165 @@
 #include "taskmanger.h"
 #include <QDateTime>
-#include <QSet>
 namespace project{
 
-TaskManger::TaskManger(DbmPtr db, QObject *parent): db_(db)
+TaskManger::TaskManger(DbmPtr db, QObject *parent)
+    : SqlListModel(db, "tasks", {
+          bindRole<&TaskRecord::title>(TitleRole, "title"),
+          bindRole<&TaskRecord::timestamp>(TimestampRole, "time"),
+          bindRole<&TaskRecord::checked>(CheckBoxRole, "checked")
+      }, parent)
 {
     m_projectId = -1;
 }
 
-int TaskManger::rowCount(const QModelIndex &parent) const
+void TaskManger::refresh()
 {
-    if(m_projectId < 0) return 0;
-
-    QString sqlCmd= QString("SELECT id, title, timestamp FROM tasks WHERE project_id = %1 ORDER BY timestamp DESC").arg(m_projectId);
-    auto id_data = db_->queryRow(sqlCmd);
-
-    QSet<QString>timeStamps;
+    load(PageSize);
+}
 
-    record_map_.clear();
-    int index = 0;
-    for(int i = 0; i < id_data.size(); i+=3)
+void TaskManger::load(int limit)
+{
+    // results of an older request are dropped when they arrive late
+    const int generation = ++m_generation;
+    m_fetching = false;
+    if(m_projectId < 0)
     {
-        int j = i + 1;
-        int k = i + 2;
-        TaskRecord record;
-        record.index = index;
-        record.id = id_data.at(i).toInt();
-        record.data = id_data.at(j);
+        applyRows({}, PageSize);
+        return;
+    }
 
-        auto time = id_data.at(k);
+    m_loading = true;
+    // one extra row tells whether another page exists
+    db_->selectRowsAsync<TaskRecord, int, QString, QDateTime, QString>(
+           "SELECT id, title, timestamp, sort_key FROM tasks WHERE project_id = ? ORDER BY sort_key, id LIMIT ?",
+           {m_projectId, limit + 1})
+        .then(this, [this, generation, limit](QList<TaskRecord> rows) {
+            if(generation == m_generation)
+                applyRows(rows, limit);
+        });
+}
 
-        record.timestamp = QDateTime::fromString(time, Qt::ISODateWithMs);
+void TaskManger::applyRows(QList<TaskRecord> rows, int limit)
+{
+    m_loading = false;
+    m_hasMore = rows.size() > limit;
+    if(m_hasMore)
+        rows.removeLast();
+    setRows(rows);
+}
 
-        if(timeStamps.contains(time))
-        {
-            record.timestamp = record.timestamp.addMSecs(1);
-            updateTimestamp(record.id, record.timestamp);
-        }
+bool TaskManger::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && m_projectId >= 0 && m_hasMore && !m_loading && !m_fetching;
+}
 
+void TaskManger::fetchMore(const QModelIndex &parent)
+{
+    if(!canFetchMore(parent) || rows().isEmpty())
+        return;
 
-        timeStamps.insert(time);
+    // keyset pagination: continue after the last loaded row instead of using OFFSET
+    const int generation = m_generation;
+    const TaskRecord& last = rows().last();
+    m_fetching = true;
+    m_pageStale = false;
+    db_->selectRowsAsync<TaskRecord, int, QString, QDateTime, QString>(
+           "SELECT id, title, timestamp, sort_key FROM tasks WHERE project_id = ? AND (sort_key, id) > (?, ?) "
+           "ORDER BY sort_key, id LIMIT ?",
+           {m_projectId, last.sortKey, last.id, PageSize + 1})
+        .then(this, [this, generation](QList<TaskRecord> rows) {
+            if(generation != m_generation)
+                return;
+            m_fetching = false;
+            if(m_pageStale)
+            {
+                // read the page again from the current last row
+                fetchMore(QModelIndex());
+                return;
+            }
+            m_hasMore = rows.size() > PageSize;
+            if(m_hasMore)
+                rows.removeLast();
+            // rows inserted through the change feed meanwhile are skipped
+            appendRows(rows);
+        });
+}
 
-        // qInfo() << record.timestamp;
-        record.checked = false;
-        record_map_[index] = record;
-        ++index;
-    }
-    return record_map_.size();
+std::optional<TaskRecord> TaskManger::firstUnloaded(int except) const
+{
+    // keyset cursor: the last loaded row other than except
+    int last = rows().size() - 1;
+    if(last >= 0 && rows().at(last).id == except)
+        --last;
+
+    QList<TaskRecord> found;
+    if(last < 0)
+        found = db_->selectRows<TaskRecord, int, QString, QDateTime, QString>(
+            "SELECT id, title, timestamp, sort_key FROM tasks WHERE project_id = ? AND id != ? "
+            "ORDER BY sort_key, id LIMIT 1", {m_projectId, except});
+    else
+        found = db_->selectRows<TaskRecord, int, QString, QDateTime, QString>(
+            "SELECT id, title, timestamp, sort_key FROM tasks WHERE project_id = ? AND id != ? "
+            "AND (sort_key, id) > (?, ?) ORDER BY sort_key, id LIMIT 1",
+            {m_projectId, except, rows().at(last).sortKey, rows().at(last).id});
+    if(found.isEmpty())
+        return std::nullopt;
+    return found.first();
+}
 
+std::optional<TaskRecord> TaskManger::fetchRow(int id)
+{
+    const auto found = db_->selectRows<TaskRecord, int, QString, QDateTime, QString>(
+        "SELECT id, title, timestamp, sort_key FROM tasks WHERE id = ? AND project_id = ?", {id, m_projectId});
+    if(found.isEmpty())
+        return std::nullopt;
+    return found.first();
 }
 
-QVariant TaskManger::data(const QModelIndex &index, int role) const
+bool TaskManger::lessThan(const TaskRecord &a, const TaskRecord &b) const
 {
-    int row = index.row();
-    // qInfo() << " data row " << row;
-    if (!index.isValid() || m_projectId < 0)
-        return QVariant();
-    if(record_map_.find(row) == record_map_.end())
-        return QVariant();
-    if(role == CheckBoxRole)
-        return record_map_[row].checked;
-    return record_map_[row].data;
+    // same order as the SELECT
+    return std::make_pair(a.sortKey, a.id) < std::make_pair(b.sortKey, b.id);
 }
 
-QHash<int, QByteArray> TaskManger::roleNames() const
+void TaskManger::mergeRow(TaskRecord &current, const TaskRecord &fetched) const
 {
-    return {
-        { TitleRole,    "title" },
-        { TimestampRole,"time" },
-        { CheckBoxRole, "checked"}
-    };
+    const bool checked = current.checked;
+    current = fetched;
+    current.checked = checked;
+}
+
+void TaskManger::applyChange(const ChangeEvent &change)
+{
+    // a reload in flight may predate this change, so load again instead;
+    // as many rows as are loaded now, so later pages are not dropped
+    if(m_projectId < 0 || change.rowid < 0 || m_loading)
+    {
+        if(m_projectId >= 0)
+            load(std::max<int>(PageSize, rows().size()));
+        return;
+    }
+    if(m_fetching)
+        m_pageStale = true;
+
+    const int id = int(change.rowid);
+    std::optional<TaskRecord> task;
+    if(change.op != ChangeOp::Delete)
+        task = fetchRow(id);
+
+    // fetchMore() continues after the last loaded row, so a row sorting after
+    // the first unloaded one arrives with a later page instead
+    if(task && m_hasMore)
+    {
+        const auto next = firstUnloaded(id);
+        if(next && !lessThan(*task, *next))
+            task.reset();
+    }
+
+    if(task)
+        upsertRow(*task);
+    else
+        removeKey(id);
 }
 
 void TaskManger::addTask(const QString &text)
@@ -121,122 +211,137 @@ void TaskManger::addTask(const QString &text)
     //     qInfo() << sqlCmd;
     // }
 
-    auto query = db_->getBinder(
-        "INSERT INTO tasks (title, description, timestamp, pending, project_id) "
-        "VALUES (:title, :desc, :time, :pending, :pid)"
-        );
-
-    query.bindValue(":title", text);
-    query.bindValue(":desc", text);
-    query.bindValue(":time", timestampStr);
-    query.bindValue(":pending", pending);
-    query.bindValue(":pid", projectId);
-    query.exec();
+    // new tasks go on top of the list
+    const QString first = db_->selectValue<QString>("SELECT MIN(sort_key) FROM tasks WHERE project_id = ?",
+                                                    {projectId});
+    const QString sortKey = OrderKey::before(first);
 
-
-    emit layoutChanged();
+    // the new row reaches the model through the change feed
+    db_->insertRow("tasks", {"title", "description", "timestamp", "sort_key", "pending", "project_id"},
+                   {text, text, timestampStr, sortKey, pending, projectId});
 }
 
 void TaskManger::editTask(int index, const QString& title, const QString& description)
 {
-    if(record_map_.find(index) == record_map_.end()) return;
-
-
-
-    // 1. Prepare the statement with placeholders
-    auto query = db_->getBinder("UPDATE tasks SET title = :title, description = :desc WHERE id = :id");
-
-    // 2. Bind the actual values
-    query.bindValue(":title", title);
-    query.bindValue(":desc", description);
-    query.bindValue(":id", record_map_[index].id);
+    if(index < 0 || index >= rows().size()) return;
 
-    // 3. Execute the query
-    if(query.exec())
+    if(db_->updateRow("tasks", rows().at(index).id, {"title", "description"}, {title, description}))
     {
         setTaskDescription(description);
         // qInfo() << "[TaskManger] editTask success to update database " << title;
     }
     else
     {
-        qWarning() << "[TaskManger] editTask failed: " << query.lastError().text();
+        qWarning() << "[TaskManger] editTask failed for task" << rows().at(index).id;
     }
-
-    emit layoutChanged();
 }
 
 void TaskManger::deleteTasks()
 {
-    for(const auto& it: record_map_)
+    QList<int> ids;
+    for(const auto& record: rows())
     {
-        auto record = it.second;
         if(!record.checked)
             continue;
-        // qInfo() << "[TaskManger]: deleteTask " << record.index;
-        QString sqlCmd = QString("DELETE FROM tasks WHERE id = %1").arg(record.id);
-        db_->deleteItem(sqlCmd);
+        ids << record.id;
     }
 
-    emit layoutChanged();
+    // removed rows are taken out by the change feed
+    db_->deleteByIds("tasks", ids);
 }
 
 void TaskManger::updateCheckedBox(int index, bool value)
 {
-    record_map_[index].checked = value;
-    // for(const auto& it: record_map_)
-    //     if(it.second.checked)
-    //         qInfo() << "[TaskManger]: checked box index = " << it.second.index;
+    if(index < 0 || index >= rows().size())
+        return;
+    rowAt(index).checked = value;
 }
 
 void TaskManger::moveItem(int from, int to)
 {
-    //TODO swap timestamp and update database
+    if(from == to || from < 0 || to < 0 || from >= rows().size() || to >= rows().size())
+        return;
 
-    if(from == to)
+    QString sortKey = keyForMove(from, to);
+    if(sortKey.isEmpty())
+    {
+        // neighbours share a key (or predate the sort_key migration), spread them out first
+        rebalanceKeys();
+        sortKey = keyForMove(from, to);
+    }
+    if(sortKey.isEmpty())
         return;
 
-    int left = from;
-    int right = to;
-    if(left > right)
-        std::swap(left, right);
-
-    // Get timestamps from both records
-    auto timestampFrom = record_map_[left].timestamp;
-    auto timestampTo = record_map_[right].timestamp;
-    auto idFrom = record_map_[left].id;
-    auto idTo = record_map_[right].id;
-
-    // If timestamps are equal, slightly increase one to avoid conflicts
-    if (timestampFrom == timestampTo) {
-        // Add 1 millisecond to the 'to' timestamp
-        timestampTo = timestampTo.addMSecs(1);
+    // only the moved row changes; the change feed moves it in the model
+    if(!db_->updateRow("tasks", rows().at(from).id, {"sort_key"}, {sortKey}))
+        qWarning() << "[TaskManger] moveItem failed for task" << rows().at(from).id;
+}
+
+QString TaskManger::keyForMove(int from, int to) const
+{
+    // the row ends up at index `to`, between the rows that will surround it
+    const int below = from < to ? to : to - 1;
+    const int above = from < to ? to + 1 : to;
+    const QString lower = below >= 0 ? rows().at(below).sortKey : QString();
+    QString upper;
+    bool bounded = above < rows().size();
+    if(bounded)
+        upper = rows().at(above).sortKey;
+    else if(m_hasMore)
+    {
+        // dropped at the end of the page: stay before the rows not loaded yet
+        if(const auto next = firstUnloaded(rows().at(from).id))
+        {
+            upper = next->sortKey;
+            bounded = true;
+        }
     }
+    if((below >= 0 && !OrderKey::isValid(lower)) || (bounded && !OrderKey::isValid(upper)))
+        return QString();
+    return OrderKey::between(lower, upper);
+}
 
-    // Update first record
-    updateTimestamp(idFrom, timestampTo);
-    // Update second record
-    updateTimestamp(idTo, timestampFrom);
+void TaskManger::rebalanceKeys()
+{
+    // every task of the project, so the rows not loaded yet keep sorting after the page
+    QVariantList ids;
+    db_->forEachRow<int>("SELECT id FROM tasks WHERE project_id = ? ORDER BY sort_key, id", {m_projectId},
+                         [&ids](int id) { ids << id; });
+    const QStringList keys = OrderKey::sequence(ids.size());
+    QVariantList values;
+    QHash<int, QString> keyOf;
+    for(int i = 0; i < ids.size(); ++i)
+    {
+        values << keys.at(i);
+        keyOf.insert(ids.at(i).toInt(), keys.at(i));
+    }
+
+    DatabaseManager::Transaction transaction(*db_);
+    const auto query = db_->statement("UPDATE tasks SET sort_key = ? WHERE id = ?");
+    query->bindValue(0, values);
+    query->bindValue(1, ids);
+    if(!query->execBatch())
+    {
+        qWarning() << "[TaskManger] rebalanceKeys failed for project" << m_projectId << ":" << query->lastError().text();
+        return;
+    }
+    query->finish();
+    // one event for the whole project; listeners reload what they show
+    db_->notifyChange("tasks", -1, ChangeOp::Update);
+    if(!transaction.commit())
+        return;
 
-    emit layoutChanged();
+    // the display order does not change, so the cached keys are updated in place
+    // and keyForMove() can use them before the reload arrives
+    for(int i = 0; i < rows().size(); ++i)
+        rowAt(i).sortKey = keyOf.value(rows().at(i).id, rows().at(i).sortKey);
 }
 
 void TaskManger::projectIdChanged(int id)
 {
     m_projectId = id;
     // qInfo() << QString("project id updated = %1").arg(id);
-    emit layoutChanged();
-}
-
-void TaskManger::updateTimestamp(int id, const QDateTime &timestamp) const
-{
-    auto timeStr = timestamp.toString(Qt::ISODateWithMs);
-    // Update first record
-    auto fromQ = db_->getBinder("UPDATE tasks SET timestamp = :time WHERE id = :id");
-    fromQ.bindValue(":time", timeStr);
-    fromQ.bindValue(":id", id);
-    if (!fromQ.exec()) {
-        qWarning() << "[TaskManager] error updating from record:" << fromQ.lastError();
-    }
+    refresh();
 }
 
 int TaskManger::taskIndex() const
@@ -246,20 +351,14 @@ int TaskManger::taskIndex() const
 
 void TaskManger::setTaskIndex(int newTaskIndex)
 {
-    if (record_map_.find(newTaskIndex) == record_map_.end())
+    if (newTaskIndex < 0 || newTaskIndex >= rows().size())
         return;
     m_taskIndex = newTaskIndex;
 
-    // qInfo() << "[TaskManger] set task index " << m_taskIndex << " record id = " << record_map_[m_taskIndex].id;
-
     // read project description and update it
-    setTaskTitle(record_map_[m_taskIndex].data);
-    QString sqlCmd= QString("SELECT description FROM tasks WHERE id = %1").arg(record_map_[m_taskIndex].id);
-    for(const auto& des: db_->queryRow(sqlCmd))
-    {
-
-        setTaskDescription(des);
-    }
+    setTaskTitle(rows().at(m_taskIndex).title);
+    setTaskDescription(db_->selectValue<QString>("SELECT description FROM tasks WHERE id = ?",
+                                                 {rows().at(m_taskIndex).id}));
 
     emit taskIndexChanged();
 }
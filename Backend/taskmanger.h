@@ -3,13 +3,26 @@
 
 #include <QObject>
 #include <QDebug>
-#include <map>
+#include <algorithm>
 #include <QAbstractListModel>
+#include <QDateTime>
 #include "database.h"
+#include "orderkey.h"
+#include "sqllistmodel.h"
 
 
 namespace project{
-class TaskManger : public QAbstractListModel
+
+struct TaskRecord{
+    int id;
+    QString title;
+    QDateTime timestamp;
+    QString sortKey;
+    // view-only state, not stored in the database
+    bool checked = false;
+};
+
+class TaskManger : public SqlListModel<TaskRecord>
 {
     Q_OBJECT
     Q_PROPERTY(int taskIndex READ taskIndex WRITE setTaskIndex NOTIFY taskIndexChanged FINAL)
@@ -17,9 +30,9 @@ class TaskManger : public QAbstractListModel
     Q_PROPERTY(QString taskTitle READ taskTitle WRITE setTaskTitle NOTIFY taskTitleChanged FINAL)
 public:
     explicit TaskManger(DbmPtr db, QObject *parent = nullptr);
-    int rowCount(const QModelIndex &parent) const override;
-    QVariant data(const QModelIndex &index, int role) const override;
-    QHash<int, QByteArray> roleNames() const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
 
     Q_INVOKABLE void addTask(const QString& text);
     Q_INVOKABLE void editTask(int index, const QString& title, const QString& description);
@@ -46,21 +59,33 @@ signals:
 
     void taskTitleChanged();
 
+protected:
+    void refresh() override;
+    std::optional<TaskRecord> fetchRow(int id) override;
+    void applyChange(const ChangeEvent& change) override;
+    bool lessThan(const TaskRecord& a, const TaskRecord& b) const override;
+    void mergeRow(TaskRecord& current, const TaskRecord& fetched) const override;
+
 private:
-    DbmPtr db_;
     int m_projectId;
 
-    struct TaskRecord{
-        int index;
-        int id;
-        QString data;
-        QDateTime timestamp;
-        bool checked;
-    };
-
-    mutable std::map<int, TaskRecord> record_map_;
-
-    void updateTimestamp(int id, const QDateTime& timestamp) const;
+    // rows per keyset page; QML only shows a screenful at a time
+    static constexpr int PageSize = 100;
+
+    // loaded rows are ordered by (sort_key, id); later rows come with fetchMore()
+    int m_generation = 0;
+    bool m_loading = false;
+    bool m_fetching = false;
+    bool m_hasMore = false;
+    // a change arrived while a page was being read, so that page may be outdated
+    bool m_pageStale = false;
+
+    void load(int limit);
+    void applyRows(QList<TaskRecord> rows, int limit);
+    // first row after the loaded page, leaving out the row with id except
+    std::optional<TaskRecord> firstUnloaded(int except) const;
+    QString keyForMove(int from, int to) const;
+    void rebalanceKeys();
 
 
 
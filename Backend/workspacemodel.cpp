@@ -1,4 +1,5 @@
 #include "workspacemodel.h"
+#include "migrations.h"
 
 WorkspaceModel::WorkspaceModel(DbmPtr db, QObject *parent)
     : QAbstractTableModel{parent}, db_(db)
@@ -166,7 +167,7 @@ bool WorkspaceModel::createWorkspace(const QVariantMap &data)
     }
 
     // create database
-    if(!initializeDatabase(database))
+    if(!migrations::upgradeResearchDatabase(database))
     {
         qWarning() << "[WorkspaceModel] Failed to database: " << database;
         return false;
@@ -181,17 +182,12 @@ bool WorkspaceModel::createWorkspace(const QVariantMap &data)
 
     // Insert default categories
     QStringList defaultCategories = {"Research Projects", "Publications", "Presentations", "Grants & Funding", "Teaching", "Service"};
+    QList<QVariantList> rows;
     for (int i = 0; i < defaultCategories.size(); ++i) {
-        auto categoryQuery = researchDb.getBinder(
-            "INSERT INTO categories (id, name, year_id) VALUES (:id, :name, :year)"
-        );
-        categoryQuery.bindValue(":id", i + 1);
-        categoryQuery.bindValue(":name", defaultCategories[i]);
-        categoryQuery.bindValue(":year", 0); // year_id can be 0 for general categories
-        if (!categoryQuery.exec()) {
-            qWarning() << "[WorkspaceModel] Failed to insert default category:" << defaultCategories[i]
-                      << categoryQuery.lastError().text();
-        }
+        rows.append({i + 1, defaultCategories[i], 0}); // year_id can be 0 for general categories
+    }
+    if (!researchDb.insertBatch("categories", {"id", "name", "year_id"}, rows)) {
+        qWarning() << "[WorkspaceModel] Failed to insert default categories";
     }
 
     qInfo() << "[WorkspaceModel] Created" << defaultCategories.size() << "default categories for workspace";
@@ -330,6 +330,21 @@ Rectangle {
                     width: 40
                     height: 40
                 }
+
+                CheckBox {
+                    id: streamCheck
+                    text: "Stream response"
+                    checked: aiConfig.streaming
+                    anchors.verticalCenter: parent.verticalCenter
+                    onToggled: aiConfig.streaming = checked
+
+                    contentItem: Text {
+                        text: streamCheck.text
+                        color: "white"
+                        leftPadding: streamCheck.indicator.width + streamCheck.spacing
+                        verticalAlignment: Text.AlignVCenter
+                    }
+                }
             }
 
             // === Response Section ===
@@ -7,12 +7,13 @@ ColumnLayout {
     anchors.fill: parent
     
     // AI Rename result notification
+    property string lastRenamedPath: ""
+
     Connections {
         target: aiConfig
         function onPdfRenameCompleted(success, oldPath, newPath) {
             if (success) {
-                renameSuccessDialog.text = "File renamed successfully!\n\nNew name: " + newPath.split('/').pop()
-                renameSuccessDialog.open()
+                lastRenamedPath = newPath
                 // Refresh the file list
                 flModel.refresh()
             }
@@ -22,6 +23,21 @@ ColumnLayout {
             renameErrorDialog.open()
         }
     }
+
+    // one summary per batch instead of a dialog per file
+    Connections {
+        target: aiConfig.renameJob
+        function onFinished(renamed, failed) {
+            if (renamed === 1 && failed === 0) {
+                renameSuccessDialog.text = "File renamed successfully!\n\nNew name: " + lastRenamedPath.split('/').pop()
+                renameSuccessDialog.open()
+            } else if (renamed > 0) {
+                renameSuccessDialog.text = renamed + " files renamed" + (failed > 0 ? ", " + failed + " failed" : "")
+                renameSuccessDialog.open()
+            }
+            aiConfig.renameJob.clearFinished()
+        }
+    }
     
     // Success dialog
     MessageDialog {
@@ -358,6 +374,17 @@ ColumnLayout {
                 visible: contextMenu.currentIsDir
             }
 
+            MenuItem {
+                visible: contextMenu.currentIsDir
+                text: "🤖 AI Rename PDFs in Folder"
+                enabled: !aiConfig.isLoading
+                onTriggered: {
+                    if (contextMenu.currentFilePath) {
+                        aiConfig.renameFolderWithAi(contextMenu.currentFilePath)
+                    }
+                }
+            }
+
             MenuItem {
                 visible: contextMenu.currentIsDir
                 text: "Refresh Folder"
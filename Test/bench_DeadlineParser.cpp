@@ -0,0 +1,142 @@
+// Times DeadlineParser on a synthetic CFP page / mailing-list digest and prints JSON.
+//
+//   DeadlineParserBenchmark --megabytes 4 --iterations 10 --output deadline_parser.json
+//
+// The text mixes all supported date shapes with lines that carry no date,
+// the way a pasted web page does. Every result reports min/median/mean/max
+// wall time in milliseconds and the throughput in MB/s, sequential and chunked
+// over the global thread pool.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThreadPool>
+#include <algorithm>
+#include <cstdio>
+
+#include "../Backend/deadlineparser.h"
+
+namespace {
+
+// roughly bytes of "Event name <date>" lines with noise in between
+QString syntheticDigest(qint64 bytes)
+{
+    static const char* const events[] = {
+        "Paper Submission Deadline", "Abstract Registration", "Workshop proposals due",
+        "Notification of Acceptance", "Camera-ready papers", "Early registration ends"
+    };
+    static const char* const noise[] = {
+        "Please forward this call to interested colleagues.",
+        "All submissions must follow the IEEE double-column format, 8 pages max.",
+        "Room 204, Building 3 - see https://example.org/venue for directions",
+        ""
+    };
+    static const char* const months[] = {
+        "January", "Feb", "March", "Apr", "May", "June",
+        "Jul", "August", "Sept", "October", "Nov", "December"
+    };
+
+    QString text;
+    text.reserve(bytes + 256);
+    for (int i = 0; text.size() < bytes; ++i) {
+        const int day = i % 28 + 1;
+        const int month = i % 12;
+        const int year = 2024 + i % 3;
+        QString date;
+        switch (i % 3) {
+        case 0: date = QString("%1/%2/%3").arg(month + 1).arg(day).arg(year); break;
+        case 1: date = QString("%1 %2, %3").arg(months[month]).arg(day).arg(year); break;
+        default: date = QString("%1 %2 %3").arg(day).arg(months[month]).arg(year); break;
+        }
+        text += QString("  %1 %2 %3\n").arg(events[i % 6]).arg(i).arg(date);
+        text += noise[i % 4];
+        text += '\n';
+    }
+    return text;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("DeadlineParserBenchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmark DeadlineParser on a synthetic CFP digest");
+    parser.addHelpOption();
+    const QCommandLineOption megabytesOpt("megabytes", "Size of the pasted text.", "n", "4");
+    const QCommandLineOption iterationsOpt("iterations", "Iterations per benchmark.", "n", "10");
+    const QCommandLineOption outputOpt("output", "Write the JSON report to this file instead of stdout.", "file");
+    parser.addOptions({megabytesOpt, iterationsOpt, outputOpt});
+    parser.process(app);
+
+    const qint64 bytes = qMax<qint64>(1, parser.value(megabytesOpt).toLongLong()) * 1024 * 1024;
+    const int iterations = qMax(1, parser.value(iterationsOpt).toInt());
+    const QString text = syntheticDigest(bytes);
+
+    const double megabytes = text.size() * sizeof(QChar) / (1024.0 * 1024.0);
+
+    auto measure = [&](const QString& name, auto&& extract) {
+        QList<double> samples;
+        qsizetype deadlines = 0;
+        bool ok = false;
+        for (int i = 0; i < iterations; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            deadlines = extract(&ok).size();
+            samples << timer.nsecsElapsed() / 1e6;
+        }
+
+        std::sort(samples.begin(), samples.end());
+        double total = 0;
+        for (double s : samples)
+            total += s;
+
+        QJsonObject result;
+        result["name"] = name;
+        result["iterations"] = iterations;
+        result["deadlines"] = double(deadlines);
+        result["paired"] = ok;
+        result["min_ms"] = samples.first();
+        result["median_ms"] = samples.at(samples.size() / 2);
+        result["mean_ms"] = total / samples.size();
+        result["max_ms"] = samples.last();
+        result["mb_per_s"] = megabytes / (samples.at(samples.size() / 2) / 1000.0);
+        return result;
+    };
+
+    QJsonArray results;
+    results.append(measure("DeadlineParser.extract", [&](bool* ok) {
+        return DeadlineParser::extract(text, ok);
+    }));
+    results.append(measure("DeadlineParser.extractChunked", [&](bool* ok) {
+        return DeadlineParser::extractChunked(text, nullptr, ok);
+    }));
+
+    QJsonObject report;
+    report["benchmark"] = "deadline_parser";
+    report["qt_version"] = QString(qVersion());
+    report["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    report["text_mb"] = megabytes;
+    report["threads"] = QThreadPool::globalInstance()->maxThreadCount();
+    report["results"] = results;
+
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+    if (parser.isSet(outputOpt)) {
+        QFile file(parser.value(outputOpt));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            fprintf(stderr, "cannot write %s\n", qPrintable(parser.value(outputOpt)));
+            return 1;
+        }
+        file.write(json);
+    } else {
+        fwrite(json.constData(), 1, json.size(), stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,259 @@
+// Times the backend models against a synthetic workspace and prints JSON.
+//
+//   ModelBenchmark --projects 50 --tasks 200 --iterations 20 --output models.json
+//
+// Every result reports min/median/mean/p95/max wall time in milliseconds per
+// model operation, including the time the view needs to read all rows back.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <algorithm>
+#include <cstdio>
+
+#include "workspace_generator.h"
+#include "../Backend/database.h"
+#include "../Backend/homepage.h"
+#include "../Backend/taskmanger.h"
+#include "../Backend/linkviewer.h"
+#include "../Backend/deadlinemodel.h"
+#include "../Backend/calendarview.h"
+#include "../Backend/messageviewer.h"
+
+namespace {
+
+struct Result {
+    QString name;
+    QList<double> samples;
+    qint64 rows = 0;
+    int timeouts = 0;
+
+    QJsonObject toJson() const
+    {
+        QList<double> sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+        const int n = sorted.size();
+        double total = 0;
+        for (double s : sorted)
+            total += s;
+
+        QJsonObject obj;
+        obj["name"] = name;
+        obj["iterations"] = n;
+        obj["rows_per_iteration"] = n ? double(rows) / n : 0.0;
+        obj["timeouts"] = timeouts;
+        obj["min_ms"] = n ? sorted.first() : 0.0;
+        obj["median_ms"] = n ? sorted.at(n / 2) : 0.0;
+        obj["mean_ms"] = n ? total / n : 0.0;
+        obj["p95_ms"] = n ? sorted.at(qMin(n - 1, (n * 95) / 100)) : 0.0;
+        obj["max_ms"] = n ? sorted.last() : 0.0;
+        return obj;
+    }
+};
+
+// read every role of every cell once, like a view populating its delegates
+qint64 touchRows(const QAbstractItemModel& model)
+{
+    const auto roles = model.roleNames().keys();
+    const int rows = model.rowCount(QModelIndex());
+    const int columns = qMax(1, model.columnCount(QModelIndex()));
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < columns; ++c) {
+            const QModelIndex index = model.index(r, c);
+            for (int role : roles)
+                model.data(index, role);
+        }
+    }
+    return rows;
+}
+
+// the reloading models publish their rows asynchronously through modelReset
+template<typename Trigger>
+bool waitForReset(QAbstractItemModel& model, int timeoutMs, Trigger&& trigger)
+{
+    QEventLoop loop;
+    bool done = false;
+    auto connection = QObject::connect(&model, &QAbstractItemModel::modelReset, &loop, [&]() {
+        done = true;
+        loop.quit();
+    });
+    QTimer::singleShot(timeoutMs, &loop, &QEventLoop::quit);
+    trigger();
+    if (!done)
+        loop.exec();
+    QObject::disconnect(connection);
+    return done;
+}
+
+template<typename Fn>
+Result measure(const QString& name, int iterations, Fn&& fn)
+{
+    Result result;
+    result.name = name;
+    for (int i = 0; i < iterations; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        const qint64 rows = fn(i);
+        const double ms = timer.nsecsElapsed() / 1e6;
+        if (rows < 0) {
+            ++result.timeouts;
+            continue;
+        }
+        result.rows += rows;
+        result.samples << ms;
+    }
+    return result;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ModelBenchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmark the ResearchManager models on a synthetic workspace");
+    parser.addHelpOption();
+    const QCommandLineOption projectsOpt("projects", "Number of projects.", "n", "50");
+    const QCommandLineOption tasksOpt("tasks", "Tasks per project.", "n", "200");
+    const QCommandLineOption linksOpt("links", "Links per project.", "n", "40");
+    const QCommandLineOption eventsOpt("events", "Calendar events per project.", "n", "20");
+    const QCommandLineOption collabOpt("collaborators", "Collaborators per project.", "n", "5");
+    const QCommandLineOption iterationsOpt("iterations", "Iterations per benchmark.", "n", "20");
+    const QCommandLineOption outputOpt("output", "Write the JSON report to this file instead of stdout.", "file");
+    const QCommandLineOption keepOpt("keep", "Generate the workspace in this directory and keep it.", "dir");
+    const QCommandLineOption verboseOpt("verbose", "Keep the models' info/debug logging.");
+    parser.addOptions({projectsOpt, tasksOpt, linksOpt, eventsOpt, collabOpt,
+                       iterationsOpt, outputOpt, keepOpt, verboseOpt});
+    parser.process(app);
+
+    // the models log every row at info level, which would dominate the timings
+    if (!parser.isSet(verboseOpt))
+        QLoggingCategory::setFilterRules("*.debug=false\n*.info=false");
+
+    workspace_generator::Scale scale;
+    scale.projects = qMax(1, parser.value(projectsOpt).toInt());
+    scale.tasksPerProject = parser.value(tasksOpt).toInt();
+    scale.linksPerProject = parser.value(linksOpt).toInt();
+    scale.eventsPerProject = parser.value(eventsOpt).toInt();
+    scale.collaboratorsPerProject = qMax(1, parser.value(collabOpt).toInt());
+    const int iterations = qMax(1, parser.value(iterationsOpt).toInt());
+    const int timeoutMs = 30000;
+
+    QTemporaryDir tempDir;
+    const QString dir = parser.isSet(keepOpt) ? parser.value(keepOpt) : tempDir.path();
+    QDir().mkpath(dir);
+    const QString researchPath = dir + "/research.db";
+    const QString configPath = dir + "/common_config.db";
+    QFile::remove(researchPath);
+    QFile::remove(configPath);
+
+    QElapsedTimer generateTimer;
+    generateTimer.start();
+    if (!workspace_generator::generate(researchPath, configPath, scale)) {
+        fprintf(stderr, "failed to generate the synthetic workspace in %s\n", qPrintable(dir));
+        return 1;
+    }
+    const double generateMs = generateTimer.nsecsElapsed() / 1e6;
+
+    // same setup as ApplicationManager::setupDatabases()
+    auto db = std::make_shared<DatabaseManager>("research");
+    db->setStorageProfile(StorageProfile::Concurrent);
+    if (!db->connect(researchPath)) {
+        fprintf(stderr, "failed to open %s\n", qPrintable(researchPath));
+        return 1;
+    }
+    db->enableAsync();
+    db->stats().reset();
+
+    auto projectFor = [&](int i) { return i % scale.projects + 1; };
+    QList<Result> results;
+
+    {
+        homepage::ProjectView model(db);
+        results << measure("ProjectView.rowCount", iterations, [&](int) {
+            return touchRows(model);
+        });
+    }
+    {
+        project::TaskManger model(db);
+        results << measure("TaskManger.projectIdChanged", iterations, [&](int i) -> qint64 {
+            if (!waitForReset(model, timeoutMs, [&]() { model.projectIdChanged(projectFor(i)); }))
+                return -1;
+            return touchRows(model);
+        });
+    }
+    {
+        project::LinkViewer model(db);
+        results << measure("LinkViewer.projectIdChanged", iterations, [&](int i) {
+            model.projectIdChanged(projectFor(i));
+            return touchRows(model);
+        });
+    }
+    {
+        project::DeadlineModel model(db);
+        results << measure("DeadlineModel.projectIdChanged", iterations, [&](int i) -> qint64 {
+            if (!waitForReset(model, timeoutMs, [&]() { model.projectIdChanged(projectFor(i)); }))
+                return -1;
+            return touchRows(model);
+        });
+    }
+    {
+        project::CalendarView view(db);
+        results << measure("CalendarView.setMonth", iterations, [&](int i) {
+            view.setMonth(i % 12 + 1);
+            return qint64(view.daysInMonth());
+        });
+    }
+    {
+        collab::MessageViewer model(db);
+        results << measure("MessageViewer.setCurrentName", iterations, [&](int i) {
+            const QString name = workspace_generator::collaboratorName(i % scale.collaboratorsPerProject);
+            model.projectIdChanged(projectFor(i));
+            // setCurrentName() ignores an unchanged name
+            if (model.currentName() == name)
+                model.setCurrentName(QString());
+            model.setCurrentName(name);
+            return touchRows(model);
+        });
+    }
+
+    QJsonArray resultArray;
+    for (const auto& result : results)
+        resultArray.append(result.toJson());
+
+    QJsonObject report;
+    report["benchmark"] = "models";
+    report["qt_version"] = QString(qVersion());
+    report["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    report["scale"] = scale.toJson();
+    report["iterations"] = iterations;
+    report["generate_ms"] = generateMs;
+    report["results"] = resultArray;
+    report["sql"] = db->stats().toJson();
+
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+    if (parser.isSet(outputOpt)) {
+        QFile file(parser.value(outputOpt));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            fprintf(stderr, "cannot write %s\n", qPrintable(parser.value(outputOpt)));
+            return 1;
+        }
+        file.write(json);
+    } else {
+        fwrite(json.constData(), 1, json.size(), stdout);
+    }
+
+    db.reset();
+    QSqlDatabase::removeDatabase("research");
+    return 0;
+}
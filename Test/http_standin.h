@@ -0,0 +1,121 @@
+#ifndef HTTP_STANDIN_H
+#define HTTP_STANDIN_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <functional>
+#include "../Backend/database.h"
+
+/**
+ * @brief One request as read by HttpStandIn: request line, headers and body.
+ */
+struct StandInRequest {
+    QByteArray method;
+    QByteArray path;
+    QByteArray head;    // request line and headers, without the blank line
+    QByteArray body;    // Content-Length bytes after the blank line
+
+    /**
+     * @brief Value of the first header called name (any case), empty if there is none
+     */
+    QByteArray header(QByteArrayView name) const
+    {
+        const QList<QByteArray> lines = head.split('\n');
+        for (int i = 1; i < lines.size(); ++i) {
+            const int colon = lines.at(i).indexOf(':');
+            if (colon > 0 && lines.at(i).left(colon).trimmed().compare(name, Qt::CaseInsensitive) == 0)
+                return lines.at(i).mid(colon + 1).trimmed();
+        }
+        return QByteArray();
+    }
+};
+
+/**
+ * @brief Local HTTP/1.1 server standing in for remote sites and APIs in tests.
+ *
+ * Each connection carries one request. Once its headers and Content-Length
+ * bytes of body have arrived, respond() is called with the socket; it may
+ * answer right away with reply(), later from a timer, or never.
+ */
+class HttpStandIn : public QObject
+{
+public:
+    using Responder = std::function<void(QTcpSocket* socket, const StandInRequest& request)>;
+
+    Responder respond;
+    int requestCount = 0;
+
+    explicit HttpStandIn(Responder responder = Responder())
+        : respond(std::move(responder))
+    {
+        m_server.listen(QHostAddress::LocalHost);
+        connect(&m_server, &QTcpServer::newConnection, this, [this]() {
+            while (QTcpSocket* socket = m_server.nextPendingConnection())
+                connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { read(socket); });
+        });
+    }
+
+    quint16 port() const { return m_server.serverPort(); }
+
+    QString url(const QString& path = "/page") const
+    {
+        return QString("http://127.0.0.1:%1%2").arg(port()).arg(path);
+    }
+
+    /**
+     * @brief Send a complete response and close the connection
+     * @param headers extra header lines, each ending in "\r\n"
+     */
+    static void reply(QTcpSocket* socket, const QByteArray& status, const QByteArray& body = QByteArray(),
+                      const QByteArray& headers = QByteArray())
+    {
+        socket->write("HTTP/1.1 " + status + "\r\nConnection: close\r\nContent-Length: "
+                      + QByteArray::number(body.size()) + "\r\n" + headers + "\r\n" + body);
+        socket->disconnectFromHost();
+    }
+
+private:
+    QTcpServer m_server;
+    QHash<QTcpSocket*, QByteArray> m_requests;
+
+    void read(QTcpSocket* socket)
+    {
+        QByteArray& data = m_requests[socket];
+        data += socket->readAll();
+        const int headerEnd = data.indexOf("\r\n\r\n");
+        if (headerEnd < 0 || socket->property("answered").toBool())
+            return;
+
+        StandInRequest request;
+        request.head = data.left(headerEnd);
+        const qsizetype bodySize = request.header("Content-Length").toLongLong();
+        if (data.size() < headerEnd + 4 + bodySize)
+            return;
+
+        const QList<QByteArray> line = request.head.left(request.head.indexOf("\r\n")).split(' ');
+        request.method = line.value(0);
+        request.path = line.value(1);
+        request.body = data.mid(headerEnd + 4, bodySize);
+        socket->setProperty("answered", true);
+        ++requestCount;
+        if (respond)
+            respond(socket, request);
+    }
+};
+
+/**
+ * @brief Throwaway in-memory database with the schema of migrations,
+ *        under its own connection name so a test can open several
+ */
+inline DbmPtr openInMemory(const QString& name, const QList<Migration>& migrations)
+{
+    auto db = std::make_shared<DatabaseManager>(name);
+    db->connect(":memory:");
+    db->migrate(migrations);
+    return db;
+}
+
+#endif // HTTP_STANDIN_H
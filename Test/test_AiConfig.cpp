@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QNetworkProxy>
+#include <QSignalSpy>
+#include <QTimer>
+#include "../Backend/aiconfig.h"
+#include "../Backend/migrations.h"
+#include "http_standin.h"
+
+namespace {
+
+// Stand-in for both Gemini endpoints. streamGenerateContent sends the chunks
+// as server-sent events, 100 ms apart; generateContent answers with all of
+// them at once. With reject set, every request gets a 400 API error.
+class GeminiStandIn : public HttpStandIn
+{
+public:
+    QStringList paths;
+    QStringList chunks{"Hel", "lo ", "there!"};
+    bool reject = false;
+
+    GeminiStandIn()
+    {
+        respond = [this](QTcpSocket* socket, const StandInRequest& request) { answer(socket, request); };
+    }
+
+    QUrl endpoint() const
+    {
+        return QUrl(url("/v1beta"));
+    }
+
+private:
+    static QByteArray chunk(const QString& text)
+    {
+        return R"({"candidates":[{"content":{"parts":[{"text":")" + text.toUtf8() + R"("}],"role":"model"}}]})";
+    }
+
+    void answer(QTcpSocket* socket, const StandInRequest& request)
+    {
+        const QByteArray& path = request.path;
+        paths << QString(path);
+
+        if (reject) {
+            reply(socket, "400 Bad Request", R"({"error":{"code":400,"message":"API key not valid"}})",
+                  "Content-Type: application/json\r\n");
+            return;
+        }
+
+        if (path.contains(":streamGenerateContent")) {
+            // no Content-Length, the body ends when the connection closes
+            socket->write("HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Type: text/event-stream\r\n\r\n");
+            for (int i = 0; i < chunks.size(); ++i) {
+                QTimer::singleShot(100 * i, socket, [this, socket, i]() {
+                    socket->write(": keep-alive\r\ndata: " + chunk(chunks.at(i)) + "\r\n\r\n");
+                    socket->flush();
+                    if (i == chunks.size() - 1)
+                        socket->disconnectFromHost();
+                });
+            }
+            return;
+        }
+
+        reply(socket, "200 OK", chunk(chunks.join(QString())), "Content-Type: application/json\r\n");
+    }
+};
+
+}
+
+TEST(AiConfig, SseParser) {
+    const QByteArray stream = ": comment\r\n"
+                              "data: {\"a\":1}\r\n"
+                              "\r\n"
+                              "event: message\n"
+                              "data: first line\n"
+                              "data:second line\n"
+                              "\n"
+                              "data: unterminated";
+
+    // byte by byte, every split point has to work
+    gemini::SseParser parser;
+    QList<QByteArray> events;
+    for (char byte : stream)
+        events += parser.feed(QByteArrayView(&byte, 1));
+    events += parser.finish();
+    ASSERT_EQ(events, (QList<QByteArray>{"{\"a\":1}", "first line\nsecond line", "unterminated"}));
+
+    // all at once
+    gemini::SseParser whole;
+    ASSERT_EQ(whole.feed(stream).size(), 2);
+    ASSERT_EQ(whole.finish(), QList<QByteArray>{"unterminated"});
+
+    QString error;
+    ASSERT_EQ(gemini::chunkText(R"({"candidates":[{"content":{"parts":[{"text":"a"},{"text":"b"}]}}]})", &error), "ab");
+    ASSERT_TRUE(gemini::chunkText(R"({"candidates":[{"finishReason":"STOP"}]})", &error).isEmpty());
+    ASSERT_TRUE(error.isEmpty());
+    gemini::chunkText(R"({"error":{"message":"quota"}})", &error);
+    ASSERT_EQ(error, "API Error: quota");
+}
+
+TEST(AiConfig, StreamsTestResponse) {
+    GeminiStandIn server;
+    AiConfig config(openInMemory("aiStream", migrations::config()));
+    config.setEndpoint(server.endpoint());
+    config.setGeminiApiKey("test-key");
+    ASSERT_TRUE(config.streaming());
+
+    // what the panel shows each time the response grows
+    QStringList shown;
+    QList<bool> loading;
+    QObject::connect(&config, &AiConfig::testResponseChanged, [&]() {
+        shown << config.testResponse();
+        loading << config.isLoading();
+    });
+    QSignalSpy completed(&config, &AiConfig::testCompleted);
+
+    config.testGemini("Say hello");
+    ASSERT_TRUE(completed.wait(5000));
+    ASSERT_TRUE(completed.first().at(0).toBool());
+    ASSERT_EQ(config.testResponse(), "Hello there!");
+
+    // the first token shows while the answer is still being generated
+    ASSERT_GE(shown.size(), 3);
+    ASSERT_EQ(shown.first(), "Hel");
+    ASSERT_TRUE(loading.first());
+    ASSERT_EQ(shown.at(1), "Hello ");
+    ASSERT_FALSE(config.isLoading());
+    ASSERT_EQ(server.paths.first(), "/v1beta/models/gemini-2.5-flash:streamGenerateContent?alt=sse");
+}
+
+TEST(AiConfig, StreamError) {
+    GeminiStandIn server;
+    server.reject = true;
+    AiConfig config(openInMemory("aiStreamError", migrations::config()));
+    config.setEndpoint(server.endpoint());
+    config.setGeminiApiKey("test-key");
+    QSignalSpy completed(&config, &AiConfig::testCompleted);
+
+    config.testGemini("Say hello");
+    ASSERT_TRUE(completed.wait(5000));
+    ASSERT_FALSE(completed.first().at(0).toBool());
+    ASSERT_EQ(config.testResponse(), "API Error: API key not valid");
+}
+
+TEST(AiConfig, WithoutStreaming) {
+    GeminiStandIn server;
+    AiConfig config(openInMemory("aiNoStream", migrations::config()));
+    config.setEndpoint(server.endpoint());
+    config.setGeminiApiKey("test-key");
+    config.setStreaming(false);
+    QSignalSpy changed(&config, &AiConfig::testResponseChanged);
+    QSignalSpy completed(&config, &AiConfig::testCompleted);
+
+    config.testGemini("Say hello");
+    ASSERT_TRUE(completed.wait(5000));
+    ASSERT_EQ(config.testResponse(), "Hello there!");
+    ASSERT_EQ(changed.count(), 1);
+    ASSERT_EQ(server.paths.first(), "/v1beta/models/gemini-2.5-flash:generateContent");
+}
+
+TEST(AiConfig, RepeatedPromptFromCache) {
+    GeminiStandIn server;
+    AiConfig config(openInMemory("aiCached", migrations::config()));
+    config.setEndpoint(server.endpoint());
+    config.setGeminiApiKey("test-key");
+    QSignalSpy completed(&config, &AiConfig::testCompleted);
+
+    config.testGemini("Say hello");
+    ASSERT_TRUE(completed.wait(5000));
+
+    // answered before testGemini returns, nothing is sent
+    config.testGemini("Say hello");
+    ASSERT_EQ(completed.count(), 2);
+    ASSERT_EQ(completed.last().at(1).toString(), "Hello there!");
+    ASSERT_EQ(server.paths.size(), 1);
+
+    config.clearResponseCache();
+    config.testGemini("Say hello");
+    ASSERT_TRUE(completed.wait(5000));
+    ASSERT_EQ(server.paths.size(), 2);
+}
+
+
+// Custom main that initializes Qt before running tests
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    // the stand-in server is local, never go through a proxy
+    QNetworkProxy::setApplicationProxy(QNetworkProxy::NoProxy);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,218 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QNetworkProxy>
+#include <QSignalSpy>
+#include <QTest>
+#include <QTimer>
+#include "../Backend/airequestscheduler.h"
+#include "http_standin.h"
+
+using project::AiRequestScheduler;
+
+namespace {
+
+// HTTP stand-in that answers every POST with its own body. Bodies starting
+// with a keyword change the answer:
+//   "slow ..."   answered after 100 ms
+//   "quota ..."  429 with Retry-After: 1 the first time
+//   "stream ..." three chunks 100 ms apart, then the connection closes
+class StandInServer : public HttpStandIn
+{
+public:
+    // bodies in the order they arrived, with the time since construction
+    QStringList bodies;
+    QList<qint64> arrivals;
+    QHash<QString, int> calls;
+
+    StandInServer()
+    {
+        m_clock.start();
+        respond = [this](QTcpSocket* socket, const StandInRequest& request) {
+            answer(socket, QString::fromUtf8(request.body));
+        };
+    }
+
+    QNetworkRequest request() const
+    {
+        QNetworkRequest request(QUrl(url("/v1beta/models/m:generateContent")));
+        request.setHeader(QNetworkRequest::ContentTypeHeader, "text/plain");
+        request.setRawHeader("x-goog-api-key", "test-key");
+        return request;
+    }
+
+    qint64 elapsed() const { return m_clock.elapsed(); }
+
+private:
+    QElapsedTimer m_clock;
+
+    void answer(QTcpSocket* socket, const QString& body)
+    {
+        bodies << body;
+        arrivals << m_clock.elapsed();
+        const int call = ++calls[body];
+
+        if (body.startsWith("slow")) {
+            QTimer::singleShot(100, socket, [socket, body]() { reply(socket, "200 OK", body.toUtf8()); });
+        } else if (body.startsWith("quota") && call == 1) {
+            reply(socket, "429 Too Many Requests", "{}", "Retry-After: 1\r\n");
+        } else if (body.startsWith("stream")) {
+            socket->write("HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Type: text/event-stream\r\n\r\n");
+            for (int i = 0; i < 3; ++i) {
+                QTimer::singleShot(100 * i, socket, [socket, i]() {
+                    socket->write("part" + QByteArray::number(i) + ";");
+                    socket->flush();
+                    if (i == 2)
+                        socket->disconnectFromHost();
+                });
+            }
+        } else {
+            reply(socket, "200 OK", body.toUtf8());
+        }
+    }
+};
+
+}
+
+TEST(AiRequestScheduler, TokenBucket) {
+    StandInServer server;
+    AiRequestScheduler scheduler(nullptr);
+    // ten per second, two at once
+    scheduler.setRateLimit(600, 2);
+    scheduler.setMaxConcurrent(8);
+
+    int done = 0;
+    for (int i = 0; i < 5; ++i) {
+        scheduler.submit(server.request(), QByteArray("request ") + QByteArray::number(i),
+                         AiRequestScheduler::Batch, [&done](const AiRequestScheduler::Response& response) {
+            ASSERT_TRUE(response.ok());
+            ++done;
+        });
+    }
+    ASSERT_TRUE(QTest::qWaitFor([&done]() { return done == 5; }, 5000));
+
+    // the burst goes at once, the other three wait 100 ms for a token each
+    ASSERT_LT(server.arrivals.at(1) - server.arrivals.at(0), 80);
+    ASSERT_GE(server.arrivals.at(4) - server.arrivals.at(0), 250);
+}
+
+TEST(AiRequestScheduler, MergesIdenticalRequests) {
+    StandInServer server;
+    AiRequestScheduler scheduler(nullptr);
+    scheduler.setRateLimit(60000, 100);
+
+    QStringList answers;
+    auto collect = [&answers](const AiRequestScheduler::Response& response) {
+        answers << QString::fromUtf8(response.body);
+    };
+    scheduler.submit(server.request(), "slow same", AiRequestScheduler::Batch, collect);
+    scheduler.submit(server.request(), "slow same", AiRequestScheduler::Batch, collect);
+    scheduler.submit(server.request(), "slow same", AiRequestScheduler::Interactive, collect);
+    scheduler.submit(server.request(), "slow other", AiRequestScheduler::Batch, collect);
+    ASSERT_TRUE(QTest::qWaitFor([&answers]() { return answers.size() == 4; }, 5000));
+
+    ASSERT_EQ(server.bodies.size(), 2);
+    ASSERT_EQ(answers.count("slow same"), 3);
+    ASSERT_EQ(answers.count("slow other"), 1);
+
+    // only in-flight requests are merged, a later one is sent again
+    scheduler.submit(server.request(), "slow same", AiRequestScheduler::Batch, collect);
+    ASSERT_TRUE(QTest::qWaitFor([&answers]() { return answers.size() == 5; }, 5000));
+    ASSERT_EQ(server.bodies.size(), 3);
+}
+
+TEST(AiRequestScheduler, InteractiveFirst) {
+    StandInServer server;
+    AiRequestScheduler scheduler(nullptr);
+    scheduler.setRateLimit(60000, 100);
+    scheduler.setMaxConcurrent(1);
+
+    int done = 0;
+    auto count = [&done](const AiRequestScheduler::Response&) { ++done; };
+    scheduler.submit(server.request(), "slow batch 1", AiRequestScheduler::Batch, count);
+    scheduler.submit(server.request(), "slow batch 2", AiRequestScheduler::Batch, count);
+    scheduler.submit(server.request(), "slow batch 3", AiRequestScheduler::Batch, count);
+    scheduler.submit(server.request(), "slow test prompt", AiRequestScheduler::Interactive, count);
+    ASSERT_EQ(scheduler.activeCount(), 1);
+    ASSERT_EQ(scheduler.queuedCount(), 3);
+    ASSERT_TRUE(QTest::qWaitFor([&done]() { return done == 4; }, 5000));
+
+    ASSERT_EQ(server.bodies, (QStringList{"slow batch 1", "slow test prompt", "slow batch 2", "slow batch 3"}));
+}
+
+TEST(AiRequestScheduler, HonorsRetryAfter) {
+    StandInServer server;
+    AiRequestScheduler scheduler(nullptr);
+    scheduler.setRateLimit(60000, 100);
+    scheduler.setRetryDelay(10);
+    QSignalSpy limited(&scheduler, &AiRequestScheduler::rateLimited);
+
+    AiRequestScheduler::Response quota;
+    AiRequestScheduler::Response other;
+    bool quotaDone = false;
+    bool otherDone = false;
+    scheduler.submit(server.request(), "quota", AiRequestScheduler::Batch,
+                     [&](const AiRequestScheduler::Response& response) { quota = response; quotaDone = true; });
+    ASSERT_TRUE(limited.wait(5000));
+    ASSERT_EQ(limited.first().at(0).toInt(), 1000);
+
+    // the provider said to wait, so does everything else
+    const qint64 limitedAt = server.elapsed();
+    scheduler.submit(server.request(), "other", AiRequestScheduler::Interactive,
+                     [&](const AiRequestScheduler::Response& response) { other = response; otherDone = true; });
+    ASSERT_TRUE(QTest::qWaitFor([&]() { return quotaDone && otherDone; }, 5000));
+
+    ASSERT_TRUE(quota.ok());
+    ASSERT_EQ(quota.attempts, 2);
+    ASSERT_TRUE(other.ok());
+    ASSERT_EQ(server.bodies.size(), 3);
+    ASSERT_EQ(server.bodies.first(), "quota");
+    ASSERT_TRUE(server.bodies.mid(1).contains("other"));
+    ASSERT_GE(server.arrivals.at(1) - limitedAt, 900);
+    ASSERT_GE(server.arrivals.at(2) - limitedAt, 900);
+}
+
+TEST(AiRequestScheduler, StreamsAndCancels) {
+    StandInServer server;
+    AiRequestScheduler scheduler(nullptr);
+    scheduler.setRateLimit(60000, 100);
+
+    QByteArray streamed;
+    bool firstBeforeDone = false;
+    bool done = false;
+    scheduler.submit(server.request(), "stream", AiRequestScheduler::Interactive,
+                     [&](const AiRequestScheduler::Response& response) {
+                         ASSERT_TRUE(response.ok());
+                         streamed += response.body;
+                         done = true;
+                     },
+                     [&](QByteArrayView chunk) {
+                         if (streamed.isEmpty())
+                             firstBeforeDone = !done;
+                         streamed += chunk;
+                     });
+    ASSERT_TRUE(QTest::qWaitFor([&done]() { return done; }, 5000));
+    ASSERT_TRUE(firstBeforeDone);
+    ASSERT_EQ(streamed, "part0;part1;part2;");
+
+    // a cancelled request never calls back
+    bool called = false;
+    const int id = scheduler.submit(server.request(), "slow cancelled", AiRequestScheduler::Batch,
+                                    [&called](const AiRequestScheduler::Response&) { called = true; });
+    scheduler.cancel(id);
+    QTest::qWait(200);
+    ASSERT_FALSE(called);
+    ASSERT_EQ(scheduler.activeCount(), 0);
+    ASSERT_EQ(scheduler.queuedCount(), 0);
+}
+
+
+// Custom main that initializes Qt before running tests
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    // the stand-in server is local, never go through a proxy
+    QNetworkProxy::setApplicationProxy(QNetworkProxy::NoProxy);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include "../Backend/airesponsecache.h"
+#include "../Backend/migrations.h"
+#include "http_standin.h"
+
+using project::AiResponseCache;
+
+TEST(AiResponseCache, Key) {
+    const QString key = AiResponseCache::key("gemini-2.5-flash", "Rename this", "Attention is all you need");
+    ASSERT_EQ(key.size(), 64);
+    ASSERT_EQ(key, AiResponseCache::key("gemini-2.5-flash", "Rename this", "Attention is all you need"));
+    // every part counts, and parts do not run into each other
+    ASSERT_NE(key, AiResponseCache::key("gemini-2.5-pro", "Rename this", "Attention is all you need"));
+    ASSERT_NE(key, AiResponseCache::key("gemini-2.5-flash", "Rename that", "Attention is all you need"));
+    ASSERT_NE(AiResponseCache::key("m", "ab", "c"), AiResponseCache::key("m", "a", "bc"));
+}
+
+TEST(AiResponseCache, StoreAndLookup) {
+    auto db = openInMemory("aiCacheLookup", migrations::config());
+    AiResponseCache cache(db);
+    const QString key = AiResponseCache::key("model", "prompt", "text");
+
+    ASSERT_TRUE(cache.lookup(key).isNull());
+    cache.store(key, "model", "Vaswani 2017 - Attention.pdf");
+    ASSERT_EQ(cache.lookup(key), "Vaswani 2017 - Attention.pdf");
+    ASSERT_EQ(cache.hits(), 1);
+    ASSERT_EQ(cache.misses(), 1);
+
+    // empty answers are not worth keeping
+    cache.store(AiResponseCache::key("model", "prompt", "other"), "model", "");
+    ASSERT_EQ(cache.count(), 1);
+
+    // persistent: a new cache on the same database sees the answer
+    AiResponseCache reopened(db);
+    ASSERT_EQ(reopened.lookup(key), "Vaswani 2017 - Attention.pdf");
+
+    cache.clear();
+    ASSERT_TRUE(cache.lookup(key).isNull());
+}
+
+TEST(AiResponseCache, EvictsLeastRecentlyUsed) {
+    auto db = openInMemory("aiCacheEntries", migrations::config());
+    AiResponseCache cache(db);
+    cache.setMaxEntries(3);
+
+    cache.store("a", "model", "answer a");
+    cache.store("b", "model", "answer b");
+    cache.store("c", "model", "answer c");
+    // a is used again, b is now the oldest
+    ASSERT_FALSE(cache.lookup("a").isNull());
+    cache.store("d", "model", "answer d");
+
+    ASSERT_EQ(cache.count(), 3);
+    ASSERT_TRUE(cache.lookup("b").isNull());
+    ASSERT_FALSE(cache.lookup("a").isNull());
+    ASSERT_FALSE(cache.lookup("c").isNull());
+    ASSERT_FALSE(cache.lookup("d").isNull());
+
+    cache.setMaxEntries(1);
+    ASSERT_EQ(cache.count(), 1);
+    ASSERT_FALSE(cache.lookup("d").isNull());
+}
+
+TEST(AiResponseCache, EvictsBeyondByteBound) {
+    auto db = openInMemory("aiCacheBytes", migrations::config());
+    AiResponseCache cache(db);
+    cache.setMaxBytes(25);
+
+    cache.store("a", "model", QString(10, 'a'));
+    cache.store("b", "model", QString(10, 'b'));
+    ASSERT_EQ(cache.totalBytes(), 20);
+    ASSERT_FALSE(cache.lookup("a").isNull());
+
+    // 30 bytes would be too many, b was used least recently
+    cache.store("c", "model", QString(10, 'c'));
+    ASSERT_EQ(cache.totalBytes(), 20);
+    ASSERT_TRUE(cache.lookup("b").isNull());
+    ASSERT_FALSE(cache.lookup("a").isNull());
+
+    // an answer larger than the bound is not kept, and pushes nothing out
+    cache.store("big", "model", QString(40, 'x'));
+    ASSERT_TRUE(cache.lookup("big").isNull());
+    ASSERT_EQ(cache.count(), 2);
+}
+
+
+// Custom main that initializes Qt before running tests
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
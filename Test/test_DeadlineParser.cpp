@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <QCoreApplication>
 #include <QDebug>
+#include <QThreadPool>
 #include "../Backend/deadlineparser.h"
 
 
@@ -9,6 +10,8 @@ TEST(DeadlineParser, InputParsing) {
     QString newDeadlineTxt = "01/30/2026 new submission deadline";
     auto result = DeadlineParser::parseDeadlines(newDeadlineTxt);
     qInfo() << result.first;
+    ASSERT_EQ(result.second, ParserState::FINISH);
+    ASSERT_EQ(result.first, R"([{"date":"2026-01-30","event":"new submission deadline"}])");
 }
 
 
@@ -23,6 +26,123 @@ TEST(DeadlineParser, MultipleInputsParsing) {
 
     auto result = DeadlineParser::parseDeadlines(newDeadlineTxt);
     qInfo() << result.first;
+    ASSERT_EQ(result.second, ParserState::FINISH);
+
+    bool ok = false;
+    const auto deadlines = DeadlineParser::parse(newDeadlineTxt, &ok);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(deadlines.size(), 7);
+    ASSERT_EQ(deadlines.first().date, QDate(2024, 7, 15));
+    ASSERT_EQ(deadlines.first().event, "Paper Submission Opens");
+    ASSERT_EQ(deadlines.last().date, QDate(2025, 3, 6));
+    ASSERT_EQ(deadlines.last().event, "Submission of final papers");
+}
+
+
+TEST(DeadlineParser, DateShapes) {
+    auto lex = [](const QString& text) {
+        qsizetype end = -1;
+        const QDate date = DeadlineParser::lexDate(text, 0, &end);
+        return date.isValid() && end == text.size() ? date : QDate();
+    };
+    ASSERT_EQ(lex("1/30/2026"), QDate(2026, 1, 30));
+    ASSERT_EQ(lex("01/30/26"), QDate(2026, 1, 30));
+    ASSERT_EQ(lex("September 15, 2024"), QDate(2024, 9, 15));
+    ASSERT_EQ(lex("sep 15 2024"), QDate(2024, 9, 15));
+    ASSERT_EQ(lex("Sept 5, 2024"), QDate(2024, 9, 5));
+    ASSERT_EQ(lex("15 September 2024"), QDate(2024, 9, 15));
+    ASSERT_EQ(lex(QString("15") + QChar(0x00A0) + "Dec, 2024"), QDate(2024, 12, 15));
+
+    // not dates
+    ASSERT_FALSE(lex("13/01/2024").isValid());
+    ASSERT_FALSE(lex("February 30, 2024").isValid());
+    ASSERT_FALSE(lex("Deadline 15, 2024").isValid());
+    ASSERT_FALSE(lex("15 Septembers 2024").isValid());
+    ASSERT_FALSE(lex("1/2/345").isValid());
+    ASSERT_FALSE(lex("15 September 20245").isValid());
+}
+
+
+TEST(DeadlineParser, DateFirstAndNoise) {
+    const QString text = "Important dates\n"
+                         "May 1, 2025: abstracts due\n"
+                         "  (anywhere on earth)\n"
+                         "3 June 2025 full papers\n"
+                         "\n"
+                         "Questions? Write to the chairs.";
+    bool ok = false;
+    const auto deadlines = DeadlineParser::extract(text, &ok);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(deadlines.size(), 2);
+    ASSERT_EQ(deadlines.at(0).date, QDate(2025, 5, 1));
+    ASSERT_EQ(deadlines.at(0).event, "abstracts due");
+    ASSERT_EQ(deadlines.at(1).date, QDate(2025, 6, 3));
+    ASSERT_EQ(deadlines.at(1).event, "full papers");
+}
+
+
+TEST(DeadlineParser, InvalidText) {
+    auto result = DeadlineParser::parseDeadlines("no dates in here");
+    ASSERT_EQ(result.second, ParserState::PROMPT_USER);
+    ASSERT_TRUE(result.first.startsWith("[INVALID TEXT]"));
+
+    // two dates without an event between them
+    bool ok = true;
+    DeadlineParser::extract(QString("Deadline 1/2/2025 3/4/2025"), &ok);
+    ASSERT_FALSE(ok);
+}
+
+
+TEST(DeadlineParser, JsonRoundTrip) {
+    auto result = DeadlineParser::parseDeadlines("Kickoff 15 July 2024\nReview March 3, 2025");
+    ASSERT_EQ(result.second, ParserState::FINISH);
+
+    auto again = DeadlineParser::parseDeadlines(result.first);
+    ASSERT_EQ(again.second, ParserState::FINISH);
+    ASSERT_EQ(again.first, result.first);
+}
+
+
+TEST(DeadlineParser, ChunkedMatchesSequential) {
+    QString text;
+    for (int i = 0; i < 500; ++i) {
+        // date first, the event continues on the next line
+        text += QString("%1 March %2 milestone %3\n").arg(i % 28 + 1).arg(2024 + i % 3).arg(i);
+        text += "  part two " + QString::number(i) + " 1/1/2025 review\n";
+        if (i % 7 == 0)
+            text += "no date on this line\n";
+    }
+
+    bool sequentialOk = false;
+    const auto sequential = DeadlineParser::extract(text, &sequentialOk);
+    ASSERT_TRUE(sequentialOk);
+    ASSERT_EQ(sequential.size(), 1000);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+    // small chunks put many boundaries inside events
+    for (qsizetype chunkSize : {1, 64, 1000, 100000}) {
+        bool ok = false;
+        const auto chunked = DeadlineParser::extractChunked(text, &pool, &ok, chunkSize);
+        ASSERT_TRUE(ok);
+        ASSERT_EQ(chunked.size(), sequential.size());
+        for (qsizetype i = 0; i < chunked.size(); ++i) {
+            ASSERT_EQ(chunked.at(i).date, sequential.at(i).date);
+            ASSERT_EQ(chunked.at(i).event, sequential.at(i).event);
+        }
+    }
+}
+
+
+TEST(DeadlineParser, RemovesDuplicates) {
+    // the same call for papers forwarded twice
+    const QString digest = "Paper deadline 15 July 2024\nNotification 1 September 2024\n"
+                           "Paper deadline 15 July 2024\nPaper deadline 16 July 2024\n";
+    bool ok = false;
+    const auto deadlines = DeadlineParser::parse(digest, &ok);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(deadlines.size(), 3);
+    ASSERT_EQ(deadlines.at(2).date, QDate(2024, 7, 16));
 }
 
 
@@ -0,0 +1,335 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QDir>
+#include <QFileInfo>
+#include <QNetworkProxy>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QTimer>
+#include "../Backend/filedownloader.h"
+#include "../Backend/migrations.h"
+#include "http_standin.h"
+
+using project::FileDownloader;
+
+namespace {
+
+// bytes of the file the stand-in serves; another version has different bytes
+QByteArray content(qint64 size, int version = 1)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    for (qint64 i = 0; i < size; ++i)
+        data[i] = char((i * 7 + 2 + version) % 251);
+    return data;
+}
+
+QString sha256Of(qint64 size)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(content(size), QCryptographicHash::Sha256).toHex());
+}
+
+// HTTP stand-in serving content(size, version) for every path, with Range, If-Range
+// (ETag "v<version>") and HEAD support. Paths starting with /slow answer after
+// 100 ms, /flaky drops its first transfer halfway.
+class StandInServer : public HttpStandIn
+{
+public:
+    qint64 size = 64 * 1024;
+    int version = 1;
+    QStringList requests;
+    int active = 0;
+    int maxActive = 0;
+    bool dropped = false;
+
+    StandInServer()
+    {
+        respond = [this](QTcpSocket* socket, const StandInRequest& request) { answer(socket, request); };
+    }
+
+private:
+    void answer(QTcpSocket* socket, const StandInRequest& request)
+    {
+        const QByteArray& method = request.method;
+        const QByteArray& path = request.path;
+
+        QByteArray range = request.header("Range");
+        if (range.startsWith("bytes="))
+            range = range.mid(6);
+        requests << QString(method + ' ' + path + (range.isEmpty() ? QByteArray() : ' ' + range));
+
+        const QByteArray etag = "\"v" + QByteArray::number(version) + '"';
+        // a range for another version of the file is ignored, the whole file is sent
+        const QByteArray ifRange = request.header("If-Range");
+        if (!ifRange.isEmpty() && ifRange != etag)
+            range.clear();
+
+        const QByteArray body = content(size, version);
+        QByteArray status = "200 OK";
+        QByteArray headers = "Accept-Ranges: bytes\r\nETag: " + etag + "\r\n";
+        qint64 first = 0;
+        qint64 last = size - 1;
+        if (!range.isEmpty()) {
+            first = range.left(range.indexOf('-')).toLongLong();
+            const QByteArray end = range.mid(range.indexOf('-') + 1);
+            if (!end.isEmpty())
+                last = qMin(last, end.toLongLong());
+            if (first >= size) {
+                reply(socket, "416 Range Not Satisfiable");
+                return;
+            }
+            status = "206 Partial Content";
+            headers += "Content-Range: bytes " + QByteArray::number(first) + '-' + QByteArray::number(last)
+                       + '/' + QByteArray::number(size) + "\r\n";
+        }
+        const QByteArray slice = body.mid(first, last - first + 1);
+        const QByteArray head = "HTTP/1.1 " + status + "\r\nConnection: close\r\nContent-Length: "
+                                + QByteArray::number(slice.size()) + "\r\n" + headers + "\r\n";
+
+        if (method == "HEAD") {
+            socket->write(head);
+            socket->disconnectFromHost();
+        } else if (path.startsWith("/flaky") && !dropped) {
+            dropped = true;
+            socket->write(head + slice.left(slice.size() / 2));
+            socket->disconnectFromHost();
+        } else if (path.startsWith("/slow")) {
+            maxActive = qMax(maxActive, ++active);
+            QTimer::singleShot(100, socket, [this, socket, head, slice]() {
+                --active;
+                socket->write(head + slice);
+                socket->disconnectFromHost();
+            });
+        } else {
+            socket->write(head + slice);
+            socket->disconnectFromHost();
+        }
+    }
+};
+
+QByteArray readFile(const QString& path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+}
+
+TEST(FileDownloader, ParallelQueue) {
+    StandInServer server;
+    QTemporaryDir dir;
+    FileDownloader downloader;
+    downloader.setDownloadDirectory(dir.path());
+    downloader.setMaxConcurrent(3);
+    downloader.setSegmentsPerFile(1);
+    QSignalSpy complete(&downloader, &FileDownloader::downloadComplete);
+
+    QStringList links;
+    for (int i = 0; i < 7; ++i)
+        links << server.url(QString("/slow/paper%1.pdf").arg(i));
+    downloader.enqueueLinks(links);
+    ASSERT_TRUE(downloader.isDownloading());
+    ASSERT_EQ(downloader.activeCount(), 3);
+    ASSERT_EQ(downloader.queuedCount(), 4);
+
+    ASSERT_TRUE(QTest::qWaitFor([&]() { return complete.count() == 7; }, 10000));
+    ASSERT_FALSE(downloader.isDownloading());
+    ASSERT_EQ(server.maxActive, 3);
+    ASSERT_EQ(downloader.completedCount(), 7);
+    ASSERT_DOUBLE_EQ(downloader.progress(), 1.0);
+    ASSERT_EQ(downloader.downloadStatus(), "Download complete");
+    for (int i = 0; i < 7; ++i)
+        ASSERT_EQ(readFile(dir.filePath(QString("paper%1.pdf").arg(i))), content(server.size));
+
+    // the same name again does not overwrite the finished file
+    downloader.enqueue(server.url("/paper0.pdf"));
+    ASSERT_TRUE(complete.wait(5000));
+    ASSERT_EQ(complete.last().at(0).toString(), dir.filePath("paper0_1.pdf"));
+}
+
+TEST(FileDownloader, ResumeAfterFailure) {
+    StandInServer server;
+    server.size = 200000;
+    QTemporaryDir dir;
+    FileDownloader downloader;
+    downloader.setDownloadDirectory(dir.path());
+    downloader.setSegmentsPerFile(1);
+    QSignalSpy complete(&downloader, &FileDownloader::downloadComplete);
+    QSignalSpy verified(&downloader, &FileDownloader::downloadVerified);
+    QSignalSpy error(&downloader, &FileDownloader::downloadError);
+
+    // no retries: the partial file is kept
+    downloader.setMaxRetries(0);
+    downloader.enqueue(server.url("/flaky.bin"));
+    ASSERT_TRUE(error.wait(5000));
+    ASSERT_EQ(QFileInfo(dir.filePath("flaky.bin.part")).size(), server.size / 2);
+    ASSERT_FALSE(QFile::exists(dir.filePath("flaky.bin")));
+
+    // queued again, the transfer continues where it stopped
+    downloader.enqueue(server.url("/flaky.bin"));
+    ASSERT_TRUE(complete.wait(5000));
+    ASSERT_EQ(complete.last().at(0).toString(), dir.filePath("flaky.bin"));
+    ASSERT_EQ(server.requests.last(), QString("GET /flaky.bin %1-").arg(server.size / 2));
+    ASSERT_EQ(readFile(dir.filePath("flaky.bin")), content(server.size));
+    ASSERT_FALSE(QFile::exists(dir.filePath("flaky.bin.part")));
+    // the resumed half was hashed from disk, the rest while streaming
+    ASSERT_EQ(verified.last().at(1).toString(), sha256Of(server.size));
+}
+
+TEST(FileDownloader, ResumesOnlyTheSameFile) {
+    StandInServer server;
+    server.size = 200000;
+    QTemporaryDir dir;
+    FileDownloader downloader;
+    downloader.setDownloadDirectory(dir.path());
+    downloader.setSegmentsPerFile(1);
+    downloader.setMaxRetries(0);
+    QSignalSpy complete(&downloader, &FileDownloader::downloadComplete);
+    QSignalSpy verified(&downloader, &FileDownloader::downloadVerified);
+    QSignalSpy error(&downloader, &FileDownloader::downloadError);
+
+    // a partial file of the same name from another link is left alone
+    QFile stray(dir.filePath("paper.pdf.part"));
+    ASSERT_TRUE(stray.open(QIODevice::WriteOnly));
+    stray.write("someone else's bytes");
+    stray.close();
+    downloader.enqueue(server.url("/paper.pdf"));
+    ASSERT_TRUE(complete.wait(5000));
+    ASSERT_EQ(complete.last().at(0).toString(), dir.filePath("paper_1.pdf"));
+    ASSERT_EQ(readFile(dir.filePath("paper_1.pdf")), content(server.size));
+    ASSERT_EQ(readFile(dir.filePath("paper.pdf.part")), QByteArray("someone else's bytes"));
+
+    // the file changes on the server after the first half arrived: If-Range brings the new one whole
+    downloader.enqueue(server.url("/flaky.bin"));
+    ASSERT_TRUE(error.wait(5000));
+    ASSERT_EQ(QFileInfo(dir.filePath("flaky.bin.part")).size(), server.size / 2);
+    server.version = 2;
+    downloader.enqueue(server.url("/flaky.bin"));
+    ASSERT_TRUE(complete.wait(5000));
+    ASSERT_EQ(complete.last().at(0).toString(), dir.filePath("flaky.bin"));
+    ASSERT_EQ(server.requests.last(), QString("GET /flaky.bin %1-").arg(server.size / 2));
+    ASSERT_EQ(readFile(dir.filePath("flaky.bin")), content(server.size, 2));
+    ASSERT_EQ(verified.last().at(1).toString(),
+              QString::fromLatin1(QCryptographicHash::hash(content(server.size, 2), QCryptographicHash::Sha256).toHex()));
+}
+
+TEST(FileDownloader, RetriesWithRange) {
+    StandInServer server;
+    server.size = 200000;
+    QTemporaryDir dir;
+    FileDownloader downloader;
+    downloader.setDownloadDirectory(dir.path());
+    downloader.setSegmentsPerFile(1);
+    QSignalSpy complete(&downloader, &FileDownloader::downloadComplete);
+
+    downloader.enqueue(server.url("/flaky.bin"));
+    ASSERT_TRUE(complete.wait(5000));
+    ASSERT_EQ(server.requests, QStringList({"GET /flaky.bin", QString("GET /flaky.bin %1-").arg(server.size / 2)}));
+    ASSERT_EQ(readFile(dir.filePath("flaky.bin")), content(server.size));
+}
+
+TEST(FileDownloader, Segmented) {
+    StandInServer server;
+    server.size = 1024 * 1024 + 3;
+    QTemporaryDir dir;
+    FileDownloader downloader;
+    downloader.setDownloadDirectory(dir.path());
+    downloader.setSegmentsPerFile(4);
+    downloader.setSegmentThreshold(256 * 1024);
+    downloader.setWriteBufferSize(64 * 1024);
+    QSignalSpy complete(&downloader, &FileDownloader::downloadComplete);
+    QSignalSpy verified(&downloader, &FileDownloader::downloadVerified);
+
+    downloader.enqueue(server.url("/dataset.bin"));
+    ASSERT_TRUE(complete.wait(10000));
+    ASSERT_EQ(server.requests.first(), "HEAD /dataset.bin");
+    ASSERT_EQ(server.requests.filter("GET /dataset.bin ").size(), 4);
+    ASSERT_EQ(readFile(dir.filePath("dataset.bin")), content(server.size));
+    // segments arrive out of file order and are still hashed correctly
+    ASSERT_EQ(verified.last().at(1).toString(), sha256Of(server.size));
+
+    // small files stay in one piece
+    server.requests.clear();
+    server.size = 1000;
+    downloader.enqueue(server.url("/small.bin"));
+    ASSERT_TRUE(complete.wait(5000));
+    ASSERT_EQ(server.requests, QStringList({"HEAD /small.bin", "GET /small.bin"}));
+}
+
+TEST(FileDownloader, ChecksumsAndDuplicates) {
+    StandInServer server;
+    server.size = 300000;
+    QTemporaryDir dir;
+    auto db = openInMemory("downloads", migrations::config());
+
+    FileDownloader downloader(db);
+    downloader.setDownloadDirectory(dir.path());
+    downloader.setSegmentsPerFile(1);
+    QSignalSpy verified(&downloader, &FileDownloader::downloadVerified);
+    QSignalSpy duplicate(&downloader, &FileDownloader::duplicateDownloaded);
+
+    downloader.enqueue(server.url("/a.bin"));
+    ASSERT_TRUE(verified.wait(5000));
+    ASSERT_EQ(duplicate.count(), 0);
+    downloader.enqueue(server.url("/b.bin"));
+    ASSERT_TRUE(verified.wait(5000));
+
+    ASSERT_EQ(duplicate.count(), 1);
+    ASSERT_EQ(duplicate.first().at(0).toString(), dir.filePath("b.bin"));
+    ASSERT_EQ(duplicate.first().at(1).toString(), dir.filePath("a.bin"));
+    ASSERT_EQ(downloader.copiesOf(sha256Of(server.size)), QStringList({dir.filePath("a.bin"), dir.filePath("b.bin")}));
+    ASSERT_EQ(db->selectValue<qint64>("SELECT size FROM Downloads WHERE path = ?", {dir.filePath("a.bin")}),
+              server.size);
+
+    QFile::remove(dir.filePath("a.bin"));
+    ASSERT_EQ(downloader.copiesOf(sha256Of(server.size)), QStringList({dir.filePath("b.bin")}));
+}
+
+TEST(FileDownloader, ProgressRateLimit) {
+    StandInServer server;
+    server.size = 16 * 1024 * 1024;
+    QTemporaryDir dir;
+    FileDownloader downloader;
+    downloader.setDownloadDirectory(dir.path());
+    downloader.setSegmentsPerFile(1);
+    downloader.setProgressInterval(100);
+    QSignalSpy complete(&downloader, &FileDownloader::downloadComplete);
+    QSignalSpy progress(&downloader, &FileDownloader::progressChanged);
+
+    QElapsedTimer timer;
+    timer.start();
+    downloader.enqueue(server.url("/large.bin"));
+    ASSERT_TRUE(complete.wait(20000));
+    // a handful of state changes plus at most one update per interval
+    ASSERT_LE(progress.count(), 4 + timer.elapsed() / 100 + 1);
+    ASSERT_EQ(QFileInfo(dir.filePath("large.bin")).size(), server.size);
+}
+
+TEST(FileDownloader, CancelRemovesPartial) {
+    StandInServer server;
+    QTemporaryDir dir;
+    FileDownloader downloader;
+    downloader.setDownloadDirectory(dir.path());
+    downloader.setSegmentsPerFile(1);
+
+    downloader.enqueue(server.url("/slow/a.pdf"));
+    downloader.enqueue(server.url("/slow/b.pdf"));
+    downloader.cancelDownload();
+    ASSERT_FALSE(downloader.isDownloading());
+    ASSERT_EQ(downloader.downloadStatus(), "Download cancelled");
+    QTest::qWait(300);
+    ASSERT_TRUE(QDir(dir.path()).isEmpty());
+}
+
+
+// Custom main that initializes Qt before running tests
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    // the stand-in server is local, never go through a proxy
+    QNetworkProxy::setApplicationProxy(QNetworkProxy::NoProxy);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
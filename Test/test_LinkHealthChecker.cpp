@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QNetworkProxy>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTimer>
+#include "../Backend/linkhealthchecker.h"
+#include "../Backend/migrations.h"
+#include "http_standin.h"
+
+using project::LinkHealthChecker;
+
+namespace {
+
+// HTTP stand-in with a few fixed pages:
+//   /ok        200
+//   /redirect  301 to /ok
+//   /nohead    405 for HEAD, 206 for a ranged GET
+//   /missing   404
+//   /slow      200 after 150 ms
+class StandInServer : public HttpStandIn
+{
+public:
+    QStringList requests;
+    int active = 0;
+    int maxActive = 0;
+
+    StandInServer()
+    {
+        respond = [this](QTcpSocket* socket, const StandInRequest& request) { answer(socket, request); };
+    }
+
+private:
+    void answer(QTcpSocket* socket, const StandInRequest& request)
+    {
+        const bool ranged = request.header("Range") == "bytes=0-0";
+        requests << QString(request.method + ' ' + request.path + (ranged ? " ranged" : ""));
+
+        const QByteArray& path = request.path;
+        if (path == "/ok") {
+            reply(socket, "200 OK");
+        } else if (path == "/redirect") {
+            reply(socket, "301 Moved Permanently", QByteArray(), "Location: " + url("/ok").toUtf8() + "\r\n");
+        } else if (path == "/nohead") {
+            if (request.method == "HEAD")
+                reply(socket, "405 Method Not Allowed");
+            else
+                reply(socket, "206 Partial Content", "x", "Content-Range: bytes 0-0/1000\r\n");
+        } else if (path.startsWith("/slow")) {
+            maxActive = qMax(maxActive, ++active);
+            QTimer::singleShot(150, socket, [this, socket]() {
+                --active;
+                reply(socket, "200 OK");
+            });
+        } else {
+            reply(socket, "404 Not Found");
+        }
+    }
+};
+
+int addLink(const DbmPtr& db, const QString& url, int projectId = 1)
+{
+    return int(db->insertRow("links", {"url", "website", "project_id"}, {url, url, projectId}));
+}
+
+struct Health {
+    int status;
+    QString finalUrl;
+    QString error;
+};
+
+Health healthOf(const DbmPtr& db, int linkId)
+{
+    const auto found = db->selectRows<Health, int, QString, QString>(
+        "SELECT status, final_url, error FROM link_health WHERE link_id = ?", {linkId});
+    return found.isEmpty() ? Health{-1, QString(), QString()} : found.first();
+}
+
+}
+
+TEST(LinkHealthChecker, ChecksAndRecords) {
+    StandInServer server;
+    auto db = openInMemory("healthRecords", migrations::research());
+
+    // a port nobody listens on
+    QTcpServer closed;
+    closed.listen(QHostAddress::LocalHost);
+    const QString unreachable = QString("http://127.0.0.1:%1/").arg(closed.serverPort());
+    closed.close();
+
+    const int ok = addLink(db, server.url("/ok"));
+    const int redirect = addLink(db, server.url("/redirect"));
+    const int noHead = addLink(db, server.url("/nohead"));
+    const int missing = addLink(db, server.url("/missing"));
+    const int down = addLink(db, unreachable);
+    const int other = addLink(db, server.url("/ok"), 2);
+
+    int notified = 0;
+    db->subscribe("links", [&notified](const ChangeEvent& change) {
+        if (change.op == ChangeOp::Update)
+            ++notified;
+    });
+
+    LinkHealthChecker checker(db, nullptr);
+    QSignalSpy finished(&checker, &LinkHealthChecker::finished);
+    ASSERT_EQ(checker.check(1), 5);
+    ASSERT_TRUE(checker.isRunning());
+    ASSERT_TRUE(finished.wait(5000));
+    ASSERT_FALSE(checker.isRunning());
+    ASSERT_EQ(finished.first().at(0).toInt(), 5);
+    ASSERT_EQ(finished.first().at(1).toInt(), 2);
+    ASSERT_EQ(notified, 5);
+
+    ASSERT_EQ(healthOf(db, ok).status, 200);
+    ASSERT_EQ(healthOf(db, redirect).status, 200);
+    ASSERT_EQ(healthOf(db, redirect).finalUrl, server.url("/ok"));
+    ASSERT_EQ(healthOf(db, noHead).status, 206);
+    ASSERT_EQ(healthOf(db, missing).status, 404);
+    ASSERT_EQ(healthOf(db, down).status, 0);
+    ASSERT_FALSE(healthOf(db, down).error.isEmpty());
+    // other projects are left alone
+    ASSERT_EQ(healthOf(db, other).status, -1);
+
+    // HEAD first, one ranged GET only where HEAD was refused
+    ASSERT_TRUE(server.requests.contains("HEAD /nohead"));
+    ASSERT_TRUE(server.requests.contains("GET /nohead ranged"));
+    ASSERT_EQ(server.requests.filter("GET").size(), 1);
+    ASSERT_FALSE(server.requests.contains("GET /missing ranged"));
+
+    ASSERT_TRUE(LinkHealthChecker::isBroken(healthOf(db, missing).status));
+    ASSERT_FALSE(LinkHealthChecker::isBroken(healthOf(db, noHead).status));
+}
+
+TEST(LinkHealthChecker, Incremental) {
+    StandInServer server;
+    auto db = openInMemory("healthIncremental", migrations::research());
+    const int first = addLink(db, server.url("/ok"));
+
+    LinkHealthChecker checker(db, nullptr);
+    QSignalSpy finished(&checker, &LinkHealthChecker::finished);
+    ASSERT_EQ(checker.check(), 1);
+    ASSERT_TRUE(finished.wait(5000));
+
+    // fresh results are not checked again, new links are
+    const int second = addLink(db, server.url("/missing"));
+    ASSERT_EQ(checker.check(), 1);
+    ASSERT_TRUE(finished.wait(5000));
+    ASSERT_EQ(server.requests.size(), 2);
+    ASSERT_EQ(healthOf(db, second).status, 404);
+
+    ASSERT_EQ(checker.check(), 0);
+    checker.setStaleAfter(0);
+    ASSERT_EQ(checker.check(), 2);
+    ASSERT_TRUE(finished.wait(5000));
+    ASSERT_EQ(healthOf(db, first).status, 200);
+
+    // results go away with their link
+    ASSERT_TRUE(db->deleteByIds("links", {first}));
+    ASSERT_EQ(healthOf(db, first).status, -1);
+}
+
+TEST(LinkHealthChecker, PerHostLimit) {
+    StandInServer server;
+    auto db = openInMemory("healthPerHost", migrations::research());
+    for (int i = 0; i < 8; ++i)
+        addLink(db, server.url(QString("/slow/%1").arg(i)));
+
+    LinkHealthChecker checker(db, nullptr);
+    checker.setMaxConcurrent(8);
+    checker.setMaxPerHost(2);
+    QSignalSpy finished(&checker, &LinkHealthChecker::finished);
+    QSignalSpy checked(&checker, &LinkHealthChecker::linkChecked);
+    ASSERT_EQ(checker.check(), 8);
+    ASSERT_TRUE(finished.wait(10000));
+
+    ASSERT_EQ(checked.count(), 8);
+    ASSERT_EQ(finished.first().at(1).toInt(), 0);
+    ASSERT_EQ(server.maxActive, 2);
+}
+
+TEST(LinkHealthChecker, Timeout) {
+    StandInServer server;
+    auto db = openInMemory("healthTimeout", migrations::research());
+    const int slow = addLink(db, server.url("/slow"));
+
+    LinkHealthChecker checker(db, nullptr);
+    checker.setTimeoutMs(50);
+    QSignalSpy finished(&checker, &LinkHealthChecker::finished);
+    ASSERT_EQ(checker.check(), 1);
+    ASSERT_TRUE(finished.wait(5000));
+    ASSERT_EQ(healthOf(db, slow).status, 0);
+    ASSERT_TRUE(healthOf(db, slow).error.startsWith("timed out"));
+}
+
+
+// Custom main that initializes Qt before running tests
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    // the stand-in server is local, never go through a proxy
+    QNetworkProxy::setApplicationProxy(QNetworkProxy::NoProxy);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
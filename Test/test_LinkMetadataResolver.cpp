@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QNetworkProxy>
+#include <QSignalSpy>
+#include <QTimer>
+#include "../Backend/linkmetadataresolver.h"
+#include "../Backend/migrations.h"
+#include "http_standin.h"
+
+using project::LinkMetadataResolver;
+
+TEST(LinkMetadataResolver, ExtractTitle) {
+    bool complete = false;
+    ASSERT_EQ(LinkMetadataResolver::extractTitle("<html><head><title lang=\"en\">\n  Tom &amp; Jerry </title>", &complete),
+              "Tom & Jerry");
+    ASSERT_TRUE(complete);
+
+    ASSERT_EQ(LinkMetadataResolver::extractTitle(
+                  "<meta content=\"GitHub\" property=\"og:site_name\"><title></title>"), "GitHub");
+    ASSERT_EQ(LinkMetadataResolver::extractTitle(
+                  "<meta property='og:site_name' content='arXiv'>"), "arXiv");
+
+    ASSERT_TRUE(LinkMetadataResolver::extractTitle("<html><head><title>Cut of", &complete).isEmpty());
+    ASSERT_FALSE(complete);
+}
+
+TEST(LinkMetadataResolver, ResolvesAndCaches) {
+    HttpStandIn server;
+    server.respond = [](QTcpSocket* socket, const StandInRequest&) {
+        HttpStandIn::reply(socket, "200 OK", "<html><head><title>Stand-in Page</title></head><body>x</body></html>",
+                           "Content-Type: text/html\r\n");
+    };
+
+    LinkMetadataResolver resolver(openInMemory("linkCache", migrations::config()));
+    QSignalSpy resolved(&resolver, &LinkMetadataResolver::resolved);
+    const QString url = server.url();
+
+    ASSERT_TRUE(resolver.cachedTitle(url).isEmpty());
+    resolver.resolve(url);
+    resolver.resolve(url); // merged with the request in flight
+    ASSERT_TRUE(resolved.wait(5000));
+    ASSERT_EQ(resolved.first().at(0).toString(), url);
+    ASSERT_EQ(resolved.first().at(1).toString(), "Stand-in Page");
+    ASSERT_EQ(server.requestCount, 1);
+
+    // served from the cache afterwards, without network
+    ASSERT_EQ(resolver.cachedTitle(url), "Stand-in Page");
+    ASSERT_EQ(server.requestCount, 1);
+
+    resolver.setCacheTtl(0);
+    ASSERT_TRUE(resolver.cachedTitle(url).isEmpty());
+}
+
+TEST(LinkMetadataResolver, StopsReadingAtTitle) {
+    HttpStandIn server;
+    // announces a large body but only sends the head, then stalls
+    server.respond = [](QTcpSocket* socket, const StandInRequest&) {
+        socket->write("HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: 10000000\r\n\r\n"
+                      "<html><head><title>Early Title</title>");
+    };
+
+    LinkMetadataResolver resolver(openInMemory("earlyCache", migrations::config()));
+    resolver.setTimeoutMs(10000);
+    QSignalSpy resolved(&resolver, &LinkMetadataResolver::resolved);
+
+    QElapsedTimer timer;
+    timer.start();
+    resolver.resolve(server.url());
+    ASSERT_TRUE(resolved.wait(5000));
+    ASSERT_LT(timer.elapsed(), 5000);
+    ASSERT_EQ(resolved.first().at(1).toString(), "Early Title");
+}
+
+TEST(LinkMetadataResolver, TitleSplitAcrossChunks) {
+    HttpStandIn server;
+    // the closing tag arrives in two pieces, then the server stalls
+    server.respond = [](QTcpSocket* socket, const StandInRequest&) {
+        socket->write("HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: 10000000\r\n\r\n"
+                      "<html><head><title>Split Title</ti");
+        QTimer::singleShot(200, socket, [socket]() { socket->write("tle><body>"); });
+    };
+
+    LinkMetadataResolver resolver(openInMemory("splitCache", migrations::config()));
+    resolver.setTimeoutMs(10000);
+    QSignalSpy resolved(&resolver, &LinkMetadataResolver::resolved);
+    resolver.resolve(server.url());
+    ASSERT_TRUE(resolved.wait(5000));
+    ASSERT_EQ(resolved.first().at(1).toString(), "Split Title");
+}
+
+TEST(LinkMetadataResolver, ByteCap) {
+    HttpStandIn server;
+    // no title within the cap: the host name is used
+    server.respond = [](QTcpSocket* socket, const StandInRequest&) {
+        socket->write("HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: 10000000\r\n\r\n"
+                      + QByteArray(64 * 1024, 'x'));
+    };
+
+    LinkMetadataResolver resolver(openInMemory("capCache", migrations::config()));
+    resolver.setMaxBytes(16 * 1024);
+    QSignalSpy resolved(&resolver, &LinkMetadataResolver::resolved);
+    resolver.resolve(server.url());
+    ASSERT_TRUE(resolved.wait(5000));
+    ASSERT_EQ(resolved.first().at(1).toString(), "127.0.0.1");
+}
+
+TEST(LinkMetadataResolver, TimeoutAndErrors) {
+    HttpStandIn server;
+    server.respond = [](QTcpSocket*, const StandInRequest&) {
+        // never answers
+    };
+
+    LinkMetadataResolver resolver(openInMemory("timeoutCache", migrations::config()));
+    resolver.setTimeoutMs(300);
+    QSignalSpy failed(&resolver, &LinkMetadataResolver::failed);
+    QSignalSpy resolved(&resolver, &LinkMetadataResolver::resolved);
+    resolver.resolve(server.url("/slow"));
+    ASSERT_TRUE(failed.wait(5000));
+    ASSERT_EQ(resolved.count(), 0);
+    // failures are not cached, the next add tries again
+    ASSERT_TRUE(resolver.cachedTitle(server.url("/slow")).isEmpty());
+
+    server.respond = [](QTcpSocket* socket, const StandInRequest&) {
+        HttpStandIn::reply(socket, "404 Not Found");
+    };
+    resolver.resolve(server.url("/missing"));
+    ASSERT_TRUE(failed.wait(5000));
+    ASSERT_EQ(failed.last().at(0).toString(), server.url("/missing"));
+}
+
+
+// Custom main that initializes Qt before running tests
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    // the stand-in server is local, never go through a proxy
+    QNetworkProxy::setApplicationProxy(QNetworkProxy::NoProxy);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
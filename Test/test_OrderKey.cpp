@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QRandomGenerator>
+#include "../Backend/orderkey.h"
+
+
+TEST(OrderKey, AppendAndPrepend) {
+    const QStringList keys = OrderKey::sequence(5000);
+    ASSERT_EQ(keys.first(), "a0");
+    for (int i = 1; i < keys.size(); ++i)
+        ASSERT_LT(keys[i - 1], keys[i]);
+    // appending only bumps the integer part
+    ASSERT_LE(keys.last().size(), 4);
+
+    QString first = "a0";
+    for (int i = 0; i < 5000; ++i) {
+        const QString key = OrderKey::before(first);
+        ASSERT_TRUE(OrderKey::isValid(key));
+        ASSERT_LT(key, first);
+        first = key;
+    }
+    ASSERT_LE(first.size(), 4);
+}
+
+TEST(OrderKey, Between) {
+    ASSERT_EQ(OrderKey::between("", ""), "a0");
+    ASSERT_EQ(OrderKey::between("a0", "a1"), "a0V");
+    ASSERT_EQ(OrderKey::between("a0", "a0V"), "a0G");
+    ASSERT_EQ(OrderKey::between("a1", "a3"), "a2");
+
+    // repeatedly splitting the same gap keeps working
+    QString upper = "a1";
+    for (int i = 0; i < 100; ++i) {
+        const QString key = OrderKey::between("a0", upper);
+        ASSERT_LT(QString("a0"), key);
+        ASSERT_LT(key, upper);
+        upper = key;
+    }
+}
+
+TEST(OrderKey, RandomInserts) {
+    QStringList keys = {"a0"};
+    QRandomGenerator rng(42);
+    for (int i = 0; i < 20000; ++i) {
+        const int position = rng.bounded(keys.size() + 1);
+        const QString lower = position > 0 ? keys[position - 1] : QString();
+        const QString upper = position < keys.size() ? keys[position] : QString();
+        const QString key = OrderKey::between(lower, upper);
+        ASSERT_TRUE(OrderKey::isValid(key)) << lower.toStdString() << " " << upper.toStdString();
+        ASSERT_TRUE(lower.isEmpty() || lower < key);
+        ASSERT_TRUE(upper.isEmpty() || key < upper);
+        keys.insert(position, key);
+    }
+}
+
+TEST(OrderKey, InvalidInput) {
+    ASSERT_FALSE(OrderKey::isValid(""));
+    ASSERT_FALSE(OrderKey::isValid("a"));
+    ASSERT_FALSE(OrderKey::isValid("a00"));
+    ASSERT_FALSE(OrderKey::isValid("a0-"));
+    ASSERT_TRUE(OrderKey::isValid("b00"));
+    ASSERT_TRUE(OrderKey::isValid("a0V"));
+
+    ASSERT_TRUE(OrderKey::between("a1", "a0").isEmpty());
+    ASSERT_TRUE(OrderKey::between("a1", "a1").isEmpty());
+    ASSERT_TRUE(OrderKey::between("2025-01-01", "a0").isEmpty());
+}
+
+
+// Custom main that initializes Qt before running tests
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
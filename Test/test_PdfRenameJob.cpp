@@ -0,0 +1,340 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QNetworkProxy>
+#include <QSignalSpy>
+#include <QTest>
+#include <QTemporaryDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QRegularExpression>
+#include <QFile>
+#include <QDir>
+#include <QTimer>
+#include "../Backend/pdfrenamejob.h"
+#include "../Backend/airesponsecache.h"
+#include "../Backend/migrations.h"
+#include "http_standin.h"
+
+using project::PdfRenameJob;
+
+namespace {
+
+// Stand-in for the generateContent endpoint. It answers with the document text
+// plus ".pdf" as the suggested name, after a short delay so requests overlap.
+// Documents named in the text change the answer:
+//   "flaky ..."     429 (Retry-After: 0), then 503, then the name
+//   "rejected ..."  400 with an API error
+//   "down ..."      503 every time
+class GeminiStandIn : public HttpStandIn
+{
+public:
+    QStringList paths;
+    QStringList apiKeys;
+    QHash<QString, int> calls;
+    int active = 0;
+    int maxActive = 0;
+
+    GeminiStandIn()
+    {
+        respond = [this](QTcpSocket* socket, const StandInRequest& request) { answer(socket, request); };
+    }
+
+    QUrl endpoint() const
+    {
+        return QUrl(url("/v1beta"));
+    }
+
+private:
+    static void replyJson(QTcpSocket* socket, const QByteArray& status, const QByteArray& body,
+                          const QByteArray& headers = QByteArray())
+    {
+        reply(socket, status, body, "Content-Type: application/json\r\n" + headers);
+    }
+
+    static QByteArray candidate(const QString& text)
+    {
+        QJsonObject part{{"text", text}};
+        QJsonObject content{{"parts", QJsonArray{part}}};
+        QJsonObject first{{"content", content}};
+        return QJsonDocument(QJsonObject{{"candidates", QJsonArray{first}}}).toJson(QJsonDocument::Compact);
+    }
+
+    void answer(QTcpSocket* socket, const StandInRequest& request)
+    {
+        paths << QString(request.path);
+        apiKeys << QString::fromLatin1(request.header("x-goog-api-key"));
+
+        const QString prompt = QJsonDocument::fromJson(request.body).object()["contents"].toArray()[0].toObject()
+                                   ["parts"].toArray()[0].toObject()["text"].toString();
+        const QRegularExpression content("--- PDF FIRST PAGE CONTENT ---\n(.*)\n--- END OF CONTENT ---",
+                                         QRegularExpression::DotMatchesEverythingOption);
+        const QString text = content.match(prompt).captured(1).trimmed();
+        const int call = ++calls[text];
+
+        maxActive = qMax(maxActive, ++active);
+        QTimer::singleShot(30, socket, [this, socket, text, call]() {
+            --active;
+            if (text.startsWith("flaky") && call == 1)
+                replyJson(socket, "429 Too Many Requests", "{}", "Retry-After: 0\r\n");
+            else if (text.startsWith("flaky") && call == 2)
+                replyJson(socket, "503 Service Unavailable", "{}");
+            else if (text.startsWith("rejected"))
+                replyJson(socket, "400 Bad Request", R"({"error":{"message":"API key not valid"}})");
+            else if (text.startsWith("down"))
+                replyJson(socket, "503 Service Unavailable", "{}");
+            else
+                replyJson(socket, "200 OK", candidate("\"" + text + ".pdf\"\n"));
+        });
+    }
+};
+
+// the stand-in documents are plain text files named .pdf
+QString readText(const QString& path)
+{
+    QFile file(path);
+    file.open(QIODevice::ReadOnly);
+    return QString::fromUtf8(file.readAll());
+}
+
+QString writePdf(const QTemporaryDir& dir, const QString& name, const QString& text)
+{
+    const QString path = dir.filePath(name);
+    QFile file(path);
+    file.open(QIODevice::WriteOnly);
+    file.write(text.toUtf8());
+    return path;
+}
+
+void configure(PdfRenameJob& job, const GeminiStandIn& server)
+{
+    job.setEndpoint(server.endpoint());
+    job.setApiKey("test-key");
+    job.setPrompt("Suggest a filename.");
+    // no rate limit to wait for, quick retries
+    job.scheduler()->setRateLimit(60000, 100);
+    job.scheduler()->setRetryDelay(10);
+    job.setTextExtractor(&readText);
+}
+
+int rowOf(const PdfRenameJob& job, const QString& path)
+{
+    for (int row = 0; row < job.rowCount(); ++row) {
+        if (job.data(job.index(row), PdfRenameJob::PathRole).toString() == path)
+            return row;
+    }
+    return -1;
+}
+
+}
+
+TEST(PdfRenameJob, RenamesBatch) {
+    GeminiStandIn server;
+    QTemporaryDir dir;
+    QStringList files;
+    for (int i = 0; i < 6; ++i)
+        files << writePdf(dir, QString("download%1.pdf").arg(i), QString("Paper %1").arg(i));
+    writePdf(dir, "notes.txt", "not a pdf");
+
+    PdfRenameJob job(nullptr);
+    configure(job, server);
+    job.setMaxConcurrent(2);
+    QSignalSpy finished(&job, &PdfRenameJob::finished);
+    QSignalSpy renamed(&job, &PdfRenameJob::fileRenamed);
+
+    ASSERT_EQ(job.addFolder(dir.path()), 6);
+    ASSERT_TRUE(job.isRunning());
+    ASSERT_EQ(job.rowCount(), 6);
+    // a second add of the same files while they are pending is ignored
+    ASSERT_EQ(job.addFiles(files), 0);
+
+    ASSERT_TRUE(finished.wait(10000));
+    ASSERT_FALSE(job.isRunning());
+    ASSERT_EQ(finished.first().at(0).toInt(), 6);
+    ASSERT_EQ(finished.first().at(1).toInt(), 0);
+    ASSERT_EQ(renamed.count(), 6);
+    ASSERT_EQ(server.maxActive, 2);
+
+    for (int i = 0; i < 6; ++i) {
+        const int row = rowOf(job, files.at(i));
+        ASSERT_GE(row, 0);
+        const QString expected = dir.filePath(QString("Paper %1.pdf").arg(i));
+        ASSERT_EQ(job.data(job.index(row), PdfRenameJob::StatusRole).toInt(), PdfRenameJob::Renamed);
+        ASSERT_EQ(job.data(job.index(row), PdfRenameJob::NewPathRole).toString(), expected);
+        ASSERT_TRUE(QFile::exists(expected));
+        ASSERT_FALSE(QFile::exists(files.at(i)));
+    }
+
+    ASSERT_EQ(server.paths.size(), 6);
+    ASSERT_EQ(server.paths.first(), "/v1beta/models/gemini-2.5-flash:generateContent");
+    ASSERT_EQ(server.apiKeys.first(), "test-key");
+
+    job.clearFinished();
+    ASSERT_EQ(job.rowCount(), 0);
+}
+
+TEST(PdfRenameJob, RetriesTransientErrors) {
+    GeminiStandIn server;
+    QTemporaryDir dir;
+    const QString flaky = writePdf(dir, "a.pdf", "flaky paper");
+    const QString down = writePdf(dir, "b.pdf", "down paper");
+
+    PdfRenameJob job(nullptr);
+    configure(job, server);
+    job.scheduler()->setMaxRetries(2);
+    QSignalSpy finished(&job, &PdfRenameJob::finished);
+    QSignalSpy failed(&job, &PdfRenameJob::fileFailed);
+
+    ASSERT_EQ(job.addFiles({flaky, down}), 2);
+    ASSERT_TRUE(finished.wait(10000));
+
+    // 429, 503, then the name
+    const int flakyRow = rowOf(job, flaky);
+    ASSERT_EQ(job.data(job.index(flakyRow), PdfRenameJob::StatusRole).toInt(), PdfRenameJob::Renamed);
+    ASSERT_EQ(job.data(job.index(flakyRow), PdfRenameJob::AttemptsRole).toInt(), 3);
+    ASSERT_TRUE(QFile::exists(dir.filePath("flaky paper.pdf")));
+
+    // one attempt plus the two retries, then the file is left alone
+    const int downRow = rowOf(job, down);
+    ASSERT_EQ(job.data(job.index(downRow), PdfRenameJob::StatusRole).toInt(), PdfRenameJob::Failed);
+    ASSERT_EQ(server.calls.value("down paper"), 3);
+    ASSERT_TRUE(QFile::exists(down));
+    ASSERT_EQ(failed.count(), 1);
+}
+
+TEST(PdfRenameJob, ReportsRejectedRequests) {
+    GeminiStandIn server;
+    QTemporaryDir dir;
+    const QString rejected = writePdf(dir, "c.pdf", "rejected paper");
+
+    PdfRenameJob job(nullptr);
+    configure(job, server);
+    QSignalSpy finished(&job, &PdfRenameJob::finished);
+
+    ASSERT_EQ(job.addFiles({rejected}), 1);
+    ASSERT_TRUE(finished.wait(10000));
+
+    // client errors are not retried
+    ASSERT_EQ(server.calls.value("rejected paper"), 1);
+    const int row = rowOf(job, rejected);
+    ASSERT_EQ(job.data(job.index(row), PdfRenameJob::StatusRole).toInt(), PdfRenameJob::Failed);
+    ASSERT_EQ(job.data(job.index(row), PdfRenameJob::ErrorRole).toString(), "API Error: API key not valid");
+    ASSERT_TRUE(QFile::exists(rejected));
+}
+
+TEST(PdfRenameJob, UniqueTargets) {
+    GeminiStandIn server;
+    QTemporaryDir dir;
+    const QString first = writePdf(dir, "x.pdf", "Same Title");
+    const QString second = writePdf(dir, "y.pdf", "Same Title");
+
+    PdfRenameJob job(nullptr);
+    configure(job, server);
+    job.setMaxConcurrent(1);
+    QSignalSpy finished(&job, &PdfRenameJob::finished);
+    ASSERT_EQ(job.addFiles({first, second}), 2);
+    ASSERT_TRUE(finished.wait(10000));
+
+    ASSERT_TRUE(QFile::exists(dir.filePath("Same Title.pdf")));
+    ASSERT_TRUE(QFile::exists(dir.filePath("Same Title_1.pdf")));
+
+    // suggestions are cleaned up before they become a file name
+    const QString old = dir.filePath("old.pdf");
+    ASSERT_EQ(PdfRenameJob::targetPath(old, "'A/B: C?'\nbecause..."), dir.filePath("AB C.pdf"));
+    ASSERT_EQ(PdfRenameJob::targetPath(old, "\"Same Title.PDF\""), dir.filePath("Same Title_2.pdf"));
+    ASSERT_TRUE(PdfRenameJob::targetPath(old, " .pdf ").isEmpty());
+}
+
+TEST(PdfRenameJob, Cancel) {
+    GeminiStandIn server;
+    QTemporaryDir dir;
+    QStringList files;
+    for (int i = 0; i < 4; ++i)
+        files << writePdf(dir, QString("d%1.pdf").arg(i), QString("Doc %1").arg(i));
+
+    PdfRenameJob job(nullptr);
+    configure(job, server);
+    job.setMaxConcurrent(1);
+    QSignalSpy finished(&job, &PdfRenameJob::finished);
+    QSignalSpy renamed(&job, &PdfRenameJob::fileRenamed);
+    ASSERT_EQ(job.addFiles(files), 4);
+    ASSERT_TRUE(renamed.wait(10000));
+
+    job.cancel();
+    ASSERT_FALSE(job.isRunning());
+    ASSERT_EQ(finished.count(), 1);
+    ASSERT_EQ(job.renamedCount(), 1);
+    ASSERT_EQ(job.failedCount(), 3);
+    QTest::qWait(100);
+    ASSERT_EQ(renamed.count(), 1);
+}
+
+TEST(PdfRenameJob, AnswersFromCache) {
+    GeminiStandIn server;
+    QTemporaryDir dir;
+    auto db = openInMemory("renameCache", migrations::config());
+    project::AiResponseCache cache(db);
+
+    PdfRenameJob job(nullptr);
+    configure(job, server);
+    job.setCache(&cache);
+    QSignalSpy finished(&job, &PdfRenameJob::finished);
+
+    const QString first = writePdf(dir, "preprint.pdf", "Cached Paper");
+    ASSERT_EQ(job.addFiles({first}), 1);
+    ASSERT_TRUE(finished.wait(10000));
+    ASSERT_EQ(server.paths.size(), 1);
+    ASSERT_EQ(cache.count(), 1);
+
+    // the same first page elsewhere is renamed without a request
+    QDir(dir.path()).mkdir("other");
+    const QString copy = writePdf(dir, "other/copy.pdf", "Cached Paper");
+    job.clearFinished();
+    ASSERT_EQ(job.addFiles({copy}), 1);
+    ASSERT_TRUE(finished.wait(10000));
+    ASSERT_EQ(server.paths.size(), 1);
+    ASSERT_TRUE(job.data(job.index(0), PdfRenameJob::CachedRole).toBool());
+    ASSERT_TRUE(QFile::exists(dir.filePath("other/Cached Paper.pdf")));
+
+    // another prompt is another question
+    job.setPrompt("Suggest a shorter filename.");
+    const QString again = writePdf(dir, "again.pdf", "Cached Paper");
+    ASSERT_EQ(job.addFiles({again}), 1);
+    ASSERT_TRUE(finished.wait(10000));
+    ASSERT_EQ(server.paths.size(), 2);
+}
+
+TEST(PdfRenameJob, UnreadableFilesBypassCache) {
+    GeminiStandIn server;
+    QTemporaryDir dir;
+    auto db = openInMemory("renameUnreadable", migrations::config());
+    project::AiResponseCache cache(db);
+
+    PdfRenameJob job(nullptr);
+    configure(job, server);
+    job.setCache(&cache);
+    // no text from either file, as without Qt PDF or for a damaged one
+    job.setTextExtractor([](const QString&) { return QString(); });
+    QSignalSpy finished(&job, &PdfRenameJob::finished);
+
+    const QString first = writePdf(dir, "scan-a.pdf", "Paper A");
+    const QString second = writePdf(dir, "scan-b.pdf", "Paper B");
+    ASSERT_EQ(job.addFiles({first, second}), 2);
+    ASSERT_TRUE(finished.wait(10000));
+    // each file is asked about on its own, nothing is cached for text that was never read
+    ASSERT_EQ(server.paths.size(), 2);
+    ASSERT_EQ(cache.count(), 0);
+    for (int row = 0; row < job.rowCount(); ++row)
+        ASSERT_FALSE(job.data(job.index(row), PdfRenameJob::CachedRole).toBool());
+}
+
+
+// Custom main that initializes Qt before running tests
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    // the stand-in server is local, never go through a proxy
+    QNetworkProxy::setApplicationProxy(QNetworkProxy::NoProxy);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QDebug>
+#include "../Backend/projectsearchindex.h"
+
+
+TEST(ProjectSearchIndex, RankingTiers) {
+    ProjectSearchIndex index;
+    index.insert(1, "Lidar");
+    index.insert(2, "Lidar Calibration");
+    index.insert(3, "Outdoor Lidar Mapping");
+    index.insert(4, "Solidarity Network");
+    index.insert(5, "Lidra Survey");
+    index.insert(6, "Thermal Camera");
+
+    auto matches = index.search("lidar", 10);
+    ASSERT_EQ(matches.size(), 5);
+    ASSERT_EQ(matches[0].id, 1);
+    ASSERT_EQ(matches[0].tier, ProjectSearchIndex::Tier::Exact);
+    ASSERT_EQ(matches[1].id, 2);
+    ASSERT_EQ(matches[1].tier, ProjectSearchIndex::Tier::Prefix);
+    ASSERT_EQ(matches[2].id, 3);
+    ASSERT_EQ(matches[2].tier, ProjectSearchIndex::Tier::WordStart);
+    ASSERT_EQ(matches[3].id, 4);
+    ASSERT_EQ(matches[3].tier, ProjectSearchIndex::Tier::Substring);
+    ASSERT_EQ(matches[4].id, 5);
+    ASSERT_EQ(matches[4].tier, ProjectSearchIndex::Tier::Fuzzy);
+    ASSERT_EQ(matches[4].distance, 1);
+}
+
+TEST(ProjectSearchIndex, CaseAndShortQueries) {
+    ProjectSearchIndex index;
+    index.insert(1, "Deep Learning");
+    index.insert(2, "Reinforcement Learning");
+
+    ASSERT_EQ(index.suggest("LEARN"), QStringList({"Deep Learning", "Reinforcement Learning"}));
+    ASSERT_EQ(index.suggest("de"), QStringList({"Deep Learning"}));
+    ASSERT_EQ(index.suggest("ep"), QStringList({"Deep Learning"}));
+    ASSERT_TRUE(index.suggest("").isEmpty());
+    ASSERT_TRUE(index.contains("deep learning"));
+    ASSERT_FALSE(index.contains("deep"));
+}
+
+TEST(ProjectSearchIndex, InsertRemoveAndRename) {
+    ProjectSearchIndex index;
+    for (int i = 0; i < 200; ++i)
+        index.insert(i, QString("project %1").arg(i));
+    ASSERT_EQ(index.size(), 200);
+
+    for (int i = 0; i < 150; ++i)
+        index.remove(i);
+    ASSERT_EQ(index.size(), 50);
+    ASSERT_FALSE(index.contains("project 12"));
+    ASSERT_EQ(index.suggest("project 199", 1), QStringList({"project 199"}));
+
+    // inserting an existing id replaces the name
+    index.insert(199, "renamed");
+    ASSERT_FALSE(index.contains("project 199"));
+    ASSERT_EQ(index.suggest("renamed", 1), QStringList({"renamed"}));
+}
+
+TEST(ProjectSearchIndex, Rebuild) {
+    ProjectSearchIndex index;
+    index.insert(99, "stale");
+    index.rebuild({{1, "Outdoor Lidar Mapping"}, {2, "Lidar"}, {3, "Thermal Camera"}, {2, "Lidar Calibration"}});
+    ASSERT_EQ(index.size(), 3);
+    ASSERT_FALSE(index.contains("stale"));
+    ASSERT_FALSE(index.contains("lidar"));
+
+    auto matches = index.search("lidar", 10);
+    ASSERT_EQ(matches.size(), 2);
+    ASSERT_EQ(matches[0].id, 2);
+    ASSERT_EQ(matches[0].tier, ProjectSearchIndex::Tier::Prefix);
+    ASSERT_EQ(matches[1].id, 1);
+    ASSERT_EQ(matches[1].tier, ProjectSearchIndex::Tier::WordStart);
+
+    // incremental adds after a bulk load keep the keys sorted
+    index.insert(4, "Camera Rig");
+    ASSERT_EQ(index.suggest("camera"), QStringList({"Camera Rig", "Thermal Camera"}));
+    index.remove(3);
+    ASSERT_EQ(index.suggest("camera"), QStringList({"Camera Rig"}));
+}
+
+TEST(ProjectSearchIndex, EditDistance) {
+    ASSERT_EQ(ProjectSearchIndex::editDistance("kitten", "sitting", 5), 3);
+    ASSERT_EQ(ProjectSearchIndex::editDistance("lidar", "lidra", 2), 1);
+    ASSERT_EQ(ProjectSearchIndex::editDistance("abc", "abc", 0), 0);
+    // stops early once the bound is exceeded
+    ASSERT_EQ(ProjectSearchIndex::editDistance("abcdef", "uvwxyz", 2), 3);
+}
+
+TEST(ProjectSearchIndex, LargeWorkspace) {
+    ProjectSearchIndex index;
+    const QStringList topics = {"lidar", "mapping", "grant", "survey", "robot", "thesis", "review", "camera"};
+    QList<std::pair<int, QString>> projects;
+    for (int i = 0; i < 5000; ++i)
+        projects.append({i, QString("%1 %2 %3").arg(topics[i % topics.size()], topics[(i / 8) % topics.size()]).arg(i)});
+
+    QElapsedTimer build;
+    build.start();
+    index.rebuild(projects);
+    qInfo() << "[ProjectSearchIndex] rebuild" << build.nsecsElapsed() / 1000 << "us";
+    ASSERT_EQ(index.size(), 5000);
+
+    QElapsedTimer timer;
+    timer.start();
+    const int rounds = 100;
+    for (int i = 0; i < rounds; ++i)
+        ASSERT_FALSE(index.search(i % 2 ? "robot" : "robto", 10).isEmpty());
+    qInfo() << "[ProjectSearchIndex] average search" << timer.nsecsElapsed() / rounds / 1000 << "us";
+}
+
+
+// Custom main that initializes Qt before running tests
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QAbstractItemModelTester>
+#include <QRandomGenerator>
+#include <QSignalSpy>
+#include "../Backend/sqllistmodel.h"
+
+namespace {
+
+struct Item {
+    int id;
+    QString name;
+    int rank;
+};
+
+// ordered by (rank, id) like a user-sorted list
+class ItemModel : public SqlListModel<Item>
+{
+public:
+    enum { NameRole = Qt::UserRole + 1, RankRole };
+
+    explicit ItemModel(DbmPtr db)
+        : SqlListModel(db, "items", {
+              bindRole<&Item::name>(NameRole, "name"),
+              bindRole<&Item::rank>(RankRole, "rank")
+          })
+    {
+    }
+
+    using SqlListModel::setRows;
+
+    QList<int> ids() const
+    {
+        QList<int> result;
+        for (const auto& row : rows())
+            result << row.id;
+        return result;
+    }
+
+    int refreshes = 0;
+
+protected:
+    void refresh() override
+    {
+        ++refreshes;
+        setRows(db_->selectRows<Item, int, QString, int>("SELECT id, name, rank FROM items ORDER BY rank, id"));
+    }
+
+    std::optional<Item> fetchRow(int id) override
+    {
+        const auto found = db_->selectRows<Item, int, QString, int>(
+            "SELECT id, name, rank FROM items WHERE id = ?", {id});
+        if (found.isEmpty())
+            return std::nullopt;
+        return found.first();
+    }
+
+    bool lessThan(const Item& a, const Item& b) const override
+    {
+        return std::make_pair(a.rank, a.id) < std::make_pair(b.rank, b.id);
+    }
+};
+
+DbmPtr openItems(const QString& name)
+{
+    auto db = std::make_shared<DatabaseManager>(name);
+    db->connect(":memory:");
+    db->exec("CREATE TABLE items (id INTEGER PRIMARY KEY, name TEXT, rank INTEGER)");
+    return db;
+}
+
+QList<Item> items(const QList<int>& ids)
+{
+    QList<Item> result;
+    for (int i = 0; i < ids.size(); ++i)
+        result.append({ids[i], QString("item %1").arg(ids[i]), i});
+    return result;
+}
+
+}
+
+TEST(SqlListModel, KeyedDiff) {
+    ItemModel model(openItems("diffRows"));
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::Fatal);
+
+    QSignalSpy reset(&model, &QAbstractItemModel::modelReset);
+    QSignalSpy removed(&model, &QAbstractItemModel::rowsRemoved);
+    QSignalSpy moved(&model, &QAbstractItemModel::rowsMoved);
+    QSignalSpy inserted(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy changed(&model, &QAbstractItemModel::dataChanged);
+
+    model.setRows(items({1, 2, 3, 4, 5}));
+    ASSERT_EQ(reset.count(), 1);
+    ASSERT_EQ(model.rowCount(), 5);
+
+    reset.clear();
+
+    // drop 1, move 5 to the front (new rank), rename 3, add 6
+    QList<Item> next = items({5, 2, 3, 4, 6});
+    next[2].name = "renamed";
+    model.setRows(next);
+
+    ASSERT_EQ(reset.count(), 0);
+    ASSERT_EQ(removed.count(), 1);
+    ASSERT_EQ(moved.count(), 1);
+    ASSERT_EQ(inserted.count(), 1);
+    ASSERT_EQ(model.ids(), QList<int>({5, 2, 3, 4, 6}));
+    ASSERT_EQ(model.data(model.index(2, 0), ItemModel::NameRole).toString(), "renamed");
+
+    // only the rows whose values differ are reported, with the roles that changed
+    ASSERT_EQ(changed.count(), 2);
+    ASSERT_EQ(changed.at(0).at(0).value<QModelIndex>().row(), 0);
+    ASSERT_EQ(changed.at(0).at(2).value<QList<int>>(), QList<int>({ItemModel::RankRole}));
+    ASSERT_EQ(changed.at(1).at(0).value<QModelIndex>().row(), 2);
+    ASSERT_EQ(changed.at(1).at(2).value<QList<int>>(), QList<int>({ItemModel::NameRole}));
+
+    // nothing in common: one reset instead of per-row signals
+    model.setRows(items({7, 8}));
+    ASSERT_EQ(reset.count(), 1);
+    ASSERT_EQ(model.ids(), QList<int>({7, 8}));
+}
+
+TEST(SqlListModel, RandomDiffs) {
+    ItemModel model(openItems("randomRows"));
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::Fatal);
+    QRandomGenerator rng(7);
+
+    QList<int> ids = {1, 2, 3};
+    model.setRows(items(ids));
+    int nextId = 4;
+    for (int round = 0; round < 200; ++round) {
+        // keep most rows, shuffle a few and add some new ones
+        QList<int> fresh;
+        for (int id : ids)
+            if (rng.bounded(10) > 1)
+                fresh << id;
+        for (int i = 0; i < rng.bounded(4); ++i)
+            fresh.insert(rng.bounded(fresh.size() + 1), nextId++);
+        for (int i = 0; i < rng.bounded(3) && fresh.size() > 1; ++i)
+            fresh.swapItemsAt(rng.bounded(fresh.size()), rng.bounded(fresh.size()));
+        if (fresh.isEmpty())
+            fresh << nextId++;
+
+        model.setRows(items(fresh));
+        ASSERT_EQ(model.ids(), fresh);
+        ids = fresh;
+    }
+}
+
+TEST(SqlListModel, ChangeFeed) {
+    auto db = openItems("feedRows");
+    ItemModel model(db);
+    QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::Fatal);
+
+    const qint64 a = db->insertRow("items", {"name", "rank"}, {"a", 10});
+    const qint64 b = db->insertRow("items", {"name", "rank"}, {"b", 20});
+    const qint64 c = db->insertRow("items", {"name", "rank"}, {"c", 15});
+    ASSERT_EQ(model.ids(), QList<int>({int(a), int(c), int(b)}));
+
+    QSignalSpy moved(&model, &QAbstractItemModel::rowsMoved);
+    ASSERT_TRUE(db->updateRow("items", a, {"rank"}, {30}));
+    ASSERT_EQ(moved.count(), 1);
+    ASSERT_EQ(model.ids(), QList<int>({int(c), int(b), int(a)}));
+
+    ASSERT_TRUE(db->deleteByIds("items", {int(b)}));
+    ASSERT_EQ(model.ids(), QList<int>({int(c), int(a)}));
+
+    // unknown rows trigger a refresh
+    ASSERT_TRUE(db->insertBatch("items", {"name", "rank"}, {{"d", 0}, {"e", 40}}));
+    ASSERT_EQ(model.refreshes, 1);
+    ASSERT_EQ(model.rowCount(), 4);
+    ASSERT_EQ(model.data(model.index(0, 0), ItemModel::NameRole).toString(), "d");
+}
+
+
+// Custom main that initializes Qt before running tests
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
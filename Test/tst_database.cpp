@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <QCoreApplication>
 #include "../Backend/database.h"
+#include "../Backend/migrations.h"
+#include "../Backend/searchmodel.h"
 #include <QDebug>
 
 
@@ -61,6 +63,394 @@ WHERE
     ASSERT_EQ(response, 17);
 }
 
+TEST(DatabaseManager, ForEachRowTest) {
+    DatabaseManager db("typedRows");
+    ASSERT_TRUE(db.connect(":memory:"));
+    ASSERT_TRUE(db.initializeDatabase());
+
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(db.exec("INSERT INTO tasks (title, timestamp, pending, project_id) VALUES (?, ?, 1, 7)",
+                            {QString("task %1").arg(i), QString("2025-01-0%1T10:00:00.000").arg(i + 1)}));
+    }
+
+    QList<int> ids;
+    QStringList titles;
+    QList<QDateTime> times;
+    ASSERT_TRUE((db.forEachRow<int, QString, QDateTime>(
+        "SELECT id, title, timestamp FROM tasks WHERE project_id = ? ORDER BY id", {7},
+        [&](int id, const QString& title, const QDateTime& time) {
+            ids << id;
+            titles << title;
+            times << time;
+        })));
+
+    ASSERT_EQ(ids.size(), 3);
+    ASSERT_EQ(titles.at(2), "task 2");
+    ASSERT_EQ(times.at(0).date(), QDate(2025, 1, 1));
+
+    struct Task { int id; QString title; };
+    auto rows = db.selectRows<Task, int, QString>("SELECT id, title FROM tasks WHERE project_id = ?", {7});
+    ASSERT_EQ(rows.size(), 3);
+    ASSERT_EQ(db.selectValue<int>("SELECT COUNT(*) FROM tasks"), 3);
+    ASSERT_EQ(db.selectValue<int>("SELECT id FROM tasks WHERE project_id = ?", {99}, -1), -1);
+}
+
+TEST(DatabaseManager, StatementCacheReentrancyTest) {
+    DatabaseManager db("reentrantRows");
+    ASSERT_TRUE(db.connect(":memory:"));
+    ASSERT_TRUE(db.initializeDatabase());
+    db.setStatementCacheCapacity(2);
+    for (int i = 0; i < 3; ++i)
+        ASSERT_TRUE(db.exec("INSERT INTO tasks (title, pending, project_id) VALUES (?, 1, 1)", {QString("t%1").arg(i)}));
+
+    const QString sql = "SELECT id FROM tasks WHERE project_id = ? ORDER BY id";
+    QList<int> outer;
+    int inner = 0;
+    ASSERT_TRUE(db.forEachRow<int>(sql, {1}, [&](int id) {
+        outer << id;
+        // the same statement again, then enough others to evict the running one
+        db.forEachRow<int>(sql, {1}, [&](int) { ++inner; });
+        for (int i = 0; i < 4; ++i)
+            db.selectValue<int>(QString("SELECT %1").arg(i));
+    }));
+    ASSERT_EQ(outer.size(), 3);
+    ASSERT_EQ(inner, 9);
+    ASSERT_LE(db.statementCacheSize(), 2);
+}
+
+TEST(DatabaseManager, AsyncQueryTest) {
+    QString dbPath = QDir::temp().filePath("rm_async_test.db");
+    QFile::remove(dbPath);
+
+    DatabaseManager db("asyncRows", dbPath);
+    ASSERT_TRUE(db.initializeDatabase());
+    ASSERT_TRUE(db.exec("INSERT INTO links (url, website, project_id) VALUES (?, ?, ?)",
+                        {"https://example.org", "Example", 3}));
+
+    db.enableAsync();
+    ASSERT_TRUE(db.isAsync());
+
+    auto inserted = db.execAsync("INSERT INTO links (url, website, project_id) VALUES (?, ?, ?)",
+                                 {"https://qt.io", "Qt", 3});
+    ASSERT_TRUE(inserted.result());
+
+    struct Link { int id; QString website; };
+    auto rows = db.selectRowsAsync<Link, int, QString>(
+        "SELECT id, website FROM links WHERE project_id = ? ORDER BY id", {3}).result();
+    ASSERT_EQ(rows.size(), 2);
+    ASSERT_EQ(rows.at(1).website, "Qt");
+
+    auto raw = db.queryAsync("SELECT COUNT(*) FROM links").result();
+    ASSERT_EQ(raw.size(), 1);
+    ASSERT_EQ(raw.at(0).at(0).toInt(), 2);
+}
+
+TEST(DatabaseManager, ReaderPoolTest) {
+    QString dbPath = QDir::temp().filePath("rm_wal_test.db");
+    QFile::remove(dbPath);
+
+    DatabaseManager db("walWriter");
+    db.setStorageProfile(StorageProfile::Concurrent, 2000);
+    ASSERT_TRUE(db.connect(dbPath));
+    ASSERT_TRUE(db.initializeDatabase());
+    ASSERT_EQ(db.selectValue<QString>("PRAGMA journal_mode"), "wal");
+
+    auto reader = db.readerForCurrentThread();
+    ASSERT_TRUE(reader != nullptr);
+    ASSERT_TRUE(reader->isReadOnly());
+    ASSERT_EQ(reader, db.readerForCurrentThread());
+
+    // an open write transaction does not block the reader under WAL
+    ASSERT_TRUE(db.database().transaction());
+    ASSERT_TRUE(db.exec("INSERT INTO tasks (title, pending, project_id) VALUES ('t', 1, 1)"));
+    ASSERT_EQ(reader->selectValue<int>("SELECT COUNT(*) FROM tasks"), 0);
+    ASSERT_TRUE(db.database().commit());
+    ASSERT_EQ(reader->selectValue<int>("SELECT COUNT(*) FROM tasks"), 1);
+
+    // readers on other threads get their own connection, released when the thread ends
+    int otherCount = -1;
+    QThread* thread = QThread::create([&]() {
+        auto own = db.readerForCurrentThread();
+        otherCount = own ? own->selectValue<int>("SELECT COUNT(*) FROM tasks") : -1;
+    });
+    thread->start();
+    thread->wait();
+    delete thread;
+    ASSERT_EQ(otherCount, 1);
+    ASSERT_EQ(db.readerCount(), 1);
+
+    // writes are refused on a reader
+    ASSERT_FALSE(reader->exec("DELETE FROM tasks"));
+}
+
+TEST(DatabaseManager, TransactionAndBatchTest) {
+    DatabaseManager db("batchRows");
+    ASSERT_TRUE(db.connect(":memory:"));
+    ASSERT_TRUE(db.initializeDatabase());
+
+    QList<QVariantList> rows;
+    for (int i = 0; i < 300; ++i)
+        rows.append({QString("2025-03-%1").arg(i % 28 + 1, 2, 10, QChar('0')), QString("event %1").arg(i), 1});
+    ASSERT_TRUE(db.insertBatch("calendars", {"timestamp", "event", "project_id"}, rows));
+    ASSERT_EQ(db.selectValue<int>("SELECT COUNT(*) FROM calendars"), 300);
+
+    QList<int> ids;
+    db.forEachRow<int>("SELECT id FROM calendars WHERE id % 2 = 0", {}, [&](int id) { ids << id; });
+    ASSERT_TRUE(db.deleteByIds("calendars", ids));
+    ASSERT_EQ(db.selectValue<int>("SELECT COUNT(*) FROM calendars"), 150);
+
+    {
+        DatabaseManager::Transaction outer(db);
+        ASSERT_TRUE(db.exec("DELETE FROM calendars"));
+        {
+            DatabaseManager::Transaction inner(db);
+            ASSERT_TRUE(db.exec("INSERT INTO calendars (timestamp, event, project_id) VALUES ('2025-01-01', 'x', 1)"));
+            // inner scope rolls back on destruction
+        }
+        ASSERT_EQ(db.selectValue<int>("SELECT COUNT(*) FROM calendars"), 0);
+        // outer scope rolls back too
+    }
+    ASSERT_EQ(db.selectValue<int>("SELECT COUNT(*) FROM calendars"), 150);
+}
+
+TEST(DatabaseManager, FailedCommitTest) {
+    DatabaseManager db("failedCommitRows");
+    ASSERT_TRUE(db.connect(":memory:"));
+    // a deferred foreign key makes COMMIT itself fail and leaves the transaction open
+    ASSERT_TRUE(db.exec("PRAGMA foreign_keys = ON"));
+    ASSERT_TRUE(db.exec("CREATE TABLE parent (id INTEGER PRIMARY KEY)"));
+    ASSERT_TRUE(db.exec("CREATE TABLE child (id INTEGER PRIMARY KEY, parent_id INTEGER "
+                        "REFERENCES parent(id) DEFERRABLE INITIALLY DEFERRED)"));
+
+    {
+        DatabaseManager::Transaction transaction(db);
+        ASSERT_TRUE(db.exec("INSERT INTO child (parent_id) VALUES (42)"));
+        ASSERT_FALSE(transaction.commit());
+    }
+    ASSERT_EQ(db.selectValue<int>("SELECT COUNT(*) FROM child"), 0);
+
+    // the connection can begin the next transaction
+    DatabaseManager::Transaction next(db);
+    ASSERT_TRUE(next.isActive());
+    ASSERT_TRUE(db.exec("INSERT INTO parent (id) VALUES (42)"));
+    ASSERT_TRUE(db.exec("INSERT INTO child (parent_id) VALUES (42)"));
+    ASSERT_TRUE(next.commit());
+    ASSERT_EQ(db.selectValue<int>("SELECT COUNT(*) FROM child"), 1);
+}
+
+TEST(DatabaseManager, MigrationTest) {
+    DatabaseManager db("migrateRows");
+    ASSERT_TRUE(db.connect(":memory:"));
+    ASSERT_EQ(db.schemaVersion(), 0);
+
+    const auto steps = migrations::research();
+    ASSERT_TRUE(db.migrate(steps));
+    ASSERT_EQ(db.schemaVersion(), steps.last().version);
+    ASSERT_EQ(db.selectValue<int>(
+        "SELECT COUNT(*) FROM sqlite_master WHERE type = 'index' AND name = 'idx_tasks_project_timestamp'"), 1);
+
+    // already up to date, nothing runs again
+    ASSERT_TRUE(db.migrate(steps));
+
+    // a failing step leaves the version at the last completed one
+    QList<Migration> broken = steps;
+    broken.append({steps.last().version + 1, "broken", [](DatabaseManager& dbm) {
+        dbm.exec("CREATE TABLE scratch (id INTEGER)");
+        return dbm.exec("SELECT * FROM no_such_table");
+    }});
+    ASSERT_FALSE(db.migrate(broken));
+    ASSERT_EQ(db.schemaVersion(), steps.last().version);
+    ASSERT_EQ(db.selectValue<int>("SELECT COUNT(*) FROM sqlite_master WHERE name = 'scratch'"), 0);
+}
+
+TEST(DatabaseManager, SortKeyMigrationTest) {
+    DatabaseManager db("sortKeyRows");
+    ASSERT_TRUE(db.connect(":memory:"));
+
+    // a database from before sort keys, with a duplicated timestamp
+    const auto steps = migrations::research();
+    ASSERT_TRUE(db.migrate(steps.mid(0, 3)));
+    const QStringList stamps = {"2025-01-01T09:00:00", "2025-01-03T09:00:00", "2025-01-02T09:00:00",
+                                "2025-01-02T09:00:00"};
+    for (int i = 0; i < stamps.size(); ++i)
+        ASSERT_TRUE(db.exec("INSERT INTO tasks (title, timestamp, pending, project_id) VALUES (?, ?, 1, ?)",
+                            {QString("t%1").arg(i), stamps[i], i == 0 ? 2 : 1}));
+
+    ASSERT_TRUE(db.migrate(steps));
+    ASSERT_EQ(db.selectValue<int>("SELECT COUNT(*) FROM tasks WHERE sort_key IS NULL"), 0);
+
+    struct Row { QString title; QString key; };
+    const auto rows = db.selectRows<Row, QString, QString>(
+        "SELECT title, sort_key FROM tasks WHERE project_id = 1 ORDER BY sort_key", {});
+    ASSERT_EQ(rows.size(), 3);
+    ASSERT_EQ(rows[0].title, "t1");
+    ASSERT_EQ(rows[1].title, "t2");
+    ASSERT_EQ(rows[2].title, "t3");
+    // keys restart per project and are strictly increasing
+    ASSERT_LT(rows[0].key, rows[1].key);
+    ASSERT_LT(rows[1].key, rows[2].key);
+    ASSERT_EQ(db.selectValue<QString>("SELECT sort_key FROM tasks WHERE project_id = 2"), rows[0].key);
+}
+
+TEST(DatabaseManager, SqlStatsTest) {
+    DatabaseManager db("statsRows");
+    ASSERT_TRUE(db.connect(":memory:"));
+    ASSERT_TRUE(db.initializeDatabase());
+    db.stats().reset();
+
+    for (int i = 0; i < 10; ++i)
+        db.exec("INSERT INTO tasks (title, timestamp, project_id) VALUES (?, ?, ?)",
+                {QString("task %1").arg(i), "2025-01-01 10:00:00", 1});
+    db.queryRow("SELECT title FROM tasks WHERE project_id = 1");
+    db.queryRow("SELECT title FROM tasks WHERE project_id = 2");
+
+    // literals are normalized, both SELECTs share one entry
+    ASSERT_EQ(SqlStats::normalize("SELECT  title FROM tasks\n WHERE project_id = 7 AND title = 'a'"),
+              "SELECT title FROM tasks WHERE project_id = ? AND title = ?");
+    const auto select = db.stats().entry("SELECT title FROM tasks WHERE project_id = 3");
+    ASSERT_EQ(select.count, 2);
+    ASSERT_EQ(select.rows, 10);
+    ASSERT_LE(select.minUs, select.maxUs);
+    ASSERT_LE(select.p95Us(), select.maxUs);
+
+    const auto insert = db.stats().entry("INSERT INTO tasks (title, timestamp, project_id) VALUES (?, ?, ?)");
+    ASSERT_EQ(insert.count, 10);
+
+    // every statement is slow with a zero threshold and carries its plan
+    db.stats().setSlowThresholdMs(0);
+    db.selectValue<int>("SELECT COUNT(*) FROM tasks WHERE project_id = ?", {1});
+    const auto slow = db.stats().slowQueries();
+    ASSERT_FALSE(slow.isEmpty());
+    ASSERT_FALSE(slow.last().plan.isEmpty());
+
+    const QJsonObject json = db.stats().toJson();
+    ASSERT_TRUE(json.contains("statements"));
+    ASSERT_TRUE(json.contains("slow_queries"));
+
+    // disabled stats record nothing
+    db.stats().reset();
+    db.stats().setEnabled(false);
+    db.queryRow("SELECT title FROM tasks WHERE project_id = 1");
+    ASSERT_TRUE(db.stats().entries().isEmpty());
+    ASSERT_TRUE(db.stats().slowQueries().isEmpty());
+}
+
+TEST(DatabaseManager, ChangeFeedTest) {
+    DatabaseManager db("changeRows");
+    ASSERT_TRUE(db.connect(":memory:"));
+    ASSERT_TRUE(db.initializeDatabase());
+
+    QList<ChangeEvent> events;
+    const int all = db.subscribe("", [&](const ChangeEvent& e) { events << e; });
+    int linkEvents = 0;
+    const int links = db.subscribe("links", [&](const ChangeEvent&) { ++linkEvents; });
+
+    const qint64 id = db.insertRow("tasks", {"title", "timestamp", "project_id"}, {"a", "2025-01-01", 1});
+    ASSERT_GT(id, 0);
+    ASSERT_EQ(events.size(), 1);
+    ASSERT_EQ(events.last().table, "tasks");
+    ASSERT_EQ(events.last().rowid, id);
+    ASSERT_EQ(events.last().op, ChangeOp::Insert);
+
+    ASSERT_TRUE(db.updateRow("tasks", id, {"title"}, {"b"}));
+    ASSERT_EQ(events.last().op, ChangeOp::Update);
+    ASSERT_EQ(db.selectValue<QString>("SELECT title FROM tasks WHERE id = ?", {id}), "b");
+
+    // held back until commit, dropped on rollback
+    {
+        DatabaseManager::Transaction transaction(db);
+        db.insertRow("tasks", {"title", "timestamp", "project_id"}, {"c", "2025-01-02", 1});
+        ASSERT_EQ(events.size(), 2);
+    }
+    ASSERT_EQ(events.size(), 2);
+    {
+        DatabaseManager::Transaction transaction(db);
+        db.insertRow("tasks", {"title", "timestamp", "project_id"}, {"d", "2025-01-03", 1});
+        {
+            DatabaseManager::Transaction inner(db);
+            db.insertRow("tasks", {"title", "timestamp", "project_id"}, {"e", "2025-01-04", 1});
+        }
+        ASSERT_TRUE(transaction.commit());
+    }
+    ASSERT_EQ(events.size(), 3);
+
+    ASSERT_TRUE(db.deleteByIds("tasks", {int(id)}));
+    ASSERT_EQ(events.last().op, ChangeOp::Delete);
+    ASSERT_EQ(events.last().rowid, id);
+
+    ASSERT_TRUE(db.insertBatch("links", {"url", "project_id"}, {{"https://a", 1}, {"https://b", 1}}));
+    ASSERT_EQ(events.last().rowid, -1);
+    ASSERT_EQ(linkEvents, 1);
+
+    db.unsubscribe(all);
+    db.unsubscribe(links);
+    db.insertRow("links", {"url", "project_id"}, {"https://c", 1});
+    ASSERT_EQ(linkEvents, 1);
+}
+
+TEST(DatabaseManager, FullTextSearchTest) {
+    DatabaseManager db("ftsRows");
+    ASSERT_TRUE(db.connect(":memory:"));
+    ASSERT_TRUE(db.migrate(migrations::research()));
+
+    db.insertRow("projects", {"id", "name"}, {1, "robotics"});
+    const qint64 task = db.insertRow("tasks", {"title", "description", "timestamp", "project_id"},
+                                     {"Calibrate lidar", "mount the sensor", "2025-01-01", 1});
+    db.insertRow("links", {"url", "website", "project_id"}, {"https://lidar.example.org", "lidar docs", 1});
+    db.insertRow("calendars", {"timestamp", "event", "project_id"}, {"2025-03-01", "Sensor review", 1});
+
+    auto search = [&](const QString& text) {
+        const QString match = homepage::SearchModel::matchExpression(text);
+        return db.queryRows(homepage::SearchModel::searchSql(), {match, match, match, match, 50, 0});
+    };
+
+    auto hits = search("lidar");
+    ASSERT_EQ(hits.size(), 2);
+    ASSERT_EQ(hits.first().at(3).toString(), "robotics");
+
+    // prefix matching and quoting of FTS operators
+    ASSERT_EQ(search("sens").size(), 2);
+    ASSERT_EQ(search("sensor AND").size(), 0);
+    ASSERT_EQ(homepage::SearchModel::matchExpression("  a-b \"c\" "), "\"a\"* \"b\"* \"c\"*");
+
+    // triggers keep the index in step with the content tables
+    ASSERT_TRUE(db.updateRow("tasks", task, {"title"}, {"Calibrate camera"}));
+    ASSERT_EQ(search("camera").size(), 1);
+    ASSERT_TRUE(db.deleteByIds("tasks", {int(task)}));
+    ASSERT_EQ(search("camera").size(), 0);
+    ASSERT_EQ(search("lidar").size(), 1);
+}
+
+TEST(DatabaseManager, SearchWithoutFullTextIndexTest) {
+    DatabaseManager db("likeRows");
+    ASSERT_TRUE(db.connect(":memory:"));
+    // a database whose SQLite had no FTS5: migration 3 left no index behind
+    const auto steps = migrations::research();
+    ASSERT_TRUE(db.migrate(steps.mid(0, 2)));
+    ASSERT_TRUE(db.exec("PRAGMA user_version = 3"));
+    ASSERT_TRUE(db.migrate(steps));
+    ASSERT_EQ(db.schemaVersion(), steps.last().version);
+    ASSERT_EQ(db.selectValue<int>("SELECT COUNT(*) FROM sqlite_master WHERE name = 'tasks_fts'"), 0);
+
+    db.insertRow("projects", {"id", "name"}, {1, "robotics"});
+    db.insertRow("tasks", {"title", "description", "timestamp", "project_id", "sort_key"},
+                 {"Calibrate lidar", "100% done", "2025-01-01", 1, "a0"});
+    db.insertRow("links", {"url", "website", "project_id"}, {"https://lidar.example.org", "", 1});
+
+    auto search = [&](const QString& text) {
+        QVariantList params;
+        for (int i = 0; i < 8; ++i)
+            params << homepage::SearchModel::likePattern(text);
+        params << 50 << 0;
+        return db.queryRows(homepage::SearchModel::fallbackSql(), params);
+    };
+    ASSERT_EQ(search("LIDAR").size(), 2);
+    ASSERT_EQ(search("lidar").first().at(3).toString(), "robotics");
+    // wildcards in the text are literal
+    ASSERT_EQ(search("100%").size(), 1);
+    ASSERT_EQ(search("1_0").size(), 0);
+}
+
 // Custom main that initializes Qt before running tests
 int main(int argc, char *argv[])
 {
@@ -0,0 +1,132 @@
+#include "workspace_generator.h"
+#include "../Backend/database.h"
+#include "../Backend/migrations.h"
+#include "../Backend/orderkey.h"
+#include <QDateTime>
+#include <QDebug>
+
+namespace workspace_generator {
+
+namespace {
+
+const QStringList categories = {"Research Projects", "Publications", "Presentations",
+                                "Grants & Funding", "Teaching", "Service"};
+
+const QStringList websites = {"github.com", "arxiv.org", "scholar.google.com",
+                              "ieeexplore.ieee.org", "dl.acm.org", "overleaf.com"};
+
+bool fillResearch(DatabaseManager& db, const Scale& scale)
+{
+    if (!db.migrate(migrations::research()))
+        return false;
+
+    QList<QVariantList> rows;
+    for (int i = 0; i < categories.size(); ++i)
+        rows.append({i + 1, categories[i], 0});
+    if (!db.insertBatch("categories", {"id", "name", "year_id"}, rows))
+        return false;
+
+    rows.clear();
+    for (int p = 1; p <= scale.projects; ++p)
+        rows.append({p, projectName(p), "synthetic project " + projectName(p), (p - 1) % categories.size() + 1});
+    if (!db.insertBatch("projects", {"id", "name", "description", "category_id"}, rows))
+        return false;
+
+    const QDateTime base(QDate(2024, 1, 1), QTime(9, 0));
+    const QDate firstDay(QDate::currentDate().year(), 1, 1);
+    qint64 taskSeq = 0;
+
+    // newest task first, as TaskManger lists tasks added through the UI
+    const QStringList sortKeys = OrderKey::sequence(scale.tasksPerProject);
+
+    for (int p = 1; p <= scale.projects; ++p) {
+        rows.clear();
+        for (int t = 0; t < scale.tasksPerProject; ++t) {
+            const int owner = t % qMax(1, scale.collaboratorsPerProject);
+            // every third task is tagged so MessageViewer has matches
+            const QString title = t % 3 == 0
+                                      ? QString("#c%1 task %2 of %3").arg(owner).arg(t).arg(projectName(p))
+                                      : QString("task %1 of %2").arg(t).arg(projectName(p));
+            rows.append({title, QString("description of %1").arg(title),
+                         base.addSecs(60 * taskSeq++).toString(Qt::ISODateWithMs),
+                         sortKeys.at(scale.tasksPerProject - 1 - t), t % 2 == 0, p});
+        }
+        if (!db.insertBatch("tasks", {"title", "description", "timestamp", "sort_key", "pending", "project_id"}, rows))
+            return false;
+
+        rows.clear();
+        for (int l = 0; l < scale.linksPerProject; ++l) {
+            const QString site = websites[l % websites.size()];
+            rows.append({QString("https://%1/%2/%3").arg(site, projectName(p)).arg(l), site, QString(),
+                         base.addDays(l).toString(Qt::ISODate), p});
+        }
+        if (!db.insertBatch("links", {"url", "website", "description", "timestamp", "project_id"}, rows))
+            return false;
+
+        rows.clear();
+        for (int e = 0; e < scale.eventsPerProject; ++e) {
+            // spread events over the current year so every month has some
+            const QDate day = firstDay.addDays((p * 7 + e * 17) % 365);
+            rows.append({day.toString(Qt::ISODate), QString("event %1 of %2").arg(e).arg(projectName(p)), p});
+        }
+        if (!db.insertBatch("calendars", {"timestamp", "event", "project_id"}, rows))
+            return false;
+
+        rows.clear();
+        for (int c = 0; c < scale.collaboratorsPerProject; ++c)
+            rows.append({collaboratorName(c), QString("#c%1").arg(c), QString(), p});
+        if (!db.insertBatch("collaborators", {"name", "tag_name", "photo", "project_id"}, rows))
+            return false;
+    }
+    return true;
+}
+
+bool fillConfig(DatabaseManager& db, const QString& researchPath)
+{
+    if (!db.migrate(migrations::config()))
+        return false;
+    return db.exec("INSERT INTO Workspace (name, database, year, workspace, icon) VALUES (?, ?, ?, ?, ?)",
+                   {"Synthetic", researchPath, QDate::currentDate().year(), "synthetic", "local-folder.svg"});
+}
+
+}
+
+QJsonObject Scale::toJson() const
+{
+    QJsonObject obj;
+    obj["projects"] = projects;
+    obj["tasks_per_project"] = tasksPerProject;
+    obj["links_per_project"] = linksPerProject;
+    obj["events_per_project"] = eventsPerProject;
+    obj["collaborators_per_project"] = collaboratorsPerProject;
+    return obj;
+}
+
+QString projectName(int index)
+{
+    return QString("project_%1").arg(index, 4, 10, QChar('0'));
+}
+
+QString collaboratorName(int index)
+{
+    return QString("collaborator_%1").arg(index);
+}
+
+bool generate(const QString& researchPath, const QString& configPath, const Scale& scale)
+{
+    bool ok = false;
+    {
+        DatabaseManager research("syntheticResearch");
+        DatabaseManager config("syntheticConfig");
+        ok = research.connect(researchPath) && fillResearch(research, scale)
+             && config.connect(configPath) && fillConfig(config, researchPath);
+    }
+    QSqlDatabase::removeDatabase("syntheticResearch");
+    QSqlDatabase::removeDatabase("syntheticConfig");
+
+    if (!ok)
+        qWarning() << "[workspace_generator] Failed to generate" << researchPath;
+    return ok;
+}
+
+}
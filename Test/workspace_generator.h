@@ -0,0 +1,40 @@
+#ifndef WORKSPACE_GENERATOR_H
+#define WORKSPACE_GENERATOR_H
+
+#include <QString>
+#include <QJsonObject>
+
+/**
+ * @brief Builds a research.db / common_config.db pair filled with synthetic data.
+ *
+ * The data is deterministic for a given Scale so runs of different releases
+ * are comparable. Schemas come from migrations::research() / config(), i.e.
+ * exactly what the application creates.
+ */
+namespace workspace_generator {
+
+struct Scale {
+    int projects = 50;
+    int tasksPerProject = 200;
+    int linksPerProject = 40;
+    int eventsPerProject = 20;
+    int collaboratorsPerProject = 5;
+
+    QJsonObject toJson() const;
+};
+
+/**
+ * @brief Project name used for index i, e.g. "project_0007"
+ */
+QString projectName(int index);
+
+/**
+ * @brief Collaborator name used for index i of a project
+ */
+QString collaboratorName(int index);
+
+bool generate(const QString& researchPath, const QString& configPath, const Scale& scale);
+
+}
+
+#endif // WORKSPACE_GENERATOR_H